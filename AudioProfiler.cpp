@@ -0,0 +1,136 @@
+#include "AudioProfiler.h"
+
+#ifdef __arm__
+#include "daisy_seed.h"
+#else
+#include <chrono>
+#endif
+
+AudioProfiler::AudioProfiler()
+    : ran_(0)
+    , callbackStart_(0)
+    , budgetCycles_(0)
+    , cpuHz_(1000000000)
+    , sampleRate_(48000.0f)
+    , lastPercent_(0)
+    , resetRequested_(false)
+{
+    reset();
+}
+
+void AudioProfiler::init(float sampleRate, uint32_t cpuHz)
+{
+    sampleRate_ = sampleRate;
+
+#ifdef __arm__
+    cpuHz_ = cpuHz;
+
+    // Enable the DWT cycle counter (the H7 needs the lock access register unlocked)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#else
+    // Host builds count nanoseconds
+    (void)cpuHz;
+    cpuHz_ = 1000000000;
+#endif
+
+    reset();
+}
+
+uint32_t AudioProfiler::now()
+{
+#ifdef __arm__
+    return DWT->CYCCNT;
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void AudioProfiler::reset()
+{
+    for (int i = 0; i < NUM_PROFILE_STAGES; i++) {
+        totals_[i].min = UINT32_MAX;
+        totals_[i].max = 0;
+        totals_[i].last = 0;
+        totals_[i].count = 0;
+        totals_[i].sum = 0;
+        accum_[i] = 0;
+    }
+    ran_ = 0;
+    callbacks_ = 0;
+    overruns_ = 0;
+    budgetSum_ = 0;
+    peakPercent_ = 0;
+}
+
+void AudioProfiler::beginCallback()
+{
+    if (resetRequested_) {
+        reset();
+        resetRequested_ = false;
+    }
+    for (int i = 0; i < NUM_PROFILE_STAGES; i++) {
+        accum_[i] = 0;
+    }
+    ran_ = 0;
+    callbackStart_ = now();
+}
+
+void AudioProfiler::endCallback(size_t blockSize)
+{
+    add(STAGE_CALLBACK, callbackStart_);
+
+    // Fold this callback's stage times into the running figures
+    for (int i = 0; i < NUM_PROFILE_STAGES; i++) {
+        if ((ran_ & (1u << i)) == 0) {
+            continue;
+        }
+        Totals& totals = totals_[i];
+        uint32_t cycles = accum_[i];
+        totals.last = cycles;
+        totals.min = (cycles < totals.min) ? cycles : totals.min;
+        totals.max = (cycles > totals.max) ? cycles : totals.max;
+        totals.sum += cycles;
+        totals.count++;
+    }
+
+    // The callback has as long as its block takes to play
+    budgetCycles_ = (uint32_t)((uint64_t)blockSize * cpuHz_ / (uint32_t)sampleRate_);
+    budgetSum_ += budgetCycles_;
+    callbacks_++;
+
+    uint32_t cycles = accum_[STAGE_CALLBACK];
+    if (cycles > budgetCycles_) {
+        overruns_++;
+    }
+    if (budgetCycles_ > 0) {
+        uint32_t percent = (uint32_t)((uint64_t)cycles * 100 / budgetCycles_);
+        peakPercent_ = (percent > peakPercent_) ? percent : peakPercent_;
+        lastPercent_ = percent;
+    }
+}
+
+void AudioProfiler::getStats(ProfileStats& stats) const
+{
+    for (int i = 0; i < NUM_PROFILE_STAGES; i++) {
+        const Totals& totals = totals_[i];
+        StageStats& stage = stats.stages[i];
+        stage.count = totals.count;
+        stage.min = (totals.count > 0) ? totals.min : 0;
+        stage.max = totals.max;
+        stage.last = totals.last;
+        stage.avg = (totals.count > 0) ? (uint32_t)(totals.sum / totals.count) : 0;
+    }
+
+    stats.callbacks = callbacks_;
+    stats.overruns = overruns_;
+    stats.budgetCycles = budgetCycles_;
+    stats.cyclesPerUs = cpuHz_ / 1000000;
+
+    uint64_t load = (budgetSum_ > 0) ? totals_[STAGE_CALLBACK].sum * 100 / budgetSum_ : 0;
+    stats.loadPercent = (uint8_t)((load > 255) ? 255 : load);
+    stats.peakPercent = (uint8_t)((peakPercent_ > 255) ? 255 : peakPercent_);
+}
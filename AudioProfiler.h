@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * ProfileStage - Parts of the audio callback that are timed separately
+ *
+ * Stages nest (the sequencer calls the sample library, which renders the
+ * grains), so each stage's time includes the stages it calls.
+ */
+enum ProfileStage {
+    STAGE_CALLBACK,      // Whole AudioCallback
+    STAGE_SEQUENCER,     // Sequencer::processAudio
+    STAGE_SAMPLES,       // SampleLibrary::processAudio
+    STAGE_GRAINS,        // Spawning and rendering grains
+    STAGE_METRONOME,     // Metronome::process
+    NUM_PROFILE_STAGES
+};
+
+/**
+ * StageStats - Cycles per callback spent in one stage
+ * Only callbacks in which the stage ran are counted.
+ */
+struct StageStats {
+    uint32_t min;
+    uint32_t avg;
+    uint32_t max;
+    uint32_t last;
+    uint32_t count;      // Callbacks that ran this stage
+};
+
+/**
+ * ProfileStats - Snapshot of the profiler, read by the debug screen
+ */
+struct ProfileStats {
+    StageStats stages[NUM_PROFILE_STAGES];
+    uint32_t callbacks;       // Callbacks since the last reset
+    uint32_t overruns;        // Callbacks that took longer than their block lasts
+    uint32_t budgetCycles;    // Cycles available to the last callback
+    uint32_t cyclesPerUs;     // For converting cycles to microseconds
+    uint8_t loadPercent;      // Average callback time / budget
+    uint8_t peakPercent;      // Worst callback time / budget
+};
+
+/**
+ * AudioProfiler - CPU load meter for the audio callback
+ *
+ * Uses the DWT cycle counter on the Daisy and std::chrono on a host build
+ * (where one "cycle" is a nanosecond). Stage times are summed over each
+ * callback (the sequencer renders in several segments), then folded into
+ * min/avg/max when the callback ends.
+ *
+ * begin/end/endCallback run in the audio callback; getStats() and
+ * requestReset() are for the main loop.
+ */
+class AudioProfiler {
+public:
+    AudioProfiler();
+
+    /**
+     * Start the cycle counter
+     *
+     * @param sampleRate Audio sample rate (to work out each block's budget)
+     * @param cpuHz Core clock in Hz (ignored on host builds)
+     */
+    void init(float sampleRate, uint32_t cpuHz);
+
+    // Current cycle count
+    static uint32_t now();
+
+    // Mark the start of a callback
+    void beginCallback();
+
+    // Mark the end of a callback that rendered blockSize samples
+    void endCallback(size_t blockSize);
+
+    // Add the time since start (from now()) to a stage for this callback
+    void add(ProfileStage stage, uint32_t start)
+    {
+        accum_[stage] += now() - start;
+        ran_ |= 1u << stage;
+    }
+
+    // Copy out the current figures
+    void getStats(ProfileStats& stats) const;
+
+    // Time the last callback took, as a percentage of its budget (audio callback)
+    uint32_t getLastLoadPercent() const { return lastPercent_; }
+
+    // Clear min/avg/max and overruns at the start of the next callback
+    void requestReset() { resetRequested_ = true; }
+
+private:
+    struct Totals {
+        uint32_t min;
+        uint32_t max;
+        uint32_t last;
+        uint32_t count;
+        uint64_t sum;
+    };
+
+    Totals totals_[NUM_PROFILE_STAGES];
+    uint32_t accum_[NUM_PROFILE_STAGES];
+    uint32_t ran_;                       // Bit per stage that ran this callback
+    uint32_t callbackStart_;
+    uint32_t callbacks_;
+    uint32_t overruns_;
+    uint32_t budgetCycles_;
+    uint32_t cpuHz_;
+    float sampleRate_;
+    uint64_t budgetSum_;
+    uint32_t peakPercent_;
+    uint32_t lastPercent_;
+    volatile bool resetRequested_;
+
+    void reset();
+};
+
+/**
+ * ScopedProfile - Times the enclosing scope as one stage
+ */
+class ScopedProfile {
+public:
+    ScopedProfile(AudioProfiler& profiler, ProfileStage stage)
+        : profiler_(profiler)
+        , stage_(stage)
+        , start_(AudioProfiler::now())
+    {
+    }
+
+    ~ScopedProfile()
+    {
+        profiler_.add(stage_, start_);
+    }
+
+private:
+    AudioProfiler& profiler_;
+    ProfileStage stage_;
+    uint32_t start_;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <cstdint>  // For uint8_t, uint32_t, size_t
+#include <cstdint>  // For uint8_t, uint32_t
+#include <cstddef>  // For size_t
 
 namespace Constants {
     // Display Constants
@@ -10,12 +11,17 @@ namespace Constants {
         constexpr uint8_t CHAR_WIDTH = 7;
         constexpr uint8_t LINE_HEIGHT = 10;
         constexpr uint8_t MAX_CHARS_PER_LINE = WIDTH / CHAR_WIDTH;  // ~18 chars
-        constexpr uint32_t FPS = 3;
+        constexpr uint32_t FPS = 30;              // Most UI redraws per second (dirty events in between are merged)
+        constexpr uint32_t FRAME_INTERVAL_US = 1000000 / FPS;
+        constexpr int TOAST_QUEUE_SIZE = 4;       // Messages waiting to be shown (the newest replaces the last when full)
+        constexpr int TOAST_MAX_CHARS = 64;       // Longest message kept (including the terminator)
+        constexpr uint8_t PROGRESS_BAR_HEIGHT = 7;
     }
 
     // UI Constants
     namespace UI {
         constexpr uint32_t HOLD_DETECT_MS = 500;
+        constexpr uint32_t CONTROL_POLL_US = 1000;    // Knobs, encoder and buttons are read at 1 kHz
         constexpr float MIN_BPM = 60.0f;
         constexpr float MAX_BPM = 180.0f;
         constexpr float BPM_RANGE = MAX_BPM - MIN_BPM;
@@ -24,6 +30,7 @@ namespace Constants {
     // Memory Constants
     namespace Memory {
         constexpr size_t CUSTOM_POOL_SIZE = 48 * 1024 * 1024;  // 48MB
+        constexpr size_t SAMPLE_CACHE_SIZE = 44 * 1024 * 1024; // 44MB of the pool for paged sample data
     }
 
     // Sequencer Constants
@@ -32,12 +39,50 @@ namespace Constants {
         constexpr int NUM_TRACKS = 3;
         constexpr int MIN_BPM = 60;
         constexpr int MAX_BPM = 180;
+        constexpr int STEPS_PER_BEAT = 4;          // Steps are 16th notes
+        constexpr int MAX_VOICES_PER_TRACK = 4;    // Overlapping hits per track
+        constexpr int DEFAULT_POLYPHONY = 4;       // Voices per track until changed
+        constexpr uint32_t BPM_RESOLUTION = 100;   // Tempo is kept in 1/100 BPM
     }
 
     // Sample Library Constants
     namespace SampleLibrary {
-        constexpr int MAX_SAMPLES = 64;
-        constexpr int MAX_GRAINS = 8;  // Maximum simultaneous grains (reduced for embedded safety)
+        constexpr int MAX_SAMPLES = 256;  // Headers only at boot; audio data is paged in on demand
+        constexpr int MAX_GRAINS = 128;  // Grain store size (see GrainEngine; the live limit is adjustable)
+        constexpr int GRAIN_RELEASE_FRAMES = 96;  // Fade-out of a grain ended early for the CPU budget (2 ms)
+        constexpr bool DECODE_TO_INT16 = false;  // Decode samples to int16 instead of float32 (halves SDRAM use)
+        constexpr uint32_t LEVEL_BLOCK_FRAMES = 1024;  // Frames per entry of a sample's level envelope
+        constexpr bool DECLICK_VOICES = true;  // Short fade in/out on sample and sequencer voices
+        constexpr bool CONVERT_SAMPLE_RATE = true;  // Resample cached files to the output rate at load time
+        constexpr int SRC_CHUNK_FRAMES = 1024;      // Output frames converted per step while loading
+        constexpr int LOAD_CHUNK_FRAMES = 4096;     // Frames decoded per step while loading (no conversion)
+        constexpr uint32_t LOADER_SLICE_US = 2000;  // Loader work per main-loop pass
+        constexpr int MIP_LEVELS = 3;               // Pre-filtered octaves (1/2, 1/4, 1/8 rate) per cached sample
+        constexpr bool MIPMAP_SAMPLES = false;      // Default for building a sample's octaves (1/2 + 1/4 + 1/8: 0.875x more SDRAM)
+        constexpr const char* BANK_FILE = "SAMPLES.BNK";  // Packed kit (tools/bankpack.cpp); loaded instead of the WAVs
+        constexpr int BANK_INDEX_BLOCK = 16;        // Bank index entries read per f_read at boot
+        constexpr const char* INDEX_FILE = "SAMPLES.IDX";  // Cached WAV headers, checked against each file's size and date
+        constexpr uint32_t INTERP_DROP_LOAD_PERCENT = 85;     // Callback load that lowers voice interpolation a tier
+        constexpr uint32_t INTERP_RESTORE_LOAD_PERCENT = 60;  // Load below which a tier is given back...
+        constexpr int INTERP_RESTORE_CALLBACKS = 1000;        // ...after this many calm callbacks in a row
+    }
+
+    // Voice Pool Constants
+    namespace Voices {
+        constexpr int POOL_SIZE = 32;            // Voices shared by sequencer tracks and triggered samples
+        constexpr int DEFAULT_VOICE_LIMIT = 24;  // Voices rendered at once (CPU budget)
+        constexpr int GRAINS_PER_VOICE = 6;      // Grains that cost about one voice (tests/bench_grains)
+        constexpr int STOP_QUEUE_SIZE = 16;      // Pending stop requests from the main loop
+    }
+
+    // SD Card Streaming Constants
+    namespace Streaming {
+        constexpr size_t STREAM_THRESHOLD_BYTES = 4 * 1024 * 1024;  // Samples decoding larger than this stream from SD
+        constexpr int RESIDENT_MS = 500;             // Head of each streamed sample kept in SDRAM
+        constexpr int MAX_STREAM_VOICES = 4;         // Streamed samples playing at once
+        constexpr int RING_FRAMES = 32768;           // Per-voice ring buffer (~680ms at 48kHz)
+        constexpr int REFILL_CHUNK_FRAMES = 2048;    // Frames decoded per refill step
+        constexpr int REFILL_CHUNKS_PER_SERVICE = 4; // Refill steps per voice per main loop pass
     }
 
     // Granular Randomness Constants
@@ -52,4 +97,16 @@ namespace Constants {
         constexpr float SPEED_RANDOM_MAX = 2.0f;           // Max randomness for speed
         constexpr float POSITION_RANDOM_MAX = 0.5f;        // Max randomness for position
     }
+
+    // Live Input Constants
+    namespace LiveInput {
+        constexpr float BUFFER_SECONDS = 5.0f;   // Input history kept for live grains (~1.9MB at 48kHz float)
+        constexpr uint32_t SAFETY_FRAMES = 64;   // Gap grains keep from the write head and the oldest frame
+    }
+
+    // Random Number Constants
+    namespace Random {
+        constexpr uint64_t DEFAULT_SEED = 0x5EED5A3D1E5ULL;  // Boot seed (same sequence every boot)
+        constexpr int BATCH_SIZE = 8;                        // Values pooled per parameter per block
+    }
 }
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "hid/disp/display.h"
+#include "OledPageWriter.h"
+
+using namespace daisy;
+
+/**
+ * DisplayBackend - Where DisplayManager draws, and how a finished frame leaves
+ *
+ * DisplayManager (and through it every menu) only draws on canvas() with
+ * libDaisy's 1-bit graphics calls and hands frames to present(), so the
+ * same UI code runs against:
+ * - OledDisplayBackend (PagedOledDisplay.h): the Pod's OLED
+ * - FramebufferBackend (FramebufferBackend.h): memory only, for host-side
+ *   snapshots and render timing
+ *
+ * Only libDaisy's header-only graphics and its fonts are needed to build
+ * against this interface.
+ */
+class DisplayBackend {
+public:
+    virtual ~DisplayBackend() {}
+
+    // Drawing surface
+    virtual OneBitGraphicsDisplay& canvas() = 0;
+
+    // Show what has been drawn (may return before it is visible)
+    virtual void present() = 0;
+
+    // Keep a frame in flight moving (main loop)
+    virtual void service() {}
+
+    // Wait until the last presented frame is visible
+    virtual void flush() {}
+
+    // Wire cost of the last frames (all zero without a bus)
+    virtual OledFrameStats getFrameStats() const { return OledFrameStats(); }
+
+    // Hold a message on screen (blocking messages only)
+    virtual void delayMs(uint32_t ms) = 0;
+};
@@ -1,36 +1,169 @@
 #include "DisplayManager.h"
 #include <cstdarg>  // For va_list, va_start, va_end
+#include <cstdio>   // For vsnprintf
+#include <cstring>
 #include "Constants.h"
 
 /**
- * Constructor - Initialize references to display and hardware
+ * Constructor - Initialize references to the backend and its drawing surface
  * 
- * Note: We use member initializer lists (display_(display), hw_(hw))
+ * Note: We use member initializer lists (backend_(backend), display_(...))
  * which is the preferred way to initialize reference members in C++.
  * References cannot be assigned after construction, so they MUST be
  * initialized in the initializer list.
  */
-DisplayManager::DisplayManager(MyOledDisplay& display, DaisyPod& hw)
-    : display_(display), hw_(hw) {
-    // Nothing else to initialize - references are set above
+DisplayManager::DisplayManager(DisplayBackend& backend)
+    : backend_(backend), display_(backend.canvas()),
+      toastHead_(0), toastCount_(0), toastShowing_(false), toastStart_(0),
+      progressVisible_(false), progressPercent_(0), overlayChanged_(false) {
+    progressLabel_[0] = '\0';
 }
 
 /**
- * Display a message with a delay
+ * Queue a message
  *
- * This is the function you originally had in SimpleSampler.cpp.
- * Now it's encapsulated in the DisplayManager class.
+ * Messages are shown one after another, each for its own duration, by
+ * serviceOverlay(). Nothing here waits, so callers in the main loop (the
+ * sample loader, menus) never hold up the encoder and buttons.
+ *
+ * @param message The text to display (use "*" for manual line breaks)
+ * @param durationMs How long to show the message (in milliseconds)
+ */
+void DisplayManager::showMessage(const char* message, uint32_t durationMs) {
+    // When the queue is full the newest message replaces the last one waiting
+    int slot;
+    if (toastCount_ < Constants::Display::TOAST_QUEUE_SIZE) {
+        slot = (toastHead_ + toastCount_) % Constants::Display::TOAST_QUEUE_SIZE;
+        toastCount_++;
+    } else {
+        slot = (toastHead_ + toastCount_ - 1) % Constants::Display::TOAST_QUEUE_SIZE;
+        if (toastShowing_ && toastCount_ == 1) {
+            // Replacing the toast on screen: serviceOverlay() starts it afresh
+            toastShowing_ = false;
+            overlayChanged_ = true;
+        }
+    }
+    strncpy(toasts_[slot].text, message, sizeof(toasts_[slot].text) - 1);
+    toasts_[slot].text[sizeof(toasts_[slot].text) - 1] = '\0';
+    toasts_[slot].durationMs = durationMs;
+}
+
+/**
+ * Draw a message immediately and wait
+ *
+ * The old blocking behaviour, kept for boot (before the main loop draws
+ * anything) and for fatal errors just before halting.
+ *
+ * @param message The text to display
+ * @param delayMs How long to wait afterwards (in milliseconds)
+ */
+void DisplayManager::showMessageBlocking(const char* message, uint32_t delayMs) {
+    display_.Fill(false);
+    drawMessage(message);
+    backend_.present();
+    backend_.flush();
+    if (delayMs > 0) {
+        backend_.delayMs(delayMs);
+    }
+}
+
+/**
+ * Show or update the progress bar
+ *
+ * Only marks the overlay changed when what it would draw changes, so a
+ * caller can refresh it every main-loop pass.
+ *
+ * @param label Text above the bar (nullptr for none)
+ * @param percent 0 - 100, or -1 when the amount of work is unknown
+ */
+void DisplayManager::showProgress(const char* label, int percent) {
+    if (percent > 100) {
+        percent = 100;
+    }
+    if (percent < -1) {
+        percent = -1;
+    }
+    const char* text = (label != nullptr) ? label : "";
+    if (progressVisible_ && percent == progressPercent_ && strncmp(text, progressLabel_, sizeof(progressLabel_) - 1) == 0) {
+        return;
+    }
+    progressVisible_ = true;
+    progressPercent_ = percent;
+    strncpy(progressLabel_, text, sizeof(progressLabel_) - 1);
+    progressLabel_[sizeof(progressLabel_) - 1] = '\0';
+    overlayChanged_ = true;
+}
+
+/**
+ * Remove the progress bar
+ */
+void DisplayManager::hideProgress() {
+    if (progressVisible_) {
+        progressVisible_ = false;
+        overlayChanged_ = true;
+    }
+}
+
+/**
+ * Advance the toast queue
+ *
+ * Starts the next toast when none is showing and drops the current one
+ * once its time is up. Call once per main-loop pass.
+ *
+ * @param now Current time in milliseconds
+ * @return true if the screen should be redrawn (a toast came or went, or the progress bar changed)
+ */
+bool DisplayManager::serviceOverlay(uint32_t now) {
+    if (toastShowing_ && now - toastStart_ >= toasts_[toastHead_].durationMs) {
+        toastShowing_ = false;
+        toastHead_ = (toastHead_ + 1) % Constants::Display::TOAST_QUEUE_SIZE;
+        toastCount_--;
+        overlayChanged_ = true;
+    }
+    if (!toastShowing_ && toastCount_ > 0) {
+        toastShowing_ = true;
+        toastStart_ = now;
+        overlayChanged_ = true;
+    }
+    
+    bool changed = overlayChanged_;
+    overlayChanged_ = false;
+    return changed;
+}
+
+/**
+ * Draw a progress bar: an outline filled from the left
+ *
+ * @param x Left edge
+ * @param y Top edge
+ * @param width Width in pixels (including the outline)
+ * @param height Height in pixels (including the outline)
+ * @param percent 0 - 100 fills the bar; -1 leaves it empty
+ */
+void DisplayManager::drawProgressBar(uint8_t x, uint8_t y, uint8_t width, uint8_t height, int percent) {
+    if (width < 3 || height < 3) {
+        return;
+    }
+    display_.DrawRect(x, y, x + width - 1, y + height - 1, true, false);
+    if (percent > 0) {
+        int inner = width - 4;
+        int filled = (percent >= 100) ? inner : inner * percent / 100;
+        if (filled > 0) {
+            display_.DrawRect(x + 2, y + 2, x + 1 + filled, y + height - 3, true, true);
+        }
+    }
+}
+
+/**
+ * Draw text with line wrapping
  *
  * Supports automatic line wrapping and manual line breaks using "*":
  * - Automatic: wraps to next line when text exceeds screen width (128px)
  * - Manual: use "*" character to force a new line
  *
- * @param message The text to display
- * @param delayMs How long to show the message (in milliseconds)
+ * @param message The text to draw, starting at the top-left corner
  */
-void DisplayManager::showMessage(const char* message, uint32_t delayMs) {
-    display_.Fill(false);                      // Clear the screen (black)
-    
+void DisplayManager::drawMessage(const char* message) {
     uint8_t cursorX = 0;                       // Current X position
     uint8_t cursorY = 0;                       // Current Y position
     uint8_t charsOnLine = 0;                   // Characters written on current line
@@ -80,9 +213,30 @@ void DisplayManager::showMessage(const char* message, uint32_t delayMs) {
         cursorX += Constants::Display::CHAR_WIDTH;
         charsOnLine++;
     }
-    
-    display_.Update();                          // Send to OLED
-    hw_.DelayMs(delayMs);                       // Wait for specified time
+}
+
+/**
+ * Draw the overlay on top of the frame
+ *
+ * The current toast takes the whole screen (as messages always have); the
+ * progress bar sits along the bottom edge with its label just above it.
+ */
+void DisplayManager::drawOverlay() {
+    if (toastShowing_) {
+        display_.Fill(false);
+        drawMessage(toasts_[toastHead_].text);
+    }
+    if (progressVisible_) {
+        const uint8_t barHeight = Constants::Display::PROGRESS_BAR_HEIGHT;
+        const uint8_t barY = Constants::Display::HEIGHT - barHeight;
+        const uint8_t labelY = barY - 9;
+        display_.DrawRect(0, labelY - 1, Constants::Display::WIDTH - 1, Constants::Display::HEIGHT - 1, false, true);
+        if (progressLabel_[0] != '\0') {
+            display_.SetCursor(0, labelY);
+            display_.WriteString(progressLabel_, Font_6x8, true);
+        }
+        drawProgressBar(0, barY, Constants::Display::WIDTH, barHeight, progressPercent_);
+    }
 }
 
 /**
@@ -90,7 +244,8 @@ void DisplayManager::showMessage(const char* message, uint32_t delayMs) {
  * Call this after any drawing operations to make them visible
  */
 void DisplayManager::update() {
-    display_.Update();
+    drawOverlay();
+    backend_.present();
 }
 
 /**
@@ -121,7 +276,7 @@ void DisplayManager::writeString(const char* text, FontDef font, bool on) {
 }
 
 /**
- * Display a formatted message with a delay (printf-style)
+ * Queue a formatted message (printf-style)
  *
  * This function allows you to display multiple variables using format specifiers.
  * Common format specifiers:
@@ -133,15 +288,15 @@ void DisplayManager::writeString(const char* text, FontDef font, bool on) {
  *   %x - hexadecimal
  *
  * @param format Printf-style format string (use "*" for manual line breaks)
- * @param delayMs How long to show the message (in milliseconds)
+ * @param durationMs How long to show the message (in milliseconds)
  * @param ... Variable arguments matching format specifiers
  */
-void DisplayManager::showMessagef(const char* format, uint32_t delayMs, ...) {
+void DisplayManager::showMessagef(const char* format, uint32_t durationMs, ...) {
     char buffer[256];  // Buffer to hold the formatted string
     
     // Use va_list to handle variable arguments
     va_list args;
-    va_start(args, delayMs);
+    va_start(args, durationMs);
     
     // Format the string into the buffer
     vsnprintf(buffer, sizeof(buffer), format, args);
@@ -150,5 +305,5 @@ void DisplayManager::showMessagef(const char* format, uint32_t delayMs, ...) {
     va_end(args);
     
     // Call the regular showMessage with the formatted string
-    showMessage(buffer, delayMs);
+    showMessage(buffer, durationMs);
 }
@@ -1,53 +1,101 @@
 #pragma once
 
-#include "daisy_pod.h"
-#include "dev/oled_ssd130x.h"
+#include "DisplayBackend.h"
+#include "Constants.h"
 
 using namespace daisy;
 
-// Forward declaration of the display type
-using MyOledDisplay = OledDisplay<SSD130x4WireSpi128x64Driver>;
-
 /**
  * DisplayManager - Handles all OLED display operations
  * 
  * This class encapsulates display functionality, making it easy to share
  * across different parts of the application while maintaining clean
  * separation of concerns.
+ *
+ * Messages never block: showMessage() queues a toast, and serviceOverlay()
+ * (called by UIManager::update) shows each one for its duration. The current
+ * toast and the progress bar are drawn over whatever was rendered when
+ * update() sends the frame to the OLED.
+ *
+ * All drawing goes through a DisplayBackend, so nothing here depends on the
+ * Pod: the firmware uses the OLED, host-side tests a FramebufferBackend.
  */
 class DisplayManager {
 public:
     /**
-     * Constructor - Takes references to the display and hardware objects
+     * Constructor - Takes the backend to draw on
      * 
-     * @param display Reference to the OLED display object
-     * @param hw Reference to the DaisyPod hardware object (needed for delays)
+     * @param backend The OLED (OledDisplayBackend), or memory (FramebufferBackend) on the host
      */
-    DisplayManager(MyOledDisplay& display, DaisyPod& hw);
+    explicit DisplayManager(DisplayBackend& backend);
 
     /**
-     * Display a message on the OLED screen with a delay
+     * Queue a message to show full screen for a while (returns immediately)
      *
-     * @param message The text message to display
-     * @param delayMs How long to display the message in milliseconds
+     * @param message The text message to display ("*" starts a new line)
+     * @param durationMs How long to display the message in milliseconds
      */
-    void showMessage(const char* message, uint32_t delayMs);
+    void showMessage(const char* message, uint32_t durationMs);
 
     /**
-     * Display a formatted message on the OLED screen with a delay
+     * Queue a formatted message (returns immediately)
      * Works like printf - supports format specifiers (e.g., %s, %d, %f)
      *
      * @param format Printf-style format string (e.g., "Value: %d*Name: %s")
-     * @param delayMs How long to display the message in milliseconds
+     * @param durationMs How long to display the message in milliseconds
      * @param ... Variable arguments for format string
      */
-    void showMessagef(const char* format, uint32_t delayMs, ...);
+    void showMessagef(const char* format, uint32_t durationMs, ...);
+
+    /**
+     * Draw a message straight away and wait
+     * Only for before the main loop runs (or before halting), where nothing else
+     * would draw the toast queue
+     */
+    void showMessageBlocking(const char* message, uint32_t delayMs);
+
+    /**
+     * Show a progress bar along the bottom of the screen until hideProgress()
+     *
+     * @param label Short text above the bar (nullptr for none)
+     * @param percent 0 - 100, or -1 when the amount of work is unknown
+     */
+    void showProgress(const char* label, int percent);
+    void hideProgress();
+
+    /**
+     * Start, expire and advance toasts (main loop; never sleeps)
+     *
+     * @param now Current time in milliseconds
+     * @return true when the overlay changed and the screen should be redrawn
+     */
+    bool serviceOverlay(uint32_t now);
+
+    // Is a toast showing right now?
+    bool isShowingMessage() const { return toastShowing_; }
+
+    /**
+     * Draw a progress bar widget
+     *
+     * @param percent 0 - 100 fills the bar; -1 draws it empty
+     */
+    void drawProgressBar(uint8_t x, uint8_t y, uint8_t width, uint8_t height, int percent);
 
     /**
      * Update the display (call this after any drawing operations)
+     * Draws the current toast and progress bar on top first, then starts
+     * sending the changed pages and returns
      */
     void update();
 
+    /**
+     * Keep the frame transfer going (call every main-loop pass)
+     */
+    void serviceTransfer() { backend_.service(); }
+
+    // Bytes and time of the last frames on the SPI bus (for the debug screen)
+    OledFrameStats getFrameStats() const { return backend_.getFrameStats(); }
+
     /**
      * Clear the display
      * @param fill Whether to fill with white (true) or black (false)
@@ -73,9 +121,34 @@ public:
      * Get direct access to the display object for advanced operations
      * @return Reference to the underlying display
      */
-    MyOledDisplay& getDisplay() { return display_; }
+    OneBitGraphicsDisplay& getDisplay() { return display_; }
 
 private:
-    MyOledDisplay& display_;  // Reference to the OLED display
-    DaisyPod& hw_;             // Reference to hardware (for delays)
+    DisplayBackend& backend_;          // Where frames go
+    OneBitGraphicsDisplay& display_;   // The backend's drawing surface
+
+    struct Toast {
+        char text[Constants::Display::TOAST_MAX_CHARS];
+        uint32_t durationMs;
+    };
+
+    // Toasts waiting to be shown; toasts_[toastHead_] is the current one while toastShowing_
+    Toast toasts_[Constants::Display::TOAST_QUEUE_SIZE];
+    int toastHead_;
+    int toastCount_;
+    bool toastShowing_;
+    uint32_t toastStart_;       // When the current toast appeared
+
+    // Progress bar
+    bool progressVisible_;
+    int progressPercent_;
+    char progressLabel_[Constants::Display::MAX_CHARS_PER_LINE + 1];
+
+    bool overlayChanged_;       // Reported by the next serviceOverlay()
+
+    // Draw text from the top-left, wrapping at the screen edge and at "*"
+    void drawMessage(const char* message);
+
+    // Draw the current toast and progress bar over the frame
+    void drawOverlay();
 };
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "b3ReadWavFile.h"
+#include "daisy_seed.h"
+
+/**
+ * FatFileDataSource - b3DataSource backed by an open FatFS file
+ *
+ * Lets b3ReadWavFile parse headers and decode audio straight from the
+ * SD card, without first copying the raw file into SDRAM.
+ * The caller owns the FIL and is responsible for opening/closing it.
+ */
+struct FatFileDataSource : public b3DataSource
+{
+    explicit FatFileDataSource(FIL* file)
+        : file_(file)
+    {
+    }
+
+    FIL* file_;
+
+    virtual long ftell()
+    {
+        return (long)f_tell(file_);
+    }
+
+    virtual size_t fread(void* buffer, size_t elementSize, size_t elementCount)
+    {
+        UINT bytesRead = 0;
+        if (f_read(file_, buffer, elementSize * elementCount, &bytesRead) != FR_OK) {
+            return 0;
+        }
+        return bytesRead / elementSize;
+    }
+
+    virtual int fseek(long offset, int origin)
+    {
+        long target = offset;
+        if (origin == B3_SEEK_CUR) {
+            target += (long)f_tell(file_);
+        } else if (origin != B3_SEEK_SET) {
+            return -1;
+        }
+
+        // Match MemoryDataSource: seeking outside the file is an error
+        if (target < 0 || target >= (long)f_size(file_)) {
+            return -1;
+        }
+        return (f_lseek(file_, (FSIZE_t)target) == FR_OK) ? 0 : -1;
+    }
+};
@@ -0,0 +1,82 @@
+#include "FramebufferBackend.h"
+#include <cstdio>
+#include <cstring>
+
+FramebufferCanvas::FramebufferCanvas() {
+    memset(pixels_, 0, sizeof(pixels_));
+}
+
+void FramebufferCanvas::Fill(bool on) {
+    memset(pixels_, on ? 0xFF : 0x00, sizeof(pixels_));
+}
+
+void FramebufferCanvas::DrawPixel(uint_fast8_t x, uint_fast8_t y, bool on) {
+    if (x >= WIDTH || y >= HEIGHT) {
+        return;
+    }
+    uint8_t& cell = pixels_[x + (y >> 3) * WIDTH];
+    uint8_t bit = (uint8_t)(1 << (y & 7));
+    if (on) {
+        cell |= bit;
+    } else {
+        cell &= (uint8_t)~bit;
+    }
+}
+
+bool FramebufferCanvas::getPixel(int x, int y) const {
+    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+        return false;
+    }
+    return (pixels_[x + (y >> 3) * WIDTH] >> (y & 7)) & 1;
+}
+
+FramebufferBackend::FramebufferBackend()
+    : frames_(0) {
+    memset(presented_, 0, sizeof(presented_));
+}
+
+void FramebufferBackend::present() {
+    memcpy(presented_, canvas_.data(), sizeof(presented_));
+    frames_++;
+}
+
+bool FramebufferBackend::getPixel(int x, int y) const {
+    if (x < 0 || x >= FramebufferCanvas::WIDTH || y < 0 || y >= FramebufferCanvas::HEIGHT) {
+        return false;
+    }
+    return (presented_[x + (y >> 3) * FramebufferCanvas::WIDTH] >> (y & 7)) & 1;
+}
+
+size_t FramebufferBackend::encodePbm(uint8_t* out, size_t capacity) const {
+    if (capacity < PBM_SIZE) {
+        return 0;
+    }
+    // (the terminator lands on the first pixel byte, which is written below)
+    snprintf((char*)out, PBM_HEADER_SIZE + 1, "P4\n%d %d\n", FramebufferCanvas::WIDTH, FramebufferCanvas::HEIGHT);
+
+    // PBM rows are left to right, most significant bit first, 1 = black
+    uint8_t* row = out + PBM_HEADER_SIZE;
+    for (int y = 0; y < FramebufferCanvas::HEIGHT; y++) {
+        for (int x = 0; x < FramebufferCanvas::WIDTH; x += 8) {
+            uint8_t bits = 0;
+            for (int i = 0; i < 8; i++) {
+                if (!getPixel(x + i, y)) {
+                    bits |= (uint8_t)(0x80 >> i);
+                }
+            }
+            *row++ = bits;
+        }
+    }
+    return PBM_SIZE;
+}
+
+bool FramebufferBackend::savePbm(const char* path) const {
+    uint8_t pbm[PBM_SIZE];
+    size_t size = encodePbm(pbm, sizeof(pbm));
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(pbm, 1, size, file) == size;
+    return (fclose(file) == 0) && ok;
+}
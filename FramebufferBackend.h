@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "DisplayBackend.h"
+#include "Constants.h"
+
+/**
+ * FramebufferCanvas - 128x64 1-bit drawing surface in memory
+ *
+ * Same byte layout as the SSD130x (one byte is 8 vertical pixels of a page).
+ */
+class FramebufferCanvas : public OneBitGraphicsDisplayImpl<FramebufferCanvas> {
+public:
+    static constexpr int WIDTH = Constants::Display::WIDTH;
+    static constexpr int HEIGHT = Constants::Display::HEIGHT;
+    static constexpr size_t BUFFER_SIZE = WIDTH * HEIGHT / 8;
+
+    FramebufferCanvas();
+
+    uint16_t Height() const override { return HEIGHT; }
+    uint16_t Width() const override { return WIDTH; }
+
+    void Fill(bool on) override;
+    void DrawPixel(uint_fast8_t x, uint_fast8_t y, bool on) override;
+    void Update() override {}
+
+    bool getPixel(int x, int y) const;
+    const uint8_t* data() const { return pixels_; }
+
+private:
+    uint8_t pixels_[BUFFER_SIZE];
+};
+
+/**
+ * FramebufferBackend - Display backend that only draws into memory
+ *
+ * For running DisplayManager and the menus off-device: present() takes a
+ * snapshot of the canvas (the frame as the panel would show it), which can
+ * be compared against a golden image or saved as a binary PBM. Lit pixels
+ * are white in the PBM, as on the OLED; convert to PNG with any netpbm tool
+ * (e.g. pnmtopng). delayMs() returns at once so tests never sleep.
+ *
+ * Not part of the firmware build.
+ */
+class FramebufferBackend : public DisplayBackend {
+public:
+    // "P4\n128 64\n" followed by the rows, 8 pixels per byte
+    static constexpr size_t PBM_HEADER_SIZE = 10;
+    static constexpr size_t PBM_SIZE = PBM_HEADER_SIZE + FramebufferCanvas::BUFFER_SIZE;
+
+    FramebufferBackend();
+
+    OneBitGraphicsDisplay& canvas() override { return canvas_; }
+    void present() override;
+    void delayMs(uint32_t ms) override {}
+
+    // Pixel of the last presented frame
+    bool getPixel(int x, int y) const;
+
+    // Frames presented so far
+    uint32_t getFrameCount() const { return frames_; }
+
+    /**
+     * Encode the last presented frame as a binary PBM
+     *
+     * @return Bytes written (PBM_SIZE), or 0 if out is too small
+     */
+    size_t encodePbm(uint8_t* out, size_t capacity) const;
+
+    // Write the last presented frame to a PBM file (host only)
+    bool savePbm(const char* path) const;
+
+private:
+    FramebufferCanvas canvas_;
+    uint8_t presented_[FramebufferCanvas::BUFFER_SIZE];
+    uint32_t frames_;
+};
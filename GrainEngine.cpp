@@ -0,0 +1,322 @@
+#include "GrainEngine.h"
+#include "b3ReadWavFile.h"
+
+#include <cmath>
+
+// Scale from the decoded sample type to [-1, 1)
+template <typename SampleT>
+static inline float grainSampleScale()
+{
+    return 1.0f;
+}
+
+template <>
+inline float grainSampleScale<short>()
+{
+    return 1.0f / 32768.0f;
+}
+
+GrainEngine::GrainEngine()
+    : activeCount_(0)
+    , freeCount_(0)
+    , pendingCount_(0)
+    , releasingCount_(0)
+    , grainLimit_(MAX_GRAINS)
+    , budget_(MAX_GRAINS)
+    , shedCount_(0)
+    , format_(B3_DECODED_FLOAT32)
+    , clearRequested_(false)
+{
+    clear();
+}
+
+void GrainEngine::init(int format)
+{
+    format_ = format;
+    clear();
+}
+
+void GrainEngine::clear()
+{
+    for (int i = 0; i < MAX_GRAINS; i++) {
+        sampleIndex_[i] = -1;
+        remaining_[i] = 0;
+        releasing_[i] = false;
+        free_[i] = MAX_GRAINS - 1 - i;
+    }
+    freeCount_ = MAX_GRAINS;
+    activeCount_ = 0;
+    pendingCount_ = 0;
+    releasingCount_ = 0;
+}
+
+void GrainEngine::setGrainLimit(int limit)
+{
+    if (limit < 1) {
+        limit = 1;
+    } else if (limit > MAX_GRAINS) {
+        limit = MAX_GRAINS;
+    }
+    grainLimit_ = limit;
+}
+
+void GrainEngine::setBudget(int grains)
+{
+    budget_ = (grains > 0) ? grains : 0;
+    if (getActiveCount() - releasingCount_ > budget_) {
+        shed(budget_);
+    }
+}
+
+void GrainEngine::shed(int count)
+{
+    // Grains that have not made a sound yet go first
+    while (pendingCount_ > 0 && getActiveCount() - releasingCount_ > count) {
+        int slot = pending_[--pendingCount_];
+        sampleIndex_[slot] = -1;
+        free_[freeCount_++] = slot;
+        shedCount_++;
+    }
+
+    // Then the live grains nearest their end fade out (they finish within
+    // GRAIN_RELEASE_FRAMES and free their slots in render())
+    while (activeCount_ - releasingCount_ > count) {
+        int shortest = -1;
+        for (int i = 0; i < activeCount_; i++) {
+            int slot = active_[i];
+            if (!releasing_[slot] && (shortest < 0 || remaining_[slot] < remaining_[active_[shortest]])) {
+                shortest = i;
+            }
+        }
+        release(active_[shortest]);
+        shedCount_++;
+    }
+}
+
+void GrainEngine::release(int slot)
+{
+    const uint32_t frames = Constants::SampleLibrary::GRAIN_RELEASE_FRAMES;
+    releasing_[slot] = true;
+    releasingCount_++;
+    if (remaining_[slot] <= frames) {
+        return;   // Its own window ends it as soon
+    }
+
+    // Enter the linear release ramp at the level the window has reached, so
+    // the gain falls from there to zero with no step
+    float level = GrainWindow::read(window_[slot], winPhase_[slot]);
+    uint32_t phase = (uint32_t)((1.0f - level) * 4294967040.0f);
+    window_[slot] = GrainWindow::getReleaseTable();
+    winPhase_[slot] = phase;
+    winStep_[slot] = (0xFFFFFFFFu - phase) / (frames - 1);
+    remaining_[slot] = frames;
+}
+
+bool GrainEngine::isPlaying(int sampleIndex) const
+{
+    for (int i = 0; i < MAX_GRAINS; i++) {
+        if (sampleIndex_[i] == sampleIndex) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GrainEngine::spawn(int sampleIndex, const void* frames, int channels, uint32_t wrapFrames,
+                        double startFrame, double endFrame, double step, int window, int offset)
+{
+    if (getActiveCount() >= grainLimit_ || getActiveCount() >= budget_ || freeCount_ == 0 ||
+        frames == nullptr || step <= 0.0) {
+        return false;
+    }
+
+    // Output frames whose read position stays at or before endFrame
+    double length = endFrame - startFrame;
+    if (length < 0.0) {
+        return false;
+    }
+    uint32_t count = (uint32_t)floor(length / step) + 1;
+
+    int slot = free_[--freeCount_];
+    frames_[slot] = frames;
+    index_[slot] = (uint32_t)startFrame;
+    wrap_[slot] = (wrapFrames > 0) ? wrapFrames : UINT32_MAX;
+    frac_[slot] = (float)(startFrame - (double)index_[slot]);
+    step_[slot] = (float)step;
+    window_[slot] = GrainWindow::getTable(window);
+    winPhase_[slot] = 0;
+    winStep_[slot] = GrainWindow::phaseIncrement(count);
+    remaining_[slot] = count;
+    stride_[slot] = (uint8_t)channels;
+    sampleIndex_[slot] = (int16_t)sampleIndex;
+
+    pending_[pendingCount_] = slot;
+    pendingOffset_[pendingCount_] = (offset > 0) ? offset : 0;
+    pendingCount_++;
+    return true;
+}
+
+// Mix Group grains for count frames. Each grain's state is loaded into locals
+// for the loop and the per-grain inner loop has a constant trip count, so the
+// compiler unrolls it and keeps everything in registers. Mono grains read the
+// same sample for both channels (right offset 0), so mono and stereo share a path.
+template <typename SampleT, int Group>
+void GrainEngine::renderGroup(const int* slots, float gain, float* out0, float* out1, int count)
+{
+    const SampleT* frames[Group];
+    uint32_t index[Group];
+    uint32_t wrap[Group];
+    float frac[Group];
+    float step[Group];
+    const float* window[Group];
+    uint32_t winPhase[Group];
+    uint32_t winStep[Group];
+    uint32_t stride[Group];
+    uint32_t right[Group];
+
+    for (int g = 0; g < Group; g++) {
+        int slot = slots[g];
+        frames[g] = (const SampleT*)frames_[slot];
+        index[g] = index_[slot];
+        wrap[g] = wrap_[slot];
+        frac[g] = frac_[slot];
+        step[g] = step_[slot];
+        window[g] = window_[slot];
+        winPhase[g] = winPhase_[slot];
+        winStep[g] = winStep_[slot];
+        stride[g] = stride_[slot];
+        right[g] = stride_[slot] - 1;
+    }
+
+    const float scale = gain * grainSampleScale<SampleT>();
+    for (int i = 0; i < count; i++) {
+        float acc0 = 0.0f;
+        float acc1 = 0.0f;
+        for (int g = 0; g < Group; g++) {
+            float envelope = GrainWindow::read(window[g], winPhase[g]);
+
+            // Linear interpolation between this frame and the next
+            const SampleT* buf = frames[g] + index[g] * stride[g];
+            float left = (float)buf[0];
+            left += frac[g] * ((float)buf[stride[g]] - left);
+            float rightSample = (float)buf[right[g]];
+            rightSample += frac[g] * ((float)buf[stride[g] + right[g]] - rightSample);
+
+            acc0 += left * envelope;
+            acc1 += rightSample * envelope;
+
+            // Advance: carry whole frames out of the fraction, wrapping circular sources
+            frac[g] += step[g];
+            uint32_t carry = (uint32_t)frac[g];
+            index[g] += carry;
+            frac[g] -= (float)carry;
+            if (index[g] >= wrap[g]) {
+                index[g] -= wrap[g];
+            }
+            winPhase[g] += winStep[g];
+        }
+        out0[i] += acc0 * scale;
+        out1[i] += acc1 * scale;
+    }
+
+    for (int g = 0; g < Group; g++) {
+        int slot = slots[g];
+        index_[slot] = index[g];
+        frac_[slot] = frac[g];
+        winPhase_[slot] = winPhase[g];
+        remaining_[slot] -= count;
+    }
+}
+
+template <typename SampleT>
+void GrainEngine::renderAll(float gain, float* out0, float* out1, int size)
+{
+    int i = 0;
+
+    // Full groups: mix together for as long as every grain in the group lasts,
+    // then finish any longer ones on their own
+    for (; i + GROUP_SIZE <= activeCount_; i += GROUP_SIZE) {
+        const int* slots = &active_[i];
+        int common = size;
+        for (int g = 0; g < GROUP_SIZE; g++) {
+            if (remaining_[slots[g]] < (uint32_t)common) {
+                common = (int)remaining_[slots[g]];
+            }
+        }
+        renderGroup<SampleT, GROUP_SIZE>(slots, gain, out0, out1, common);
+
+        if (common < size) {
+            for (int g = 0; g < GROUP_SIZE; g++) {
+                uint32_t left = remaining_[slots[g]];
+                int count = (left < (uint32_t)(size - common)) ? (int)left : size - common;
+                if (count > 0) {
+                    renderGroup<SampleT, 1>(&slots[g], gain, out0 + common, out1 + common, count);
+                }
+            }
+        }
+    }
+
+    // Leftover grains one at a time
+    for (; i < activeCount_; i++) {
+        uint32_t left = remaining_[active_[i]];
+        int count = (left < (uint32_t)size) ? (int)left : size;
+        renderGroup<SampleT, 1>(&active_[i], gain, out0, out1, count);
+    }
+}
+
+// Start the grains spawned for this block at their offsets, then hand them
+// to the live list so later blocks render them in groups. A grain due past
+// the end of this block stays pending with its offset moved on by one block.
+template <typename SampleT>
+void GrainEngine::renderPending(float gain, float* out0, float* out1, int size)
+{
+    int waiting = 0;
+    for (int i = 0; i < pendingCount_; i++) {
+        int slot = pending_[i];
+        int offset = pendingOffset_[i];
+        if (offset >= size) {
+            pending_[waiting] = slot;
+            pendingOffset_[waiting] = offset - size;
+            waiting++;
+            continue;
+        }
+        uint32_t left = remaining_[slot];
+        int count = (left < (uint32_t)(size - offset)) ? (int)left : size - offset;
+        renderGroup<SampleT, 1>(&slot, gain, out0 + offset, out1 + offset, count);
+        active_[activeCount_++] = slot;
+    }
+    pendingCount_ = waiting;
+}
+
+void GrainEngine::render(float gain, float* out0, float* out1, int size)
+{
+    if (clearRequested_) {
+        clear();
+        clearRequested_ = false;
+        return;
+    }
+
+    if (format_ == B3_DECODED_INT16) {
+        renderAll<short>(gain, out0, out1, size);
+        renderPending<short>(gain, out0, out1, size);
+    } else {
+        renderAll<float>(gain, out0, out1, size);
+        renderPending<float>(gain, out0, out1, size);
+    }
+
+    // Retire finished grains (swap-remove keeps the active list dense)
+    for (int i = 0; i < activeCount_; ) {
+        int slot = active_[i];
+        if (remaining_[slot] == 0) {
+            if (releasing_[slot]) {
+                releasing_[slot] = false;
+                releasingCount_--;
+            }
+            sampleIndex_[slot] = -1;
+            free_[freeCount_++] = slot;
+            active_[i] = active_[--activeCount_];
+        } else {
+            i++;
+        }
+    }
+}
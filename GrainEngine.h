@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include "Constants.h"
+#include "GrainWindow.h"
+
+/**
+ * GrainEngine - Structure-of-arrays grain store and mixing kernel
+ *
+ * Each grain is a handful of numbers (read position, step, window phase,
+ * frames left) kept in parallel arrays, with no per-grain ticker object.
+ * Live grains are kept in a dense list. The kernel renders them GROUP_SIZE
+ * at a time: for every output frame it interpolates, windows and sums a
+ * group of grains in registers, then writes out[0]/out[1] once. The work per
+ * grain is then mostly arithmetic rather than buffer traffic.
+ *
+ * The read position is split into an integer frame and a float fraction,
+ * so long samples keep full sub-frame precision.
+ *
+ * A grain may read a circular buffer (the live input): its read frame then
+ * wraps back to 0 at wrapFrames, and the buffer must mirror its first frame
+ * after the end for interpolation.
+ *
+ * A grain spawned for the coming block may start at any frame offset in it.
+ * Such grains wait in a short pending list; render() mixes the live grains,
+ * then renders each pending one from its offset and moves it to the live list.
+ * An offset past the end of the block carries over to the next one.
+ *
+ * Grains rank below every pool voice: the owner sets a budget each block
+ * from what the voices leave (setBudget). Grains over it are dropped if they
+ * have not started yet; live ones (closest to their end first) fade out from
+ * their current level over GRAIN_RELEASE_FRAMES instead of being cut.
+ *
+ * Spawning and rendering happen in the audio callback. The main loop may
+ * read isPlaying() and call requestClear().
+ */
+class GrainEngine {
+public:
+    static constexpr int MAX_GRAINS = Constants::SampleLibrary::MAX_GRAINS;
+    static constexpr int GROUP_SIZE = 4;   // Grains mixed together per output frame
+
+    GrainEngine();
+
+    /**
+     * Set the decoded sample format grains read (B3_DECODED_FLOAT32 / B3_DECODED_INT16)
+     */
+    void init(int format);
+
+    /**
+     * Start a grain (audio callback)
+     *
+     * @param sampleIndex Sample the grain reads (for isPlaying())
+     * @param frames Decoded interleaved frames, with a guard frame after the end
+     * @param channels 1 or 2
+     * @param wrapFrames Length of a circular source (0 = linear sample)
+     * @param startFrame First read position (frames); below wrapFrames for a circular source
+     * @param endFrame Last read position (frames), unwrapped; must leave one frame for interpolation
+     * @param step Read frames advanced per output frame
+     * @param window Envelope shape (GrainWindowType)
+     * @param offset Output frames from the start of the next render() block to the grain's first frame
+     * @return false if the grain limit is reached or the grain is empty
+     */
+    bool spawn(int sampleIndex, const void* frames, int channels, uint32_t wrapFrames,
+               double startFrame, double endFrame, double step, int window, int offset = 0);
+
+    /**
+     * Mix every live grain into out0/out1 (audio callback)
+     *
+     * @param gain Gain shared by all grains
+     */
+    void render(float gain, float* out0, float* out1, int size);
+
+    // Stop every grain at the start of the next render()
+    void requestClear() { clearRequested_ = true; }
+
+    // Is any grain reading this sample? (safe from the main loop)
+    bool isPlaying(int sampleIndex) const;
+
+    // Live grains, including ones waiting to start in the next block
+    int getActiveCount() const { return activeCount_ + pendingCount_; }
+
+    // Cap on grains playing at once (CPU budget), clamped to 1 - MAX_GRAINS
+    void setGrainLimit(int limit);
+    int getGrainLimit() const { return grainLimit_; }
+
+    // Grains the voices leave room for (audio callback); releases any over
+    // it, and spawn() stops at it
+    void setBudget(int grains);
+    int getBudget() const { return budget_; }
+
+    // Grains dropped or released early to stay within the budget (for debugging)
+    uint32_t getShedCount() const { return shedCount_; }
+
+private:
+    // Hot per-grain state, one entry per slot
+    const void* frames_[MAX_GRAINS];
+    uint32_t index_[MAX_GRAINS];         // Integer read frame
+    uint32_t wrap_[MAX_GRAINS];          // Read frame wraps to 0 here (UINT32_MAX = never)
+    float frac_[MAX_GRAINS];             // Fractional read position (0 - 1)
+    float step_[MAX_GRAINS];             // Frames per output frame
+    const float* window_[MAX_GRAINS];    // Envelope table (GrainWindow)
+    uint32_t winPhase_[MAX_GRAINS];      // Position in the envelope table
+    uint32_t winStep_[MAX_GRAINS];       // Envelope phase per output frame
+    uint32_t remaining_[MAX_GRAINS];     // Output frames left
+    uint8_t stride_[MAX_GRAINS];         // Samples per frame
+    volatile int16_t sampleIndex_[MAX_GRAINS];  // -1 = slot free
+    bool releasing_[MAX_GRAINS];         // Fading out after shed()
+
+    // Live slots (dense) and free slots (stack)
+    int active_[MAX_GRAINS];
+    int activeCount_;
+    int free_[MAX_GRAINS];
+    int freeCount_;
+
+    // Grains spawned for the next block, with their start offsets
+    int pending_[MAX_GRAINS];
+    int pendingOffset_[MAX_GRAINS];
+    int pendingCount_;
+
+    int releasingCount_;
+    int grainLimit_;
+    int budget_;
+    uint32_t shedCount_;
+    int format_;
+    volatile bool clearRequested_;
+
+    void clear();
+
+    // Drop or release grains until at most count are left playing on
+    void shed(int count);
+
+    // Fade a live grain out from its current envelope level
+    void release(int slot);
+
+    template <typename SampleT>
+    void renderAll(float gain, float* out0, float* out1, int size);
+
+    template <typename SampleT>
+    void renderPending(float gain, float* out0, float* out1, int size);
+
+    template <typename SampleT, int Group>
+    void renderGroup(const int* slots, float gain, float* out0, float* out1, int count);
+};
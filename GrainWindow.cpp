@@ -0,0 +1,94 @@
+#include "GrainWindow.h"
+
+#include <cmath>
+
+namespace GrainWindow {
+
+// Tukey taper fraction (0 = rectangle, 1 = Hann)
+static constexpr float TUKEY_ALPHA = 0.5f;
+
+// Gaussian width, relative to half the grain
+static constexpr float GAUSSIAN_SIGMA = 0.4f;
+
+// Trapezoid ramp length, as a fraction of the grain
+static constexpr float TRAPEZOID_RAMP = 0.25f;
+
+static const float PI = 3.14159265358979f;
+
+static float tables[NUM_GRAIN_WINDOWS][TABLE_SIZE];
+static float releaseTable[TABLE_SIZE];
+static bool initialized = false;
+
+static const char* const NAMES[NUM_GRAIN_WINDOWS] = {
+    "Hann", "Tukey", "Gauss", "Trapez", "Tri"
+};
+
+// Window value at x (0 - 1 across the grain)
+static float evaluate(int type, float x)
+{
+    switch (type) {
+        case WINDOW_TUKEY: {
+            float edge = TUKEY_ALPHA * 0.5f;
+            float d = (x < 0.5f) ? x : 1.0f - x;
+            if (d >= edge) {
+                return 1.0f;
+            }
+            return 0.5f - 0.5f * cosf(PI * d / edge);
+        }
+        case WINDOW_GAUSSIAN: {
+            // Subtract the edge value and rescale so the window reaches zero
+            float u = (x - 0.5f) / (0.5f * GAUSSIAN_SIGMA);
+            float edge = expf(-0.5f / (GAUSSIAN_SIGMA * GAUSSIAN_SIGMA));
+            return (expf(-0.5f * u * u) - edge) / (1.0f - edge);
+        }
+        case WINDOW_TRAPEZOID: {
+            float d = (x < 0.5f) ? x : 1.0f - x;
+            return (d >= TRAPEZOID_RAMP) ? 1.0f : d / TRAPEZOID_RAMP;
+        }
+        case WINDOW_TRIANGLE:
+            return 1.0f - fabsf(2.0f * x - 1.0f);
+        case WINDOW_HANN:
+        default:
+            return 0.5f - 0.5f * cosf(2.0f * PI * x);
+    }
+}
+
+void init()
+{
+    if (initialized) {
+        return;
+    }
+    for (int type = 0; type < NUM_GRAIN_WINDOWS; type++) {
+        for (int i = 0; i < TABLE_SIZE; i++) {
+            float value = evaluate(type, (float)i / (float)(TABLE_SIZE - 1));
+            tables[type][i] = (value > 0.0f) ? value : 0.0f;
+        }
+    }
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        releaseTable[i] = 1.0f - (float)i / (float)(TABLE_SIZE - 1);
+    }
+    initialized = true;
+}
+
+const float* getTable(int type)
+{
+    if (type < 0 || type >= NUM_GRAIN_WINDOWS) {
+        type = WINDOW_HANN;
+    }
+    return tables[type];
+}
+
+const float* getReleaseTable()
+{
+    return releaseTable;
+}
+
+const char* getName(int type)
+{
+    if (type < 0 || type >= NUM_GRAIN_WINDOWS) {
+        return "?";
+    }
+    return NAMES[type];
+}
+
+} // namespace GrainWindow
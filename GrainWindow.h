@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Grain window shapes
+ */
+enum GrainWindowType {
+    WINDOW_HANN,        // Raised cosine, smooth and general purpose
+    WINDOW_TUKEY,       // Flat top with cosine tapers (half the grain)
+    WINDOW_GAUSSIAN,    // Bell curve pulled to zero at the edges
+    WINDOW_TRAPEZOID,   // Flat top with linear ramps (quarter of the grain each)
+    WINDOW_TRIANGLE,    // Linear up and down
+    NUM_GRAIN_WINDOWS
+};
+
+/**
+ * GrainWindow - Precomputed grain envelopes
+ *
+ * Every window is sampled once at boot into a TABLE_SIZE entry table peaking
+ * at 1.0. A grain then walks its table with a 32-bit phase accumulator that
+ * goes from 0 at its first frame to the top of the range at its last frame,
+ * so the envelope costs one shift and one load per frame.
+ */
+namespace GrainWindow {
+
+constexpr int TABLE_BITS = 10;
+constexpr int TABLE_SIZE = 1 << TABLE_BITS;
+
+// Fill the tables (call once before rendering grains)
+void init();
+
+// Table for a window type (falls back to Hann for out-of-range types)
+const float* getTable(int type);
+
+// Linear ramp from 1 down to 0, for fading a grain out early
+const float* getReleaseTable();
+
+// Short display name ("Hann", "Tukey", ...)
+const char* getName(int type);
+
+// Phase step that takes a grain of frameCount frames across the whole table
+inline uint32_t phaseIncrement(uint32_t frameCount)
+{
+    return (frameCount > 1) ? 0xFFFFFFFFu / (frameCount - 1) : 0;
+}
+
+inline float read(const float* table, uint32_t phase)
+{
+    return table[phase >> (32 - TABLE_BITS)];
+}
+
+} // namespace GrainWindow
@@ -0,0 +1,98 @@
+#include "LiveInput.h"
+#include "b3ReadWavFile.h"
+#include <string.h>
+
+// External declaration for custom memory allocator defined in SimpleSampler.cpp
+extern void* custom_pool_allocate(size_t size);
+
+// Convert an input sample to the ring's sample type
+template <typename SampleT>
+static inline SampleT toLiveSample(float value)
+{
+    return value;
+}
+
+template <>
+inline short toLiveSample<short>(float value)
+{
+    if (value > 1.0f) value = 1.0f;
+    if (value < -1.0f) value = -1.0f;
+    return (short)(value * 32767.0f);
+}
+
+LiveInput::LiveInput()
+    : ring_(nullptr)
+    , length_(0)
+    , format_(B3_DECODED_FLOAT32)
+    , writeHead_(0)
+    , recorded_(0)
+    , frozen_(false)
+{
+}
+
+bool LiveInput::init(int format, float sampleRate)
+{
+    if (ring_ != nullptr) {
+        return format == format_;
+    }
+
+    format_ = format;
+    uint32_t length = (uint32_t)(sampleRate * Constants::LiveInput::BUFFER_SECONDS);
+    size_t bytesPerSample = (format == B3_DECODED_INT16) ? sizeof(short) : sizeof(float);
+    size_t ringSize = (length + GUARD_FRAMES) * CHANNELS * bytesPerSample;
+
+    void* ring = custom_pool_allocate(ringSize);
+    if (ring == nullptr) {
+        return false;
+    }
+
+    // Start from silence so grains reading unrecorded frames stay quiet
+    memset(ring, 0, ringSize);
+    length_ = length;
+    writeHead_ = 0;
+    recorded_ = 0;
+    ring_ = ring;
+    return true;
+}
+
+template <typename SampleT>
+void LiveInput::writeFrames(const float* in0, const float* in1, size_t size)
+{
+    SampleT* ring = (SampleT*)ring_;
+    uint32_t head = writeHead_;
+
+    for (size_t i = 0; i < size; i++) {
+        SampleT* frame = ring + head * CHANNELS;
+        frame[0] = toLiveSample<SampleT>(in0[i]);
+        frame[1] = toLiveSample<SampleT>(in1[i]);
+
+        // Mirror the start of the ring after its end
+        if (head < GUARD_FRAMES) {
+            SampleT* mirror = ring + (length_ + head) * CHANNELS;
+            mirror[0] = frame[0];
+            mirror[1] = frame[1];
+        }
+
+        if (++head == length_) {
+            head = 0;
+        }
+    }
+
+    // Publish the block once it is all in the ring
+    writeHead_ = head;
+    uint32_t recorded = recorded_ + (uint32_t)size;
+    recorded_ = (recorded < length_) ? recorded : length_;
+}
+
+void LiveInput::write(const float* in0, const float* in1, size_t size)
+{
+    if (ring_ == nullptr || frozen_) {
+        return;
+    }
+
+    if (format_ == B3_DECODED_INT16) {
+        writeFrames<short>(in0, in1, size);
+    } else {
+        writeFrames<float>(in0, in1, size);
+    }
+}
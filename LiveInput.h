@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Constants.h"
+
+/**
+ * LiveInput - Circular SDRAM recording of the audio input, used as a grain source
+ *
+ * The audio callback is the only writer: write() copies each input block in
+ * (decoded in the same format as samples, stereo interleaved) and then
+ * publishes the new write head. Grains read the ring in place, wrapping at
+ * getLength(); frame 0 is mirrored after the end so interpolation can read
+ * one frame past the wrap point.
+ *
+ * While frozen, write() drops the input and the ring holds still, so grains
+ * can scan a fixed moment of sound. setFrozen() is safe from the main loop.
+ */
+class LiveInput {
+public:
+    static constexpr int CHANNELS = 2;
+    static constexpr uint32_t GUARD_FRAMES = 1;
+
+    LiveInput();
+
+    /**
+     * Allocate the ring from the SDRAM pool (first call only)
+     *
+     * @param format Decoded sample format (B3_DECODED_FLOAT32 / B3_DECODED_INT16)
+     * @param sampleRate Audio rate, to size the ring
+     * @return true if the ring is available
+     */
+    bool init(int format, float sampleRate);
+
+    bool isReady() const { return ring_ != nullptr; }
+
+    // Record one input block (audio callback)
+    void write(const float* in0, const float* in1, size_t size);
+
+    // Stop or resume recording
+    void setFrozen(bool frozen) { frozen_ = frozen; }
+    bool isFrozen() const { return frozen_; }
+
+    // Ring frames for grains (GUARD_FRAMES valid past getLength())
+    const void* getFrames() const { return ring_; }
+
+    // Ring length in frames
+    uint32_t getLength() const { return length_; }
+
+    // Ring frame the next input frame goes to
+    uint32_t getWriteHead() const { return writeHead_; }
+
+    // Frames recorded so far, up to getLength()
+    uint32_t getRecordedFrames() const { return recorded_; }
+
+private:
+    void* ring_;
+    uint32_t length_;
+    int format_;
+    volatile uint32_t writeHead_;
+    volatile uint32_t recorded_;
+    volatile bool frozen_;
+
+    template <typename SampleT>
+    void writeFrames(const float* in0, const float* in1, size_t size);
+};
@@ -213,7 +213,7 @@ void GranularSynthMenu::render()
     display_->setCursor(0, 24);
     char grainLine[32];
     int activeGrains = sampleLibrary_->getActiveGrainCount();
-    snprintf(grainLine, sizeof(grainLine), "Grains: %d/8", activeGrains);
+    snprintf(grainLine, sizeof(grainLine), "Grains: %d/%d", activeGrains, sampleLibrary_->getGrainLimit());
     display_->writeString(grainLine, Font_7x10);
 
     // Display selected parameter name and value on same line
@@ -256,13 +256,19 @@ void GranularSynthMenu::render()
             randomValue = sampleLibrary_->getGranularPositionRandom();
             decimalPlaces = 2;
             break;
+        case GranularParam::WINDOW:
+            paramName = "Win";
+            break;
     }
     
     // Format float value to string manually
     formatFloatToString(paramValue, decimalPlaces, valueStr, sizeof(valueStr));
     
     // Build the parameter line with randomness if > 0
-    if (randomValue > 0.001f) {
+    if (selectedParam_ == GranularParam::WINDOW) {
+        snprintf(paramLine, sizeof(paramLine), "%s:%s", paramName,
+                 GrainWindow::getName(sampleLibrary_->getGranularWindow()));
+    } else if (randomValue > 0.001f) {
         formatFloatToString(randomValue, decimalPlaces, randomStr, sizeof(randomStr));
         snprintf(paramLine, sizeof(paramLine), "%s:%s+%s%s", paramName, valueStr, randomStr, paramUnit);
     } else {
@@ -273,7 +279,11 @@ void GranularSynthMenu::render()
     // Display sample index (abbreviated)
     display_->setCursor(0, 48);
     char sampleLine[32];
-    snprintf(sampleLine, sizeof(sampleLine), "Smp:%d/%d", granularSampleIndex_ + 1, sampleLibrary_->getSampleCount());
+    if (sampleLibrary_->isGranularLiveSource()) {
+        snprintf(sampleLine, sizeof(sampleLine), "Src:Live%s", sampleLibrary_->isLiveFrozen() ? " FRZ" : "");
+    } else {
+        snprintf(sampleLine, sizeof(sampleLine), "Smp:%d/%d", granularSampleIndex_ + 1, sampleLibrary_->getSampleCount());
+    }
     display_->writeString(sampleLine, Font_7x10);
 
     // Display footer
@@ -317,6 +327,8 @@ void GranularSynthMenu::onEncoderIncrement()
                 if (currentRandom > Constants::Granular::POSITION_RANDOM_MAX) currentRandom = Constants::Granular::POSITION_RANDOM_MAX;
                 sampleLibrary_->setGranularPositionRandom(currentRandom);
                 break;
+            case GranularParam::WINDOW:
+                break;  // No randomness for the window shape
         }
     } else {
         // Adjust base parameter value
@@ -347,6 +359,9 @@ void GranularSynthMenu::onEncoderIncrement()
                 if (currentValue > 1.0f) currentValue = 1.0f;
                 sampleLibrary_->setGranularPosition(currentValue);
                 break;
+            case GranularParam::WINDOW:
+                sampleLibrary_->setGranularWindow(sampleLibrary_->getGranularWindow() + 1);
+                break;
         }
     }
 }
@@ -385,6 +400,8 @@ void GranularSynthMenu::onEncoderDecrement()
                 if (currentRandom < 0.0f) currentRandom = 0.0f;
                 sampleLibrary_->setGranularPositionRandom(currentRandom);
                 break;
+            case GranularParam::WINDOW:
+                break;  // No randomness for the window shape
         }
     } else {
         // Adjust base parameter value
@@ -415,13 +432,16 @@ void GranularSynthMenu::onEncoderDecrement()
                 if (currentValue < 0.0f) currentValue = 0.0f;
                 sampleLibrary_->setGranularPosition(currentValue);
                 break;
+            case GranularParam::WINDOW:
+                sampleLibrary_->setGranularWindow(sampleLibrary_->getGranularWindow() - 1);
+                break;
         }
     }
 }
 
 void GranularSynthMenu::onEncoderClick()
 {
-    // Cycle to next parameter: SpawnRate -> Duration -> Speed -> Position -> (back to SpawnRate)
+    // Cycle to next parameter: SpawnRate -> Duration -> Speed -> Position -> Window -> (back to SpawnRate)
     switch (selectedParam_) {
         case GranularParam::SPAWN_RATE:
             selectedParam_ = GranularParam::DURATION;
@@ -433,6 +453,9 @@ void GranularSynthMenu::onEncoderClick()
             selectedParam_ = GranularParam::POSITION;
             break;
         case GranularParam::POSITION:
+            selectedParam_ = GranularParam::WINDOW;
+            break;
+        case GranularParam::WINDOW:
             selectedParam_ = GranularParam::SPAWN_RATE;
             break;
     }
@@ -453,8 +476,28 @@ void GranularSynthMenu::onButton1Press()
 
 void GranularSynthMenu::onButton2Press()
 {
-    // Cycle to next sample
+    // Gate open on the live input: toggle freeze instead of changing source
+    if (sampleLibrary_->isGranularLiveSource()) {
+        if (sampleLibrary_->isGateOpen()) {
+            sampleLibrary_->setLiveFrozen(!sampleLibrary_->isLiveFrozen());
+            return;
+        }
+
+        // Leave the live input for the first sample
+        sampleLibrary_->setGranularLiveSource(false);
+        granularSampleIndex_ = 0;
+        if (sampleLibrary_->getSampleCount() > 0) {
+            sampleLibrary_->setGranularSampleIndex(granularSampleIndex_);
+        }
+        return;
+    }
+
+    // Cycle to next sample; after the last one comes the live input
     int numSamples = sampleLibrary_->getSampleCount();
+    if (granularSampleIndex_ + 1 >= numSamples && sampleLibrary_->isLiveInputReady()) {
+        sampleLibrary_->setGranularLiveSource(true);
+        return;
+    }
     if (numSamples > 0) {
         granularSampleIndex_ = (granularSampleIndex_ + 1) % numSamples;
         sampleLibrary_->setGranularSampleIndex(granularSampleIndex_);
@@ -44,9 +44,10 @@ public:
  *
  * Displays current sample, gate status, active grain count, and selected parameter.
  * Button1 (hold): Open gate to spawn grains
- * Button2: Cycle through loaded samples
+ * Button2: Cycle through loaded samples, then the live input
+ * Button2 while gate open on the live input: Freeze / unfreeze recording
  * Encoder turn: Adjust selected parameter value
- * Encoder click: Cycle through parameters (Spawn Rate, Duration, Speed, Position)
+ * Encoder click: Cycle through parameters (Spawn Rate, Duration, Speed, Position, Window)
  * Hold encoder: Return to main menu
  */
 class GranularSynthMenu : public BaseMenu {
@@ -58,7 +59,8 @@ private:
         SPAWN_RATE,  // Grains per second
         DURATION,    // Grain duration in seconds
         SPEED,       // Playback speed multiplier
-        POSITION      // Start position within sample (0.0-1.0)
+        POSITION,     // Start position within sample (0.0-1.0)
+        WINDOW        // Grain envelope shape
     };
     
     GranularParam selectedParam_;  // Currently selected parameter
@@ -84,7 +86,7 @@ public:
     // Button1: Open gate (grains spawn while held)
     void onButton1Press() override;
 
-    // Button2: Cycle to next sample
+    // Button2: Cycle to next sample or the live input (freeze while gate open)
     void onButton2Press() override;
 };
 
@@ -0,0 +1,133 @@
+#include "OledPageWriter.h"
+#include <cstring>
+
+// SSD130x commands for a column/page window (horizontal addressing mode)
+static constexpr uint8_t CMD_COLUMN_ADDRESS = 0x21;
+static constexpr uint8_t CMD_PAGE_ADDRESS = 0x22;
+static constexpr uint32_t WINDOW_COMMAND_BYTES = 6;
+
+OledPageWriter::OledPageWriter()
+    : shadow_(nullptr),
+      transport_(nullptr),
+      pending_(0),
+      inFlight_(false),
+      updateRequested_(false),
+      invalidated_(true),
+      frameStartUs_(0),
+      frameBytes_(0),
+      framePages_(0),
+      stats_() {
+    memset(buffer_, 0, sizeof(buffer_));
+}
+
+void OledPageWriter::init(OledTransport* transport, uint8_t* shadow) {
+    transport_ = transport;
+    shadow_ = shadow;
+    memset(shadow_, 0, BUFFER_SIZE);
+    pending_ = 0;
+    inFlight_ = false;
+    updateRequested_ = false;
+    invalidated_ = true;
+}
+
+void OledPageWriter::drawPixel(int x, int y, bool on) {
+    if (x < 0 || x >= WIDTH || y < 0 || y >= PAGES * 8) {
+        return;
+    }
+    uint8_t& cell = buffer_[x + (y >> 3) * WIDTH];
+    uint8_t bit = (uint8_t)(1 << (y & 7));
+    if (on) {
+        cell |= bit;
+    } else {
+        cell &= (uint8_t)~bit;
+    }
+}
+
+void OledPageWriter::fill(bool on) {
+    memset(buffer_, on ? 0xFF : 0x00, sizeof(buffer_));
+}
+
+void OledPageWriter::update(uint32_t nowUs) {
+    updateRequested_ = true;
+    service(nowUs);
+}
+
+bool OledPageWriter::service(uint32_t nowUs) {
+    if (transport_ == nullptr || transport_->isBusy()) {
+        return isBusy();
+    }
+
+    if (pending_ != 0) {
+        sendRun();
+        return true;
+    }
+
+    // The last run has gone out
+    if (inFlight_) {
+        inFlight_ = false;
+        stats_.frames++;
+        stats_.lastPages = framePages_;
+        stats_.lastBytes = frameBytes_;
+        stats_.lastTransferUs = nowUs - frameStartUs_;
+        stats_.totalBytes += frameBytes_;
+    }
+
+    if (updateRequested_) {
+        updateRequested_ = false;
+        beginFrame(nowUs);
+        if (pending_ != 0) {
+            sendRun();
+        }
+    }
+    return isBusy();
+}
+
+void OledPageWriter::beginFrame(uint32_t nowUs) {
+    for (int page = 0; page < PAGES; page++) {
+        const uint8_t* source = buffer_ + page * WIDTH;
+        uint8_t* shown = shadow_ + page * WIDTH;
+        if (invalidated_ || memcmp(source, shown, WIDTH) != 0) {
+            memcpy(shown, source, WIDTH);
+            pending_ |= 1u << page;
+        }
+    }
+    invalidated_ = false;
+
+    if (pending_ == 0) {
+        stats_.unchanged++;
+        return;
+    }
+    inFlight_ = true;
+    frameStartUs_ = nowUs;
+    frameBytes_ = 0;
+    framePages_ = 0;
+}
+
+void OledPageWriter::sendRun() {
+    int first = 0;
+    while ((pending_ & (1u << first)) == 0) {
+        first++;
+    }
+    int last = first;
+    while (last + 1 < PAGES && (pending_ & (1u << (last + 1))) != 0) {
+        last++;
+    }
+    int pages = last - first + 1;
+    pending_ &= ~(((1u << pages) - 1) << first);
+
+    const uint8_t window[WINDOW_COMMAND_BYTES] = {
+        CMD_COLUMN_ADDRESS, 0, (uint8_t)(WIDTH - 1),
+        CMD_PAGE_ADDRESS, (uint8_t)first, (uint8_t)last
+    };
+    transport_->sendCommands(window, sizeof(window));
+    if (!transport_->startData(shadow_ + first * WIDTH, (size_t)pages * WIDTH)) {
+        // Drop this frame and send everything again with the next one
+        pending_ = 0;
+        inFlight_ = false;
+        invalidated_ = true;
+        updateRequested_ = true;
+        return;
+    }
+    frameBytes_ += WINDOW_COMMAND_BYTES + (uint32_t)pages * WIDTH;
+    framePages_ += pages;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Constants.h"
+
+/**
+ * OledTransport - Byte pipe to an SSD130x controller
+ *
+ * Commands are a few bytes and go out blocking. Page data goes out in the
+ * background: startData() returns at once and isBusy() stays true until the
+ * last byte has been sent. The data must stay untouched until then.
+ */
+class OledTransport {
+public:
+    virtual ~OledTransport() {}
+
+    // Send command bytes (only called while the transport is idle)
+    virtual void sendCommands(const uint8_t* commands, size_t size) = 0;
+
+    // Start sending display data; returns false if the transfer could not start
+    virtual bool startData(const uint8_t* data, size_t size) = 0;
+
+    virtual bool isBusy() const = 0;
+};
+
+/**
+ * OledFrameStats - What the last frames cost on the wire, for the debug screen
+ */
+struct OledFrameStats {
+    uint32_t frames;            // Frames sent since boot
+    uint32_t unchanged;         // Updates that had no changed page to send
+    uint32_t lastPages;         // Pages sent in the last frame
+    uint32_t lastBytes;         // Command + data bytes of the last frame
+    uint32_t lastTransferUs;    // From starting the last frame to seeing its last byte sent
+    uint32_t totalBytes;        // Bytes sent since boot
+};
+
+/**
+ * OledPageWriter - Framebuffer that sends only the 8-row pages that changed
+ *
+ * Drawing goes to buffer_ (SSD130x layout: one byte is 8 vertical pixels of a
+ * page). shadow_ holds what the panel shows. update() compares the two page
+ * by page, copies changed pages into the shadow and sends each run of
+ * adjacent changed pages as one column/page-addressed transfer. The shadow is
+ * what the transport reads from, so drawing the next frame can start while
+ * this one is still going out.
+ *
+ * Nothing here waits for the transport: a run is started when the previous
+ * one has finished, from update() or service(). An update() made while a
+ * frame is in flight is sent once that frame is done.
+ *
+ * Needs the controller in horizontal addressing mode (0x20 0x00).
+ * No libDaisy dependency, so it also runs on the host against a fake transport.
+ */
+class OledPageWriter {
+public:
+    static constexpr int WIDTH = Constants::Display::WIDTH;
+    static constexpr int PAGES = Constants::Display::HEIGHT / 8;
+    static constexpr size_t BUFFER_SIZE = WIDTH * PAGES;
+
+    OledPageWriter();
+
+    /**
+     * @param transport Where frames go
+     * @param shadow BUFFER_SIZE bytes the transport can read from (DMA-capable memory on the Daisy)
+     */
+    void init(OledTransport* transport, uint8_t* shadow);
+
+    void drawPixel(int x, int y, bool on);
+    void fill(bool on);
+
+    // Send every page with the next update (the panel content is unknown after init)
+    void invalidate() { invalidated_ = true; }
+
+    // Send what has changed since the last update; returns immediately
+    void update(uint32_t nowUs);
+
+    /**
+     * Start the next run of pages once the transport is free (call often)
+     *
+     * @return true while a frame is still being sent or waiting to be
+     */
+    bool service(uint32_t nowUs);
+
+    bool isBusy() const { return inFlight_ || updateRequested_; }
+
+    const OledFrameStats& getStats() const { return stats_; }
+
+private:
+    uint8_t buffer_[BUFFER_SIZE];
+    uint8_t* shadow_;
+    OledTransport* transport_;
+
+    uint32_t pending_;          // Bit per page of the frame in flight not yet started
+    bool inFlight_;
+    bool updateRequested_;
+    bool invalidated_;
+
+    uint32_t frameStartUs_;
+    uint32_t frameBytes_;
+    uint32_t framePages_;
+    OledFrameStats stats_;
+
+    // Copy changed pages to the shadow and mark them pending
+    void beginFrame(uint32_t nowUs);
+
+    // Send the lowest run of adjacent pending pages
+    void sendRun();
+};
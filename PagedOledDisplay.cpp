@@ -0,0 +1,78 @@
+#include "PagedOledDisplay.h"
+
+// What the panel shows; read by the SPI DMA, so it lives in non-cached D2 SRAM (one display)
+static uint8_t DMA_BUFFER_MEM_SECTION oledShadow[OledPageWriter::BUFFER_SIZE];
+
+// SSD130x power-up sequence for a 128x64 panel, in horizontal addressing mode
+static const uint8_t OLED_INIT_COMMANDS[] = {
+    0xAE,           // Display off
+    0xD5, 0x80,     // Clock divide ratio
+    0xA8, 0x3F,     // Multiplex ratio (64 rows)
+    0xDA, 0x12,     // COM pins
+    0xD3, 0x00,     // Display offset
+    0x40,           // Start line 0
+    0x20, 0x00,     // Horizontal addressing (OledPageWriter sends column/page windows)
+    0xA6,           // Normal (not inverted)
+    0xA4,           // Show RAM contents
+    0x8D, 0x14,     // Charge pump on
+    0xA1,           // Segment remap
+    0xC8,           // COM scan direction
+    0x81, 0x8F,     // Contrast
+    0xD9, 0x25,     // Pre-charge
+    0xDB, 0x34,     // VCOM detect
+    0xAF            // Display on
+};
+
+SpiDmaOledTransport::SpiDmaOledTransport()
+    : busy_(false) {
+}
+
+void SpiDmaOledTransport::init(const SSD130x4WireSpiTransport::Config& config) {
+    spi_.Init(config.spi_config);
+
+    dc_.pin = config.pin_config.dc;
+    dc_.mode = DSY_GPIO_MODE_OUTPUT_PP;
+    dc_.pull = DSY_GPIO_NOPULL;
+    dsy_gpio_init(&dc_);
+
+    reset_.pin = config.pin_config.reset;
+    reset_.mode = DSY_GPIO_MODE_OUTPUT_PP;
+    reset_.pull = DSY_GPIO_NOPULL;
+    dsy_gpio_init(&reset_);
+
+    // Reset pulse
+    dsy_gpio_write(&reset_, 0);
+    System::Delay(10);
+    dsy_gpio_write(&reset_, 1);
+    System::Delay(10);
+}
+
+void SpiDmaOledTransport::sendCommands(const uint8_t* commands, size_t size) {
+    dsy_gpio_write(&dc_, 0);
+    spi_.BlockingTransmit(const_cast<uint8_t*>(commands), size);
+}
+
+bool SpiDmaOledTransport::startData(const uint8_t* data, size_t size) {
+    dsy_gpio_write(&dc_, 1);
+    busy_ = true;
+    if (spi_.DmaTransmit(const_cast<uint8_t*>(data), size, nullptr, transferDone, this) != SpiHandle::Result::OK) {
+        busy_ = false;
+        return false;
+    }
+    return true;
+}
+
+void SpiDmaOledTransport::transferDone(void* context, SpiHandle::Result result) {
+    static_cast<SpiDmaOledTransport*>(context)->busy_ = false;
+}
+
+void PagedOledDisplay::Init(Config config) {
+    transport_.init(config.transport_config);
+    transport_.sendCommands(OLED_INIT_COMMANDS, sizeof(OLED_INIT_COMMANDS));
+    writer_.init(&transport_, oledShadow);
+}
+
+void PagedOledDisplay::flush() {
+    while (service()) {
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "daisy_seed.h"
+#include "dev/oled_ssd130x.h"
+#include "OledPageWriter.h"
+#include "DisplayBackend.h"
+
+using namespace daisy;
+
+/**
+ * SpiDmaOledTransport - 4-wire SPI to the SSD130x, page data sent by DMA
+ *
+ * Uses the same pins and SPI settings as libDaisy's SSD130x4WireSpiTransport
+ * (and takes its Config). The D/C line is low for commands and held high for
+ * the whole data transfer; the DMA completion callback clears busy_.
+ */
+class SpiDmaOledTransport : public OledTransport {
+public:
+    SpiDmaOledTransport();
+
+    void init(const SSD130x4WireSpiTransport::Config& config);
+
+    void sendCommands(const uint8_t* commands, size_t size) override;
+    bool startData(const uint8_t* data, size_t size) override;
+    bool isBusy() const override { return busy_; }
+
+private:
+    SpiHandle spi_;
+    dsy_gpio dc_;
+    dsy_gpio reset_;
+    volatile bool busy_;
+
+    static void transferDone(void* context, SpiHandle::Result result);
+};
+
+/**
+ * PagedOledDisplay - The Pod's 128x64 OLED with partial, non-blocking updates
+ *
+ * A drop-in for OledDisplay<SSD130x4WireSpi128x64Driver>: the libDaisy
+ * graphics calls work unchanged, but Update() only starts sending the pages
+ * that changed (see OledPageWriter) and returns. service() must be called
+ * from the main loop to send the rest of a frame.
+ */
+class PagedOledDisplay : public OneBitGraphicsDisplayImpl<PagedOledDisplay> {
+public:
+    struct Config {
+        SSD130x4WireSpiTransport::Config transport_config;
+    };
+
+    void Init(Config config);
+
+    uint16_t Height() const override { return Constants::Display::HEIGHT; }
+    uint16_t Width() const override { return Constants::Display::WIDTH; }
+
+    void Fill(bool on) override { writer_.fill(on); }
+    void DrawPixel(uint_fast8_t x, uint_fast8_t y, bool on) override { writer_.drawPixel(x, y, on); }
+
+    // Start sending the changed pages (returns without waiting)
+    void Update() override { writer_.update(System::GetUs()); }
+
+    // Continue the frame in flight; returns true while one is still being sent
+    bool service() { return writer_.service(System::GetUs()); }
+
+    // Wait until everything drawn so far is on the panel
+    void flush();
+
+    const OledFrameStats& getFrameStats() const { return writer_.getStats(); }
+
+private:
+    SpiDmaOledTransport transport_;
+    OledPageWriter writer_;
+};
+
+/**
+ * OledDisplayBackend - DisplayManager backend for the Pod's OLED
+ */
+class OledDisplayBackend : public DisplayBackend {
+public:
+    explicit OledDisplayBackend(PagedOledDisplay& display) : display_(display) {}
+
+    OneBitGraphicsDisplay& canvas() override { return display_; }
+    void present() override { display_.Update(); }
+    void service() override { display_.service(); }
+    void flush() override { display_.flush(); }
+    OledFrameStats getFrameStats() const override { return display_.getFrameStats(); }
+    void delayMs(uint32_t ms) override { System::Delay(ms); }
+
+private:
+    PagedOledDisplay& display_;
+};
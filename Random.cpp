@@ -0,0 +1,108 @@
+#include "Random.h"
+
+#include <cmath>
+
+// PCG32 (XSH RR) constants
+static constexpr uint64_t PCG_MULTIPLIER = 6364136223846793005ULL;
+static constexpr uint64_t PCG_STREAM = 1442695040888963407ULL;
+
+// Gaussian values are drawn with this sigma, then clipped to [-1, 1]
+static constexpr float GAUSSIAN_SIGMA = 1.0f / 3.0f;
+
+static const float TWO_PI = 6.28318530717959f;
+
+RandomGenerator::RandomGenerator(uint64_t seed)
+    : state_(0)
+    , increment_(PCG_STREAM | 1u)
+{
+    this->seed(seed);
+}
+
+void RandomGenerator::seed(uint64_t seed)
+{
+    state_ = 0;
+    next();
+    state_ += seed;
+    next();
+}
+
+uint32_t RandomGenerator::next()
+{
+    uint64_t old = state_;
+    state_ = old * PCG_MULTIPLIER + increment_;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+}
+
+float RandomGenerator::uniform()
+{
+    // Top 24 bits: exact in a float, never reaches 1.0
+    return (float)(next() >> 8) * (1.0f / 16777216.0f);
+}
+
+float RandomGenerator::bipolar(int distribution)
+{
+    switch (distribution) {
+        case RANDOM_TRIANGULAR:
+            return uniform() + uniform() - 1.0f;
+        case RANDOM_GAUSSIAN: {
+            // Box-Muller; 1 - uniform() keeps the log argument above zero
+            float radius = sqrtf(-2.0f * logf(1.0f - uniform()));
+            float value = radius * cosf(TWO_PI * uniform()) * GAUSSIAN_SIGMA;
+            if (value > 1.0f) value = 1.0f;
+            if (value < -1.0f) value = -1.0f;
+            return value;
+        }
+        case RANDOM_UNIFORM:
+        default:
+            return 2.0f * uniform() - 1.0f;
+    }
+}
+
+void RandomGenerator::fill(float* dst, int count, int distribution)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = bipolar(distribution);
+    }
+}
+
+const char* RandomGenerator::getName(int distribution)
+{
+    switch (distribution) {
+        case RANDOM_UNIFORM:    return "Unif";
+        case RANDOM_TRIANGULAR: return "Tri";
+        case RANDOM_GAUSSIAN:   return "Gauss";
+        default:                return "?";
+    }
+}
+
+RandomBatch::RandomBatch()
+    : count_(0)
+    , distribution_(RANDOM_UNIFORM)
+{
+}
+
+void RandomBatch::setDistribution(int distribution)
+{
+    if (distribution < 0 || distribution >= NUM_RANDOM_DISTRIBUTIONS) {
+        distribution = RANDOM_UNIFORM;
+    }
+    distribution_ = distribution;
+    count_ = 0;
+}
+
+void RandomBatch::refill(RandomGenerator& rng)
+{
+    // Only the slots handed out since the last refill are drawn again
+    rng.fill(values_ + count_, SIZE - count_, distribution_);
+    count_ = SIZE;
+}
+
+float RandomBatch::take(RandomGenerator& rng)
+{
+    if (count_ == 0) {
+        refill(rng);
+    }
+    return values_[--count_];
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include "Constants.h"
+
+/**
+ * Shapes for bipolar random values in [-1, 1]
+ */
+enum RandomDistribution {
+    RANDOM_UNIFORM,      // Every value equally likely
+    RANDOM_TRIANGULAR,   // Mean of two uniforms: most values near 0
+    RANDOM_GAUSSIAN,     // Normal with sigma 1/3, clipped to [-1, 1]
+    NUM_RANDOM_DISTRIBUTIONS
+};
+
+/**
+ * RandomGenerator - Seedable PCG32 generator
+ *
+ * Small, allocation free and deterministic: two generators seeded alike
+ * produce the same sequence on the Daisy and on a host build. Each instance
+ * has its own state, so the audio callback never shares one with the main loop.
+ */
+class RandomGenerator {
+public:
+    explicit RandomGenerator(uint64_t seed = Constants::Random::DEFAULT_SEED);
+
+    // Restart the sequence from a seed
+    void seed(uint64_t seed);
+
+    // Next 32 random bits
+    uint32_t next();
+
+    // Uniform float in [0, 1)
+    float uniform();
+
+    // Bipolar value in [-1, 1] with the given distribution
+    float bipolar(int distribution);
+
+    // Fill dst with count bipolar values
+    void fill(float* dst, int count, int distribution);
+
+    // Display name of a distribution ("Unif", "Tri", "Gauss")
+    static const char* getName(int distribution);
+
+private:
+    uint64_t state_;
+    uint64_t increment_;
+};
+
+/**
+ * RandomBatch - Block-rate pool of bipolar random values
+ *
+ * refill() tops the pool up once per audio block; take() hands values out
+ * during the block (refilling early only if a burst empties it). Values are
+ * drawn in a fixed order, so a seeded generator gives reproducible results.
+ */
+class RandomBatch {
+public:
+    static constexpr int SIZE = Constants::Random::BATCH_SIZE;
+
+    RandomBatch();
+
+    // Change the distribution (drops any values already drawn)
+    void setDistribution(int distribution);
+    int getDistribution() const { return distribution_; }
+
+    // Top the pool up (block rate)
+    void refill(RandomGenerator& rng);
+
+    // Drop every pooled value (after reseeding)
+    void reset() { count_ = 0; }
+
+    // Next value in [-1, 1]
+    float take(RandomGenerator& rng);
+
+private:
+    float values_[SIZE];
+    int count_;           // Values still available at values_[0, count_)
+    int distribution_;
+};
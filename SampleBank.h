@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * SampleBank - File format for a whole kit of pre-decoded samples
+ *
+ * Booting from a bank replaces opening and parsing every WAV on the card
+ * with a few large sequential reads: the header, then the name index.
+ * Audio is stored already decoded, so loading a sample is one read straight
+ * into its cache buffer.
+ *
+ * Layout (little-endian):
+ *   SampleBankHeader
+ *   SampleBankEntry[sampleCount]          (the name index)
+ *   audio of each entry at its dataOffset (SAMPLE_BANK_ALIGN aligned),
+ *   numFrames interleaved frames in the bank's format, no guard frames
+ *
+ * Written on the host by tools/bankpack.cpp; this header is shared with it.
+ */
+
+// "SSBK"
+constexpr uint32_t SAMPLE_BANK_MAGIC = 0x4B425353;
+constexpr uint16_t SAMPLE_BANK_VERSION = 1;
+
+// Audio starts on SD sector boundaries, so FatFS reads it straight into the destination
+constexpr uint32_t SAMPLE_BANK_ALIGN = 512;
+
+// Fits SampleInfo::name (including the terminator)
+constexpr int SAMPLE_BANK_NAME_SIZE = 32;
+
+struct SampleBankHeader {
+    uint32_t magic;             // SAMPLE_BANK_MAGIC
+    uint16_t version;           // SAMPLE_BANK_VERSION
+    uint16_t format;            // B3_DECODED_FLOAT32 / B3_DECODED_INT16
+    uint32_t sampleCount;       // Entries in the index
+    uint32_t indexOffset;       // Byte offset of the first SampleBankEntry
+    uint32_t reserved[4];
+};
+
+struct SampleBankEntry {
+    char name[SAMPLE_BANK_NAME_SIZE];   // Original WAV filename (zero-terminated)
+    uint32_t dataOffset;        // Byte offset of the first frame
+    uint32_t numFrames;
+    uint16_t channels;
+    uint16_t bitsPerSample;     // Of the original file (for display)
+    uint32_t sampleRate;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SampleBankHeader) == 32, "SampleBankHeader layout is part of the file format");
+static_assert(sizeof(SampleBankEntry) == 52, "SampleBankEntry layout is part of the file format");
@@ -0,0 +1,117 @@
+#include "SampleCache.h"
+
+// External declarations for custom memory allocator defined in SimpleSampler.cpp
+extern void* custom_pool_allocate(size_t size);
+extern void custom_pool_free(void* ptr);
+
+SampleCache::SampleCache()
+    : capacity_(0)
+    , used_(0)
+    , useCounter_(0)
+{
+    for (int i = 0; i < Constants::SampleLibrary::MAX_SAMPLES; i++) {
+        entries_[i].data = nullptr;
+        entries_[i].size = 0;
+        entries_[i].lastUse = 0;
+        entries_[i].pins = 0;
+    }
+}
+
+bool SampleCache::init(size_t capacity)
+{
+    if (capacity > Constants::Memory::CUSTOM_POOL_SIZE) {
+        return false;
+    }
+    capacity_ = capacity;
+    used_ = 0;
+    return true;
+}
+
+void* SampleCache::allocate(int sampleIndex, size_t size)
+{
+    if (capacity_ == 0 || sampleIndex < 0 || sampleIndex >= Constants::SampleLibrary::MAX_SAMPLES) {
+        return nullptr;
+    }
+    if (used_ + size > capacity_) {
+        return nullptr;
+    }
+
+    // The heap does best fit and merges freed neighbours, so evicting
+    // a few samples is enough to make room for a large one
+    char* data = (char*)custom_pool_allocate(size);
+    if (data == nullptr) {
+        return nullptr;
+    }
+
+    entries_[sampleIndex].data = data;
+    entries_[sampleIndex].size = size;
+    used_ += size;
+    touch(sampleIndex);
+    return data;
+}
+
+void SampleCache::release(int sampleIndex)
+{
+    if (!isCached(sampleIndex)) {
+        return;
+    }
+    custom_pool_free(entries_[sampleIndex].data);
+    used_ -= entries_[sampleIndex].size;
+    entries_[sampleIndex].data = nullptr;
+    entries_[sampleIndex].size = 0;
+}
+
+void SampleCache::touch(int sampleIndex)
+{
+    if (sampleIndex >= 0 && sampleIndex < Constants::SampleLibrary::MAX_SAMPLES) {
+        useCounter_ = useCounter_ + 1;
+        entries_[sampleIndex].lastUse = useCounter_;
+    }
+}
+
+void SampleCache::pin(int sampleIndex)
+{
+    if (sampleIndex >= 0 && sampleIndex < Constants::SampleLibrary::MAX_SAMPLES) {
+        entries_[sampleIndex].pins++;
+    }
+}
+
+void SampleCache::unpin(int sampleIndex)
+{
+    if (sampleIndex >= 0 && sampleIndex < Constants::SampleLibrary::MAX_SAMPLES &&
+        entries_[sampleIndex].pins > 0) {
+        entries_[sampleIndex].pins--;
+    }
+}
+
+bool SampleCache::isPinned(int sampleIndex) const
+{
+    if (sampleIndex < 0 || sampleIndex >= Constants::SampleLibrary::MAX_SAMPLES) {
+        return false;
+    }
+    return entries_[sampleIndex].pins > 0;
+}
+
+bool SampleCache::isCached(int sampleIndex) const
+{
+    if (sampleIndex < 0 || sampleIndex >= Constants::SampleLibrary::MAX_SAMPLES) {
+        return false;
+    }
+    return entries_[sampleIndex].data != nullptr;
+}
+
+int SampleCache::findVictim(const bool* busy) const
+{
+    int victim = -1;
+    for (int i = 0; i < Constants::SampleLibrary::MAX_SAMPLES; i++) {
+        const Entry& entry = entries_[i];
+        if (entry.data == nullptr || entry.pins > 0 || busy[i]) {
+            continue;
+        }
+        // Wrap-safe comparison of use stamps
+        if (victim < 0 || (int32_t)(entry.lastUse - entries_[victim].lastUse) < 0) {
+            victim = i;
+        }
+    }
+    return victim;
+}
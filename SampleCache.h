@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Constants.h"
+
+/**
+ * SampleCache - Byte budget for decoded sample data in SDRAM
+ *
+ * Samples are paged in on demand by SampleLibrary's background loader
+ * (requestSampleLoad / retainSample; getLoaderProgress reports the load).
+ * Each sample owns at most one buffer from the SDRAM heap. When the budget is
+ * spent (or the heap has no block large enough), the caller evicts the
+ * least-recently-used sample that is neither pinned nor playing.
+ *
+ * Pins are held by whatever has a sample selected (sequencer tracks and the
+ * granular engine), so selected samples are never evicted.
+ */
+class SampleCache {
+public:
+    SampleCache();
+
+    /**
+     * Set the cache budget
+     *
+     * @param capacity Maximum bytes of sample data held at once
+     * @return true if the budget fits in the SDRAM pool
+     */
+    bool init(size_t capacity);
+
+    /**
+     * Allocate a buffer for a sample (which must not already hold one)
+     *
+     * @return Pointer to 32-byte aligned memory, or nullptr if over budget or the heap is full
+     */
+    void* allocate(int sampleIndex, size_t size);
+
+    /**
+     * Free a sample's buffer
+     */
+    void release(int sampleIndex);
+
+    /**
+     * Mark a sample as used now (safe to call from the audio callback)
+     */
+    void touch(int sampleIndex);
+
+    // Pin/unpin a sample so it cannot be evicted (pins are counted)
+    void pin(int sampleIndex);
+    void unpin(int sampleIndex);
+    bool isPinned(int sampleIndex) const;
+
+    // Does the sample currently hold a buffer?
+    bool isCached(int sampleIndex) const;
+
+    /**
+     * Pick the eviction victim: the least-recently-used cached sample that is
+     * not pinned and not marked busy
+     *
+     * @param busy Per-sample flags for samples that are currently playing
+     * @return Sample index, or -1 if nothing can be evicted
+     */
+    int findVictim(const bool* busy) const;
+
+    size_t getCapacity() const { return capacity_; }
+    size_t getUsedBytes() const { return used_; }
+
+private:
+    struct Entry {
+        char* data;          // Heap buffer (nullptr = not cached)
+        size_t size;         // Buffer size in bytes
+        uint32_t lastUse;    // useCounter_ value at last touch
+        int pins;            // Number of holders that keep this sample resident
+    };
+
+    Entry entries_[Constants::SampleLibrary::MAX_SAMPLES];
+    size_t capacity_;
+    size_t used_;
+    volatile uint32_t useCounter_;
+};
@@ -0,0 +1,159 @@
+#include "SampleIndex.h"
+#include <cstring>
+
+// External declarations for custom memory allocator defined in SimpleSampler.cpp
+extern void* custom_pool_allocate(size_t size);
+extern void custom_pool_free(void* ptr);
+
+// "SSIX"
+static constexpr uint32_t INDEX_MAGIC = 0x58495353;
+static constexpr uint16_t INDEX_VERSION = 1;
+
+SampleIndex::SampleIndex()
+    : old_(nullptr)
+    , oldCount_(0)
+    , next_(nullptr)
+    , nextCount_(0)
+    , hits_(0)
+    , misses_(0)
+{
+}
+
+SampleIndex::~SampleIndex()
+{
+    release();
+}
+
+bool SampleIndex::load(const char* path)
+{
+    release();
+    hits_ = 0;
+    misses_ = 0;
+    const size_t tableSize = Constants::SampleLibrary::MAX_SAMPLES * sizeof(SampleIndexEntry);
+    old_ = (SampleIndexEntry*)custom_pool_allocate(tableSize);
+    next_ = (SampleIndexEntry*)custom_pool_allocate(tableSize);
+    if (old_ == nullptr || next_ == nullptr) {
+        release();
+        return false;
+    }
+
+    FIL file;
+    if (f_open(&file, path, (FA_OPEN_EXISTING | FA_READ)) != FR_OK) {
+        return true;
+    }
+
+    // Header, then every entry in one read
+    Header header;
+    UINT bytesRead = 0;
+    if (f_read(&file, &header, sizeof(header), &bytesRead) == FR_OK && bytesRead == sizeof(header) &&
+        header.magic == INDEX_MAGIC && header.version == INDEX_VERSION &&
+        header.entrySize == sizeof(SampleIndexEntry) &&
+        header.count <= (uint32_t)Constants::SampleLibrary::MAX_SAMPLES) {
+        UINT bytes = header.count * sizeof(SampleIndexEntry);
+        if (f_read(&file, old_, bytes, &bytesRead) == FR_OK && bytesRead == bytes) {
+            oldCount_ = (int)header.count;
+            for (int i = 0; i < oldCount_; i++) {
+                old_[i].name[sizeof(old_[i].name) - 1] = '\0';
+            }
+        }
+    }
+    f_close(&file);
+    return true;
+}
+
+bool SampleIndex::matches(const SampleIndexEntry& entry, const FILINFO& file)
+{
+    return entry.size == (uint32_t)file.fsize && entry.date == file.fdate && entry.time == file.ftime &&
+           strcmp(entry.name, file.fname) == 0;
+}
+
+const SampleIndexEntry* SampleIndex::find(const FILINFO& file, int hint)
+{
+    if (hint >= 0 && hint < oldCount_ && matches(old_[hint], file)) {
+        hits_++;
+        return &old_[hint];
+    }
+    for (int i = 0; i < oldCount_; i++) {
+        if (matches(old_[i], file)) {
+            hits_++;
+            return &old_[i];
+        }
+    }
+    misses_++;
+    return nullptr;
+}
+
+void SampleIndex::add(const FILINFO& file, const b3WavInfo& info)
+{
+    if (next_ == nullptr || nextCount_ >= Constants::SampleLibrary::MAX_SAMPLES) {
+        return;
+    }
+    SampleIndexEntry& entry = next_[nextCount_++];
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.name, file.fname, sizeof(entry.name) - 1);
+    entry.size = (uint32_t)file.fsize;
+    entry.date = file.fdate;
+    entry.time = file.ftime;
+    entry.numFrames = (uint32_t)info.numFrames;
+    entry.dataType = (uint32_t)info.dataType;
+    entry.dataOffset = (uint32_t)info.dataOffset;
+    entry.sampleRate = (uint32_t)info.rate;
+    entry.channels = (uint16_t)info.channels;
+    entry.flags = info.byteswap ? FLAG_BYTESWAP : 0;
+}
+
+b3WavInfo SampleIndex::toInfo(const SampleIndexEntry& entry)
+{
+    b3WavInfo info;
+    info.numFrames = entry.numFrames;
+    info.dataType = entry.dataType;
+    info.dataOffset = entry.dataOffset;
+    info.rate = (double)entry.sampleRate;
+    info.channels = entry.channels;
+    info.byteswap = (entry.flags & FLAG_BYTESWAP) != 0;
+    return info;
+}
+
+bool SampleIndex::save(const char* path)
+{
+    if (next_ == nullptr) {
+        return false;
+    }
+
+    // Same files, same order, same stamps: nothing to write
+    if (nextCount_ == oldCount_ && memcmp(old_, next_, nextCount_ * sizeof(SampleIndexEntry)) == 0) {
+        return true;
+    }
+
+    FIL file;
+    if (f_open(&file, path, (FA_CREATE_ALWAYS | FA_WRITE)) != FR_OK) {
+        return false;
+    }
+    Header header;
+    header.magic = INDEX_MAGIC;
+    header.version = INDEX_VERSION;
+    header.entrySize = sizeof(SampleIndexEntry);
+    header.count = (uint32_t)nextCount_;
+    header.reserved = 0;
+
+    UINT written = 0;
+    UINT bytes = nextCount_ * sizeof(SampleIndexEntry);
+    bool ok = f_write(&file, &header, sizeof(header), &written) == FR_OK && written == sizeof(header) &&
+              f_write(&file, next_, bytes, &written) == FR_OK && written == bytes;
+    ok = (f_close(&file) == FR_OK) && ok;
+    if (!ok) {
+        // A torn index would only be rejected next boot; remove it now
+        f_unlink(path);
+    }
+    return ok;
+}
+
+void SampleIndex::release()
+{
+    custom_pool_free(old_);
+    custom_pool_free(next_);
+    old_ = nullptr;
+    next_ = nullptr;
+    oldCount_ = 0;
+    nextCount_ = 0;
+}
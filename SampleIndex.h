@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include "b3ReadWavFile.h"
+#include "daisy_seed.h"
+#include "Constants.h"
+
+/**
+ * SampleIndexEntry - One WAV's header fields as stored in the index file
+ *
+ * size, date and time are the file's FILINFO stamps when its header was read;
+ * if any differ during a later scan the header is parsed again.
+ */
+struct SampleIndexEntry {
+    char name[32];              // Filename (zero-terminated, as SampleInfo::name)
+    uint32_t size;              // FILINFO::fsize
+    uint16_t date;              // FILINFO::fdate
+    uint16_t time;              // FILINFO::ftime
+    uint32_t numFrames;
+    uint32_t dataType;          // b3ReadWavFile sample type (B3_SINT16, B3_FLOAT32, ...)
+    uint32_t dataOffset;        // Byte offset of the "data" chunk's first frame
+    uint32_t sampleRate;
+    uint16_t channels;
+    uint16_t flags;             // FLAG_BYTESWAP
+};
+
+static_assert(sizeof(SampleIndexEntry) == 60, "SampleIndexEntry layout is part of the file format");
+
+/**
+ * SampleIndex - Cache of WAV header fields on the SD card
+ *
+ * Lets the boot scan set up every unchanged WAV from FILINFO alone, without
+ * opening it. Only new or changed files are parsed; the index file is then
+ * rewritten from what the scan found (so deleted files drop out too).
+ *
+ * Usage during a scan:
+ *   load() - read the previous index
+ *   find() for each WAV, parsing its header on a miss, then add() its entry
+ *   save() - write the new index if anything changed
+ *   release()
+ *
+ * Both entry tables come from the SDRAM pool and are only held during the scan.
+ */
+class SampleIndex {
+public:
+    static constexpr uint16_t FLAG_BYTESWAP = 0x1;
+
+    SampleIndex();
+    ~SampleIndex();
+
+    /**
+     * Read the index file (a missing or invalid file reads as empty)
+     *
+     * @return false if the entry tables cannot be allocated
+     */
+    bool load(const char* path);
+
+    /**
+     * Find the cached header of a WAV whose stamps still match
+     *
+     * @param hint Position to try first (the scan position; directory order rarely changes)
+     * @return Entry, or nullptr if the file is new or has changed
+     */
+    const SampleIndexEntry* find(const FILINFO& file, int hint);
+
+    // Record a WAV for the rewritten index
+    void add(const FILINFO& file, const b3WavInfo& info);
+
+    // Header fields of a cached entry
+    static b3WavInfo toInfo(const SampleIndexEntry& entry);
+
+    /**
+     * Write the index if the scan found anything different from the file
+     *
+     * @return false if the write failed (the next boot just parses more headers)
+     */
+    bool save(const char* path);
+
+    // Free the entry tables
+    void release();
+
+    // Headers reused / parsed during the scan (for the boot message)
+    int getHitCount() const { return hits_; }
+    int getMissCount() const { return misses_; }
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t entrySize;     // sizeof(SampleIndexEntry), so a layout change invalidates the file
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    SampleIndexEntry* old_;     // Entries read by load()
+    int oldCount_;
+    SampleIndexEntry* next_;    // Entries added by this scan
+    int nextCount_;
+    int hits_;
+    int misses_;
+
+    static bool matches(const SampleIndexEntry& entry, const FILINFO& file);
+};
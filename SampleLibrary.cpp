@@ -1,42 +1,91 @@
 #include "Config.h"
 #include "SampleLibrary.h"
-#include <cstdlib>
-
-
-// Helper function to generate random float in range [min, max]
-static float randomFloat(float min, float max) {
-    float random = (float)rand() / (float)RAND_MAX;
-    return min + random * (max - min);
-}
+#include "FatFileDataSource.h"
+#include "SampleBank.h"
+#include "SampleIndex.h"
+#include "AudioProfiler.h"
+#include <cmath>
 
 
 // DEBUG: Variables for granular mode debugging
 static int debugGrainSpawnCount = 0;
 static int debugGrainSpawnFailures = 0;
 
+static_assert(Constants::SampleLibrary::MIP_LEVELS + 1 <= B3_MAX_MIP_LEVELS, "More mip levels than the reader can select");
+
+// Copy interleaved float samples into a buffer in the cache's format, starting at sample first
+static void storeSamples(const float* in, size_t samples, void* dest, size_t first, int format)
+{
+    if (format == B3_DECODED_INT16) {
+        short* out = (short*)dest + first;
+        for (size_t i = 0; i < samples; i++) {
+            float v = in[i] * 32768.0f;
+            if (v > 32767.0f) v = 32767.0f;
+            if (v < -32768.0f) v = -32768.0f;
+            out[i] = (short)v;
+        }
+    } else {
+        memcpy((float*)dest + first, in, samples * sizeof(float));
+    }
+}
+
+// Read interleaved samples from a buffer in the cache's format as floats
+static void loadSamples(const void* src, size_t first, size_t samples, float* out, int format)
+{
+    if (format == B3_DECODED_INT16) {
+        const short* in = (const short*)src + first;
+        for (size_t i = 0; i < samples; i++) {
+            out[i] = in[i] * (1.0f / 32768.0f);
+        }
+    } else {
+        memcpy(out, (const float*)src + first, samples * sizeof(float));
+    }
+}
+
 extern FIL SDFile;
 
+// Audio callback profiler defined in SimpleSampler.cpp
+extern AudioProfiler audioProfiler;
+
 // External declaration for custom memory allocator defined in SimpleSampler.cpp
 extern void* custom_pool_allocate(size_t size);
+extern void custom_pool_free(void* ptr);
 
 
 
 SampleLibrary::SampleLibrary(daisy::SdmmcHandler& sdHandler, FatFSInterface& fileSystem, DisplayManager& display)
     : sampleCount_(0),
+      stopWrite_(0),
+      stopRead_(0),
       activeGrainCount_(0),
       granularModeEnabled_(false),
       granularSampleIndex_(0),
-      timeSinceLastGrain_(0.0f),
+      granularSampleRetained_(false),
+      granularLiveSource_(false),
+      framesUntilGrain_(-1.0),
       spawnRate_(30.0f),  // 30 grains per second default (legacy)
       granularSpawnRate_(30.0f),  // 30 grains per second default
       granularDuration_(0.1f),     // 0.1 seconds default
       granularSpeed_(1.0f),        // Normal speed default
       granularPosition_(0.5f),      // Middle of sample default
+      granularWindow_(WINDOW_HANN),  // Smooth window default
       granularSpawnRateRandom_(0.0f),  // No randomness default
       granularDurationRandom_(0.0f),   // No randomness default
       granularSpeedRandom_(0.0f),      // No randomness default
       granularPositionRandom_(0.0f),   // No randomness default
+      interpolation_(B3_INTERP_HERMITE),
+      interpCeiling_(B3_INTERP_SINC),
+      calmCallbacks_(0),
+      pendingSeed_(0),
+      reseedRequested_(false),
       gateOpen_(false),              // Gate starts closed
+      loaderStage_(LOADER_START),
+      bankEntriesRead_(0),
+      indexed_(false),
+      nextWanted_(0),
+      retiringCount_(0),
+      waitingForRetire_(false),
+      audioBlocks_(0),
       sdHandler_(sdHandler),
       fileSystem_(fileSystem),
       display_(display)
@@ -45,121 +94,661 @@ SampleLibrary::SampleLibrary(daisy::SdmmcHandler& sdHandler, FatFSInterface& fil
     for (int i = 0; i < Constants::SampleLibrary::MAX_SAMPLES; i++) {
         samples_[i].loaded = false;
         samples_[i].audioDataLoaded = false;
+        samples_[i].audioData = nullptr;
+        samples_[i].audioDataSize = 0;
+        samples_[i].file = samples_[i].name;
+        samples_[i].levels = nullptr;
+        samples_[i].levelBlocks = 0;
+        samples_[i].mipmapped = Constants::SampleLibrary::MIPMAP_SAMPLES;
+        samples_[i].mipLevels = 1;
+        samples_[i].mipData[0] = nullptr;
+        samples_[i].mipFrames[0] = 0;
+        samples_[i].mipBytes = 0;
         sampleSpeeds_[i] = 1.0f;
+        sampleInterpolation_[i] = -1;
+        loadWanted_[i] = false;
+        retiring_[i] = false;
+        retiredAt_[i] = 0;
     }
     
-    // Initialize all grains as finished (inactive)
-    for (int i = 0; i < Constants::SampleLibrary::MAX_GRAINS; i++) {
-        grains_[i].ticker.finished_ = true;
-        grains_[i].sampleIndex = -1;
-        grains_[i].envelopePhase = 0.0f;
+    load_.index = -1;
+    load_.buffer = nullptr;
+    load_.input = nullptr;
+    load_.output = nullptr;
+    
+    for (int i = 0; i < NUM_GRAIN_RANDOM_PARAMS; i++) {
+        granularDistribution_[i] = RANDOM_UNIFORM;
     }
+    
 }
 
 bool SampleLibrary::init() {
+    
+    GrainWindow::init();
+    grains_.init(decodeFormat());
+
+    // Reserve the sample cache; audio data is paged into it on demand
+    if (!cache_.init(Constants::Memory::SAMPLE_CACHE_SIZE)) {
+        display_.showMessage("Cache alloc failed!", 200);
+        return false;
+    }
+    
+    // Live input ring for granular; without it only samples can be used
+    live_.init(decodeFormat(), (float)Config::samplerate);
 
-    // Scan directory and load all WAV files
-    return scanAndLoadFiles();
+    // Headers (and then audio) are read by serviceLoader() from the main loop
+    loaderStage_ = LOADER_START;
+    return true;
 }
 
+void SampleLibrary::serviceLoader()
+{
+    // Work in slices so the UI keeps responding while the card is read
+    uint32_t start = System::GetUs();
+    while (loaderStep()) {
+        if (System::GetUs() - start >= Constants::SampleLibrary::LOADER_SLICE_US) {
+            break;
+        }
+    }
+}
 
-bool SampleLibrary::scanAndLoadFiles()
+bool SampleLibrary::loaderStep()
 {
+    // Audio someone is waiting for comes before listing more headers
+    if (load_.index >= 0) {
+        stepDataLoad();
+        return true;
+    }
+    
+    // A load waiting for evicted memory retries once some has come back
+    if (drainRetired()) {
+        waitingForRetire_ = false;
+    }
+    int count = waitingForRetire_ ? 0 : (int)sampleCount_;
+    for (int n = 0; n < count; n++) {
+        int i = (nextWanted_ + n) % count;
+        if (!loadWanted_[i]) {
+            continue;
+        }
+        nextWanted_ = i + 1;
+        if (retiring_[i]) {
+            if (samples_[i].mipmapped != (samples_[i].mipLevels > 1)) {
+                continue;  // Retired to change its octave levels: read it again once freed
+            }
+            // Wanted again before its memory went: the data is still intact
+            retiring_[i] = false;
+            retiringCount_--;
+            samples_[i].audioDataLoaded = true;
+        }
+        if (samples_[i].audioDataLoaded) {
+            loadWanted_[i] = false;
+            cache_.touch(i);
+        } else {
+            beginDataLoad(i);
+        }
+        return true;
+    }
+    
+    switch (loaderStage_) {
+        case LOADER_START:
+            startScan();
+            return true;
+        case LOADER_BANK:
+            scanBankStep();
+            return true;
+        case LOADER_SCAN:
+            scanDirectoryStep();
+            return true;
+        default:
+            return false;
+    }
+}
 
-    // Open the root directory
-    DIR dir;
-    if (f_opendir(&dir, "/") != FR_OK) {
+void SampleLibrary::startScan()
+{
+    // A packed bank replaces the per-file scan
+    if (f_open(&bankFile_, Constants::SampleLibrary::BANK_FILE, (FA_OPEN_EXISTING | FA_READ)) == FR_OK) {
+        UINT bytesRead = 0;
+        if (f_read(&bankFile_, &bank_, sizeof(bank_), &bytesRead) == FR_OK && bytesRead == sizeof(bank_) &&
+            bank_.magic == SAMPLE_BANK_MAGIC && bank_.version == SAMPLE_BANK_VERSION &&
+            (bank_.format == B3_DECODED_FLOAT32 || bank_.format == B3_DECODED_INT16) &&
+            f_lseek(&bankFile_, bank_.indexOffset) == FR_OK) {
+            bankEntriesRead_ = 0;
+            loaderStage_ = LOADER_BANK;
+            return;
+        }
+        f_close(&bankFile_);
+    }
+    
+    if (f_opendir(&scanDir_, "/") != FR_OK) {
         display_.showMessage("Dir open failed!", 200);
-        return false;
+        loaderStage_ = LOADER_READY;
+        return;
     }
+    
+    // Headers of files unchanged since the last boot come from the index, without opening them
+    indexed_ = index_.load(Constants::SampleLibrary::INDEX_FILE);
+    loaderStage_ = LOADER_SCAN;
+}
 
+void SampleLibrary::scanBankStep()
+{
+    uint32_t total = bank_.sampleCount;
+    if (total > (uint32_t)Constants::SampleLibrary::MAX_SAMPLES) {
+        total = Constants::SampleLibrary::MAX_SAMPLES;
+    }
+    uint32_t block = total - bankEntriesRead_;
+    if (block > (uint32_t)Constants::SampleLibrary::BANK_INDEX_BLOCK) {
+        block = Constants::SampleLibrary::BANK_INDEX_BLOCK;
+    }
     
-    // Scan for WAV files
-    FILINFO fno;
-    int fileCount = 0;
+    // Read the index a block of entries at a time (a read error keeps what was listed)
+    SampleBankEntry entries[Constants::SampleLibrary::BANK_INDEX_BLOCK];
+    UINT bytesRead = 0;
+    if (block == 0 || f_read(&bankFile_, entries, block * sizeof(SampleBankEntry), &bytesRead) != FR_OK ||
+        bytesRead != block * sizeof(SampleBankEntry)) {
+        f_close(&bankFile_);
+        finishScan();
+        return;
+    }
     
-    // Read entries in a loop
-    while (f_readdir(&dir, &fno) == FR_OK) {
-        if (fno.fname[0] == 0) break;  // No more files
+    const FSIZE_t bankSize = f_size(&bankFile_);
+    for (uint32_t i = 0; i < block; i++) {
+        SampleBankEntry& entry = entries[i];
+        entry.name[SAMPLE_BANK_NAME_SIZE - 1] = '\0';
         
-        // Check if filename contains .wav or .WAV
-        if (strstr(fno.fname, ".wav") != nullptr || strstr(fno.fname, ".WAV") != nullptr) {
-            if (fileCount < Constants::SampleLibrary::MAX_SAMPLES) {
-                if (loadWavFile(fno.fname, fileCount)) {
-                    fileCount++;
-                }
-            }
+        // Skip entries whose audio would run past the end of the bank
+        uint64_t end = entry.dataOffset + (uint64_t)entry.numFrames * entry.channels *
+                       ((bank_.format == B3_DECODED_INT16) ? sizeof(short) : sizeof(float));
+        if (entry.numFrames == 0 || entry.channels == 0 || entry.sampleRate == 0 || end > bankSize) {
+            continue;
         }
+        int index = sampleCount_;
+        samples_[index].reader.setStoredFrames(entry.numFrames, entry.channels, entry.sampleRate,
+                                               bank_.format, entry.dataOffset);
+        initSampleInfo(index, entry.name, Constants::SampleLibrary::BANK_FILE, entry.bitsPerSample);
+    }
+    bankEntriesRead_ += block;
+}
+
+void SampleLibrary::scanDirectoryStep()
+{
+    FILINFO fno;
+    int index = sampleCount_;
+    if (f_readdir(&scanDir_, &fno) != FR_OK || fno.fname[0] == 0 ||
+        index >= Constants::SampleLibrary::MAX_SAMPLES) {
+        f_closedir(&scanDir_);
+        
+        // Write back only if files were added, changed or removed
+        if (indexed_) {
+            index_.save(Constants::SampleLibrary::INDEX_FILE);
+        }
+        finishScan();
+        index_.release();
+        return;
     }
     
-    // Close directory
-    f_closedir(&dir);
+    // Check if filename contains .wav or .WAV
+    if (strstr(fno.fname, ".wav") == nullptr && strstr(fno.fname, ".WAV") == nullptr) {
+        return;
+    }
     
+    const SampleIndexEntry* cached = indexed_ ? index_.find(fno, index) : nullptr;
+    if (cached != nullptr) {
+        samples_[index].reader.setInfo(SampleIndex::toInfo(*cached));
+        initSampleInfo(index, fno.fname, nullptr, samples_[index].reader.getBitsPerSample());
+    } else if (!loadSampleInfo(fno.fname, index)) {
+        return;
+    }
+    index_.add(fno, samples_[index].reader.getInfo());
+}
+
+void SampleLibrary::finishScan()
+{
     char msg[64];
-    snprintf(msg, sizeof(msg), "WAV Files: %d", fileCount);
+    if (loaderStage_ == LOADER_BANK) {
+        snprintf(msg, sizeof(msg), "Bank: %d samples", (int)sampleCount_);
+    } else {
+        snprintf(msg, sizeof(msg), "WAV Files: %d (%d new)", (int)sampleCount_, index_.getMissCount());
+    }
+    loaderStage_ = LOADER_READY;
     display_.showMessage(msg, 200);
+}
+
+void SampleLibrary::initSampleInfo(int index, const char* name, const char* file, int bitsPerSample)
+{
+    SampleInfo& sample = samples_[index];
     
-    // Store the number of loaded samples
-    sampleCount_ = fileCount;
+    // Copy filename to SampleInfo (also used to reopen the file later)
+    strncpy(sample.name, name, sizeof(sample.name) - 1);
+    sample.name[sizeof(sample.name) - 1] = '\0';
+    sample.file = (file != nullptr) ? file : sample.name;
     
-    return true;
+    // Copy metadata from reader to SampleInfo
+    sample.numFrames = sample.reader.getNumFrames();
+    sample.channels = sample.reader.getChannels();
+    sample.sampleRate = (int)sample.reader.getFileDataRate();
+    sample.bitsPerSample = bitsPerSample;
+    sample.playFrames = sample.numFrames;
+    sample.playRate = sample.sampleRate;
+    
+    // Large samples keep only their head in SDRAM and stream the rest
+    size_t size = sample.reader.getDecodedSize(decodeFormat());
+    sample.streamed = size > Constants::Streaming::STREAM_THRESHOLD_BYTES &&
+                      sample.channels <= 2 &&
+                      streamer_.init(decodeFormat());
+    sample.residentFrames = sample.streamed ? SampleStreamer::residentFramesFor(sample) : 0;
+    
+    // Mark metadata as loaded
+    sample.loaded = true;
+    sample.audioDataLoaded = false;
+    
+    // List it last, so nothing sees a half-filled entry
+    if (index >= sampleCount_) {
+        sampleCount_ = index + 1;
+    }
 }
 
-
-bool SampleLibrary::loadWavFile(const char* filename, int index)
+bool SampleLibrary::loadSampleInfo(const char* filename, int index)
 {
     // Open the file using the global SDFile
     if (f_open(&SDFile, filename, (FA_OPEN_EXISTING | FA_READ)) != FR_OK) {
-        display_.showMessagef("Open failed!", 200);
         return false;
     }
     
-    int size = f_size(&SDFile);
+    // Parse the header straight from the card; audio data is paged in later
+    FatFileDataSource dataSource(&SDFile);
+    bool ok = samples_[index].reader.getWavInfo(dataSource);
+    f_close(&SDFile);
+    if (!ok) {
+        return false;
+    }
     
-    // Allocate memory from custom pool
-    char* memoryBuffer = (char*) custom_pool_allocate(size);
+    initSampleInfo(index, filename, nullptr, samples_[index].reader.getBitsPerSample());
     
-    if (!memoryBuffer) {
-        display_.showMessagef("Alloc failed!", 200);
-        f_close(&SDFile);
-        return false;
+    return true;
+}
+
+bool SampleLibrary::beginDataLoad(int index)
+{
+    SampleInfo& sample = samples_[index];
+    DataLoad& load = load_;
+    int format = decodeFormat();
+    load.buffer = nullptr;
+    const size_t frameSize = sample.reader.getDecodedFrameSize(format);
+    
+    // Files at another rate are converted once here, so playback at unity
+    // speed takes the integer path instead of interpolating every frame
+    load.convert = Constants::SampleLibrary::CONVERT_SAMPLE_RATE && !sample.streamed &&
+                   sample.sampleRate != Config::samplerate &&
+                   load.converter.init(sample.sampleRate, Config::samplerate);
+    
+    // Streamed samples only need their head (plus guard frames) resident
+    uint32_t decodeFrames = sample.numFrames;
+    size_t size = sample.reader.getDecodedSize(format);
+    if (load.convert) {
+        decodeFrames = SampleRateConverter::outputFrames(sample.numFrames, sample.sampleRate, Config::samplerate);
+        size = (decodeFrames + B3_DECODED_GUARD_FRAMES) * frameSize;
+    } else if (sample.streamed) {
+        size = (sample.residentFrames + SampleStreamer::GUARD_FRAMES) * frameSize;
+        decodeFrames = sample.residentFrames + SampleStreamer::GUARD_FRAMES;
+        if (decodeFrames > (uint32_t)sample.numFrames) {
+            decodeFrames = sample.numFrames;
+        }
+    }
+    
+    // Octave levels follow the decoded frames in the same buffer, each with its own guard frames
+    load.baseSize = size;
+    load.levels = 1;
+    load.offsets[0] = 0;
+    load.frames[0] = decodeFrames;
+    if (sample.mipmapped && !sample.streamed) {
+        while (load.levels <= Constants::SampleLibrary::MIP_LEVELS && load.frames[load.levels - 1] > 1) {
+            load.frames[load.levels] = SampleRateConverter::outputFrames(load.frames[load.levels - 1], 2, 1);
+            load.offsets[load.levels] = size;
+            size += (load.frames[load.levels] + B3_DECODED_GUARD_FRAMES) * frameSize;
+            load.levels++;
+        }
     }
+    load.size = size;
     
+    // Chunk scratch for the rate converter and the halfband (without it, skip the octaves)
+    const int chunk = Constants::SampleLibrary::SRC_CHUNK_FRAMES;
+    size_t inCapacity = (size_t)chunk * 2 + SampleRateConverter::TAPS + 2;
+    if (load.convert) {
+        size_t convertCapacity = (size_t)((uint64_t)chunk * sample.sampleRate / Config::samplerate) + SampleRateConverter::TAPS + 2;
+        inCapacity = (convertCapacity > inCapacity) ? convertCapacity : inCapacity;
+    }
+    load.input = nullptr;
+    load.output = nullptr;
+    if (load.convert || load.levels > 1) {
+        load.input = (float*)custom_pool_allocate(inCapacity * sample.channels * sizeof(float));
+        load.output = (float*)custom_pool_allocate((size_t)chunk * sample.channels * sizeof(float));
+        if (load.input == nullptr || load.output == nullptr) {
+            custom_pool_free(load.input);
+            custom_pool_free(load.output);
+            load.input = nullptr;
+            load.output = nullptr;
+            load.levels = 1;
+            load.size = load.baseSize;
+            if (load.convert) {
+                load.converter.release();
+                loadWanted_[index] = false;
+                display_.showMessagef("Out of memory!", 200);
+                return false;
+            }
+        }
+    }
     
-    UINT bytesRead;
-    if (f_read(&SDFile, memoryBuffer, size, &bytesRead) != FR_OK || bytesRead != size) {
-        display_.showMessagef("Read failed!", 200);
-        f_close(&SDFile);
+    // Make room in the cache, evicting least-recently-used samples as needed.
+    // Victims are retired rather than freed: a callback may have started a voice
+    // or grain on one since it was found idle, so its memory comes back later
+    // and this load is retried then.
+    void* memoryBuffer = cache_.allocate(index, load.size);
+    if (memoryBuffer == nullptr) {
+        bool busy[Constants::SampleLibrary::MAX_SAMPLES];
+        for (int i = 0; i < Constants::SampleLibrary::MAX_SAMPLES; i++) {
+            busy[i] = (i < sampleCount_) && (retiring_[i] || isSamplePlaying(i));
+        }
+        int victim = cache_.findVictim(busy);
+        if (victim < 0 && retiringCount_ == 0) {
+            load.index = index;
+            cancelDataLoad("Cache full!");
+            return false;
+        }
+        if (victim >= 0) {
+            retireSample(victim);
+        }
+        load.converter.release();
+        custom_pool_free(load.input);
+        custom_pool_free(load.output);
+        load.input = nullptr;
+        load.output = nullptr;
+        waitingForRetire_ = true;
         return false;
     }
+    load.buffer = memoryBuffer;
+    load.index = index;
     
+    if (f_open(&load.file, sample.file, (FA_OPEN_EXISTING | FA_READ)) != FR_OK) {
+        cache_.release(index);
+        load.buffer = nullptr;
+        cancelDataLoad("Open failed!");
+        return false;
+    }
     
-    samples_[index].dataSource = MemoryDataSource(memoryBuffer, size);
-    samples_[index].reader.getWavInfo(samples_[index].dataSource);
+    // Every frame of every level gets written; only the guard frames after each need zeroing
+    for (int level = 0; level < load.levels; level++) {
+        size_t start = load.offsets[level] + (size_t)load.frames[level] * frameSize;
+        size_t end = (level + 1 < load.levels) ? load.offsets[level + 1] : load.size;
+        memset((char*)memoryBuffer + start, 0, end - start);
+    }
+    load.level = 0;
+    load.done = 0;
+    return true;
+}
+
+void SampleLibrary::stepDataLoad()
+{
+    DataLoad& load = load_;
+    SampleInfo& sample = samples_[load.index];
+    int format = decodeFormat();
     
-    // Copy filename to SampleInfo
-    strncpy(samples_[index].name, filename, sizeof(samples_[index].name) - 1);
-    samples_[index].name[sizeof(samples_[index].name) - 1] = '\0';
+    // Plain decoding is a straight read (or a cheap conversion), so it takes bigger chunks
+    int chunk = (load.level == 0 && !load.convert) ? Constants::SampleLibrary::LOAD_CHUNK_FRAMES
+                                                  : Constants::SampleLibrary::SRC_CHUNK_FRAMES;
+    uint32_t total = load.frames[load.level];
+    int count = (total - load.done < (uint32_t)chunk) ? (int)(total - load.done) : chunk;
     
-    // Copy WAV metadata from reader to SampleInfo
-    samples_[index].numFrames = samples_[index].reader.getNumFrames();
-    samples_[index].channels = samples_[index].reader.getChannels();
-    samples_[index].sampleRate = (int)samples_[index].reader.getFileDataRate();
-    samples_[index].bitsPerSample = samples_[index].reader.getBitsPerSample();
+    // Decode once here so playback never touches the raw WAV bytes
+    bool ok = true;
+    if (load.level > 0) {
+        buildMipChunk(load.level, load.done, count);
+    } else if (load.convert) {
+        ok = convertChunk(load.done, count);
+    } else {
+        FatFileDataSource dataSource(&load.file);
+        char* dest = (char*)load.buffer + (size_t)load.done * sample.reader.getDecodedFrameSize(format);
+        ok = sample.reader.decodeFrames(dataSource, load.done, count, dest, format);
+    }
+    if (!ok) {
+        cancelDataLoad("Read failed!");
+        return;
+    }
+    load.done += count;
+    if (load.done < total) {
+        return;
+    }
     
-    // Mark sample as loaded
-    samples_[index].loaded = true;
-    samples_[index].audioDataLoaded = true;
+    // Level finished: the octaves are each filtered from the one above
+    // (without the memory for the halfband, play unfiltered)
+    if (load.level == 0) {
+        f_close(&load.file);
+        if (load.levels > 1 && !load.converter.init(2, 1)) {
+            load.levels = 1;
+        }
+    }
+    load.level++;
+    load.done = 0;
+    if (load.level < load.levels) {
+        return;
+    }
     
-    wavTickers_[index] = samples_[index].reader.createWavTicker(Config::samplerate);
-    wavTickers_[index].finished_ = true;
+    load.converter.release();
+    custom_pool_free(load.input);
+    custom_pool_free(load.output);
+    load.input = nullptr;
+    load.output = nullptr;
     
-    display_.showMessagef("Loaded: %s", 200, filename);
+    if (load.convert) {
+        sample.reader.setDecodedFrames(load.buffer, format, load.frames[0], Config::samplerate);
+        sample.playFrames = load.frames[0];
+        sample.playRate = Config::samplerate;
+    } else {
+        sample.reader.setDecodedFrames(load.buffer, format);
+        sample.playFrames = sample.numFrames;
+        sample.playRate = sample.sampleRate;
+    }
+    for (int level = 0; level < load.levels; level++) {
+        sample.mipData[level] = (const char*)load.buffer + load.offsets[level];
+        sample.mipFrames[level] = load.frames[level];
+    }
+    sample.mipLevels = load.levels;
+    sample.mipBytes = (load.levels > 1) ? load.size - load.baseSize : 0;
+    sample.reader.setMipLevels(sample.mipData, load.levels);
+    sample.audioData = load.buffer;
+    sample.audioDataSize = load.size;
+    buildLevelEnvelope(load.index, load.frames[0]);
     
-    f_close(&SDFile);
+    // Publish last, so the audio callback never sees a half-filled buffer
+    sample.audioDataLoaded = true;
+    loadWanted_[load.index] = false;
+    load.index = -1;
+}
+
+void SampleLibrary::cancelDataLoad(const char* message)
+{
+    DataLoad& load = load_;
+    if (load.buffer != nullptr) {
+        if (load.level == 0) {
+            f_close(&load.file);
+        }
+        cache_.release(load.index);
+        load.buffer = nullptr;
+    }
+    load.converter.release();
+    custom_pool_free(load.input);
+    custom_pool_free(load.output);
+    load.input = nullptr;
+    load.output = nullptr;
+    loadWanted_[load.index] = false;
+    load.index = -1;
+    if (message != nullptr) {
+        display_.showMessagef(message, 200);
+    }
+}
+
+void SampleLibrary::retireSample(int index)
+{
+    // Nothing new starts on it from the next callback on
+    samples_[index].audioDataLoaded = false;
+    retiring_[index] = true;
+    retiredAt_[index] = audioBlocks_;
+    retiringCount_++;
+}
+
+bool SampleLibrary::drainRetired()
+{
+    if (retiringCount_ == 0) {
+        return false;
+    }
+    bool freed = false;
+    uint32_t blocks = audioBlocks_;
+    for (int i = 0; i < Constants::SampleLibrary::MAX_SAMPLES; i++) {
+        // Two counts on, the callback that was running at retire time has ended
+        // and a whole one has run with the sample marked unloaded
+        if (!retiring_[i] || blocks - retiredAt_[i] < 2) {
+            continue;
+        }
+        if (isSamplePlaying(i)) {
+            // Started just before the retire; wait for it to finish
+            retiredAt_[i] = blocks;
+            continue;
+        }
+        retiring_[i] = false;
+        retiringCount_--;
+        unloadSampleData(i);
+        freed = true;
+    }
+    return freed;
+}
+
+void SampleLibrary::unloadSampleData(int index)
+{
+    SampleInfo& sample = samples_[index];
+    
+    // Stop anything from starting on it before the memory goes away
+    sample.audioDataLoaded = false;
+    sample.reader.setDecodedFrames(nullptr, decodeFormat());
+    sample.audioData = nullptr;
+    sample.audioDataSize = 0;
+    sample.mipLevels = 1;
+    sample.mipData[0] = nullptr;
+    sample.mipBytes = 0;
+    custom_pool_free(sample.levels);
+    sample.levels = nullptr;
+    sample.levelBlocks = 0;
+    cache_.release(index);
+}
+
+bool SampleLibrary::convertChunk(uint32_t outFirst, int count)
+{
+    SampleInfo& sample = samples_[load_.index];
+    const int channels = sample.channels;
+    const int64_t numFrames = sample.numFrames;
+    int64_t first;
+    int64_t last;
+    load_.converter.inputRange(outFirst, count, first, last);
+    
+    // Frames before the start or past the end of the sample are silence
+    float* input = load_.input;
+    memset(input, 0, (size_t)(last - first + 1) * channels * sizeof(float));
+    int64_t from = (first > 0) ? first : 0;
+    int64_t to = (last < numFrames - 1) ? last : numFrames - 1;
+    if (to >= from) {
+        FatFileDataSource dataSource(&load_.file);
+        if (!sample.reader.decodeFrames(dataSource, (unsigned long)from, (unsigned long)(to - from + 1),
+                                        input + (from - first) * channels, B3_DECODED_FLOAT32)) {
+            return false;
+        }
+    }
+    load_.converter.process(input, first, channels, outFirst, count, load_.output);
+    storeSamples(load_.output, (size_t)count * channels, load_.buffer, (size_t)outFirst * channels, decodeFormat());
     return true;
 }
 
+void SampleLibrary::buildMipChunk(int level, uint32_t outFirst, int count)
+{
+    const int channels = samples_[load_.index].channels;
+    const int format = decodeFormat();
+    const void* src = (const char*)load_.buffer + load_.offsets[level - 1];
+    const int64_t srcFrames = load_.frames[level - 1];
+    void* dest = (char*)load_.buffer + load_.offsets[level];
+    int64_t first;
+    int64_t last;
+    load_.converter.inputRange(outFirst, count, first, last);
+    
+    // Frames outside the level are silence
+    float* input = load_.input;
+    memset(input, 0, (size_t)(last - first + 1) * channels * sizeof(float));
+    int64_t from = (first > 0) ? first : 0;
+    int64_t to = (last < srcFrames - 1) ? last : srcFrames - 1;
+    if (to >= from) {
+        loadSamples(src, (size_t)from * channels, (size_t)(to - from + 1) * channels,
+                    input + (from - first) * channels, format);
+    }
+    load_.converter.process(input, first, channels, outFirst, count, load_.output);
+    storeSamples(load_.output, (size_t)count * channels, dest, (size_t)outFirst * channels, format);
+}
+
+void SampleLibrary::buildLevelEnvelope(int index, uint32_t decodedFrames)
+{
+    SampleInfo& sample = samples_[index];
+    uint32_t blockFrames = Constants::SampleLibrary::LEVEL_BLOCK_FRAMES;
+    uint32_t blocks = (decodedFrames + blockFrames - 1) / blockFrames;
+    
+    custom_pool_free(sample.levels);
+    sample.levelBlocks = 0;
+    sample.levels = (blocks > 0) ? (uint8_t*)custom_pool_allocate(blocks) : nullptr;
+    if (sample.levels == nullptr) {
+        return;  // Unknown level: stealing falls back to age
+    }
+    
+    // Peak of each block across all channels
+    uint32_t stride = sample.channels;
+    for (uint32_t block = 0; block < blocks; block++) {
+        uint32_t first = block * blockFrames * stride;
+        uint32_t last = first + blockFrames * stride;
+        if (last > decodedFrames * stride) {
+            last = decodedFrames * stride;
+        }
+        
+        float peak = 0.0f;
+        if (decodeFormat() == B3_DECODED_INT16) {
+            const short* data = (const short*)sample.audioData;
+            for (uint32_t i = first; i < last; i++) {
+                float value = fabsf(data[i] * (1.0f / 32768.0f));
+                peak = (value > peak) ? value : peak;
+            }
+        } else {
+            const float* data = (const float*)sample.audioData;
+            for (uint32_t i = first; i < last; i++) {
+                float value = fabsf(data[i]);
+                peak = (value > peak) ? value : peak;
+            }
+        }
+        sample.levels[block] = (uint8_t)(fminf(peak, 1.0f) * 255.0f + 0.5f);
+    }
+    sample.levelBlocks = blocks;
+}
+
+bool SampleLibrary::isSamplePlaying(int index) const
+{
+    // Scan the slots rather than the active list: the links belong to the audio callback
+    for (int i = 0; i < VoicePool::POOL_SIZE; i++) {
+        const Voice& voice = voices_.getVoice(i);
+        if (voice.active && voice.sampleIndex == index) {
+            return true;
+        }
+    }
+    return grains_.isPlaying(index);
+}
+
+int SampleLibrary::decodeFormat()
+{
+    return Constants::SampleLibrary::DECODE_TO_INT16 ? B3_DECODED_INT16 : B3_DECODED_FLOAT32;
+}
+
 // Get a sample by index
 SampleInfo* SampleLibrary::getSample(int index) {
     // Check bounds
@@ -179,119 +768,213 @@ int SampleLibrary::findSample(const char* name) {
     return -1;
 }
 
-// Load audio data for a sample (lazy loading)
-// Call this before playing a sample if audioDataLoaded is false
-bool SampleLibrary::ensureSampleLoaded(int index) {
+bool SampleLibrary::requestSampleLoad(int index) {
     // Check bounds
     if (index < 0 || index >= sampleCount_) {
         return false;
     }
     
-    // If already loaded, return true
+    // If already loaded, just mark it as recently used
     if (samples_[index].audioDataLoaded) {
+        cache_.touch(index);
         return true;
     }
+    loadWanted_[index] = true;
+    return true;
+}
+
+bool SampleLibrary::retainSample(int index) {
+    if (!requestSampleLoad(index)) {
+        return false;
+    }
+    cache_.pin(index);
+    return true;
+}
+
+SampleLoaderProgress SampleLibrary::getLoaderProgress() const {
+    SampleLoaderProgress progress;
+    progress.scanning = loaderStage_ != LOADER_READY;
+    progress.samplesFound = sampleCount_;
+    progress.scanTotal = -1;
+    if (loaderStage_ == LOADER_BANK) {
+        progress.scanTotal = (bank_.sampleCount < (uint32_t)Constants::SampleLibrary::MAX_SAMPLES) ?
+                             (int)bank_.sampleCount : Constants::SampleLibrary::MAX_SAMPLES;
+    } else if (loaderStage_ == LOADER_READY) {
+        progress.scanTotal = sampleCount_;
+    }
+    
+    // Frames written across every level of the sample being loaded
+    progress.loadingSample = load_.index;
+    progress.loadPercent = 0;
+    if (load_.index >= 0) {
+        uint64_t total = 0;
+        uint64_t done = load_.done;
+        for (int level = 0; level < load_.levels; level++) {
+            total += load_.frames[level];
+            if (level < load_.level) {
+                done += load_.frames[level];
+            }
+        }
+        progress.loadPercent = (total > 0) ? (int)(done * 100 / total) : 0;
+    }
     
-    // Note: In the current implementation, audio data is loaded during init()
-    // This method is provided for future lazy loading support
-    // For now, return the current state
-    return samples_[index].audioDataLoaded;
+    progress.queued = 0;
+    for (int i = 0; i < sampleCount_; i++) {
+        if (loadWanted_[i]) {
+            progress.queued++;
+        }
+    }
+    return progress;
+}
+
+void SampleLibrary::releaseSample(int index) {
+    if (index >= 0 && index < sampleCount_) {
+        cache_.unpin(index);
+    }
+}
+
+void SampleLibrary::serviceStreams() {
+    streamer_.service(samples_);
 }
 
 void SampleLibrary::processAudio(float** out, size_t size) {
+    ScopedProfile profile(audioProfiler, STAGE_SAMPLES);
+    
     // Clear output buffers to zero
     for (size_t i = 0; i < size; i++) {
         out[0][i] = 0.0f;
         out[1][i] = 0.0f;
     }
     
+    // Grains get the budget the voices leave (drums beat grains); voices
+    // started since the last block have already taken their share back
+    grains_.setBudget(voices_.getGrainBudget());
+    
     // Auto-spawning: Only spawn if granular mode is enabled AND gate is open
+    uint32_t grainStart = AudioProfiler::now();
     if (granularModeEnabled_ && gateOpen_) {
-        // Calculate the duration of this audio block in seconds
-        float blockDuration = (float)size / Config::samplerate;
-        
-        // Update the time elapsed since last grain spawn
-        timeSinceLastGrain_ += blockDuration;
+        refillGrainRandom();
         
-        // Calculate spawn interval from spawn rate (grains per second)
-        float spawnInterval = 1.0f / granularSpawnRate_;
+        // First block after the gate opens: the first grain is one interval away
+        if (framesUntilGrain_ < 0.0) {
+            framesUntilGrain_ = nextGrainInterval();
+        }
         
-        // Check if it's time to spawn a new grain
-        while (timeSinceLastGrain_ >= spawnInterval) {
-            // Spawn grain using configurable parameters
-            // sampleIndex=-1 (use granularSampleIndex_), startPosition=granularPosition_, duration=granularDuration_, speed=granularSpeed_
-            spawnGrain(-1, granularPosition_, granularDuration_, granularSpeed_);
-            
-            // Reset timer (subtract interval to handle multiple spawns per block)
-            timeSinceLastGrain_ -= spawnInterval;
-            
-            // Clamp to 0 to prevent negative values
-            if (timeSinceLastGrain_ < 0.0f) {
-                timeSinceLastGrain_ = 0.0f;
-            }
+        // Spawn every grain due in this block at the frame it falls on
+        // sampleIndex=-1 (use granularSampleIndex_), startPosition=granularPosition_, duration=granularDuration_, speed=granularSpeed_
+        while (framesUntilGrain_ < (double)size) {
+            spawnGrain(-1, granularPosition_, granularDuration_, granularSpeed_, (int)framesUntilGrain_);
+            framesUntilGrain_ += nextGrainInterval();
         }
+        
+        // Carry the remainder into the next block
+        framesUntilGrain_ -= (double)size;
     } else if (!gateOpen_) {
-        // Reset timer when gate is closed to prevent burst of grains on open
-        timeSinceLastGrain_ = 0.0f;
+        // Disarm the timer when gate is closed to prevent burst of grains on open
+        framesUntilGrain_ = -1.0;
     }
     
-    // Process regular sample playback (existing functionality)
-    for (int i = 0; i < sampleCount_; i++) {
-        if (!wavTickers_[i].finished_) {
-            samples_[i].reader.tick(
-                &wavTickers_[i],
-                samples_[i].dataSource,
-                sampleSpeeds_[i],
-                1.0,
-                size,
-                out[0],
-                out[1]
-            );
-        }
+    // Grains share the headroom equally
+    activeGrainCount_ = grains_.getActiveCount();
+    if (activeGrainCount_ > 0) {
+        float grainVolume = 1.0f / activeGrainCount_;
+        grains_.render(grainVolume, out[0], out[1], size);
+    } else {
+        grains_.render(0.0f, out[0], out[1], size);  // Still applies a pending clear
+    }
+    if (granularModeEnabled_ || activeGrainCount_ > 0) {
+        audioProfiler.add(STAGE_GRAINS, grainStart);
     }
     
-    // First pass: count active grains
-    activeGrainCount_ = 0;
-    for (int i = 0; i < Constants::SampleLibrary::MAX_GRAINS; i++) {
-        if (!grains_[i].ticker.finished_) {
-            activeGrainCount_++;
+    // Render every live voice (stops queued by the main loop were applied at
+    // the start of the callback, before the sequencer and grains); finished ones go back to the free list
+    int next;
+    for (int i = voices_.firstActive(); i >= 0; i = next) {
+        next = voices_.nextActive(i);
+        if (!renderVoice(voices_.getVoice(i), out, size)) {
+            stopVoice(i);
         }
     }
+}
+
+bool SampleLibrary::renderVoice(Voice& voice, float** out, size_t size)
+{
+    if (voice.ticker.finished_) {
+        return false;
+    }
+    SampleInfo& sample = samples_[voice.sampleIndex];
     
-    // Calculate uniform volume for all grains
-    float grainVolume = (activeGrainCount_ > 0) ? (1.0f / activeGrainCount_) : 0.0f;
-    
-    // Second pass: process all active grains
-    for (int i = 0; i < Constants::SampleLibrary::MAX_GRAINS; i++) {
-        if (!grains_[i].ticker.finished_) {
-            int sampleIndex = grains_[i].sampleIndex;
-            double speed = grains_[i].ticker.speed_;
-            
-            samples_[sampleIndex].reader.tick(
-                &grains_[i].ticker,
-                samples_[sampleIndex].dataSource,
-                speed,
-                grainVolume,
-                size,
-                out[0],
-                out[1]
-            );
+    if (voice.streamVoice >= 0) {
+        // Voice may have been stolen by another streamed sample
+        if (!streamer_.ownsVoice(voice.streamVoice, voice.sampleIndex)) {
+            voice.streamVoice = -1;
+            return false;
         }
+        streamer_.render(voice.streamVoice, sample, voice.ticker, sampleSpeeds_[voice.sampleIndex],
+                         voice.volume, size, out[0], out[1], interpCeiling_);
+    } else {
+        sample.reader.tick(&voice.ticker, sampleSpeeds_[voice.sampleIndex], voice.volume, size, out[0], out[1],
+                           interpCeiling_);
+    }
+    return !voice.ticker.finished_;
+}
+
+void SampleLibrary::stopVoice(int voiceIndex)
+{
+    Voice& voice = voices_.getVoice(voiceIndex);
+    if (voice.streamVoice >= 0 && streamer_.ownsVoice(voice.streamVoice, voice.sampleIndex)) {
+        streamer_.release(voice.streamVoice);
+    }
+    voice.streamVoice = -1;
+    voices_.release(voiceIndex);
+}
+
+int SampleLibrary::allocateVoice(int priority)
+{
+    int voiceIndex = voices_.allocate(priority);
+    if (voiceIndex < 0) {
+        int victim = voices_.findVictim(priority);
+        if (victim < 0) {
+            return -1;
+        }
+        stopVoice(victim);
+        voices_.countSteal();
+        voiceIndex = voices_.allocate(priority);
+    }
+    return voiceIndex;
+}
+
+void SampleLibrary::requestStopVoices(int priority, int owner)
+{
+    uint32_t write = stopWrite_;
+    if (write - stopRead_ >= (uint32_t)Constants::Voices::STOP_QUEUE_SIZE) {
+        return;  // Queue full; voices play out (isSamplePlaying still guards eviction)
+    }
+    stopQueue_[write % Constants::Voices::STOP_QUEUE_SIZE].priority = priority;
+    stopQueue_[write % Constants::Voices::STOP_QUEUE_SIZE].owner = owner;
+    stopWrite_ = write + 1;
+}
+
+void SampleLibrary::processStopRequests()
+{
+    while (stopRead_ != stopWrite_) {
+        const StopRequest& request = stopQueue_[stopRead_ % Constants::Voices::STOP_QUEUE_SIZE];
+        int next;
+        for (int i = voices_.firstActive(); i >= 0; i = next) {
+            next = voices_.nextActive(i);
+            const Voice& voice = voices_.getVoice(i);
+            if (voice.priority == request.priority && (request.owner < 0 || voice.owner == request.owner)) {
+                stopVoice(i);
+            }
+        }
+        stopRead_ = stopRead_ + 1;
     }
 }
 
 // Trigger a sample to start playing
 bool SampleLibrary::triggerSample(int index) {
-    // Validate index bounds
-    if (index < 0 || index >= sampleCount_) {
-        return false;
-    }
-    
-    // Reset the ticker to the start position
-    wavTickers_[index].time_ = wavTickers_[index].starttime_;
-    wavTickers_[index].finished_ = false;
-    
-    return true;
+    // One voice per sample: retriggering restarts it
+    return triggerVoice(index, VOICE_PRIORITY_SAMPLE, index, 1, STEAL_OLDEST, 1.0f);
 }
 
 // Stop a currently playing sample
@@ -301,9 +984,7 @@ bool SampleLibrary::stopSample(int index) {
         return false;
     }
     
-    // Mark the sample as finished (stopped)
-    wavTickers_[index].finished_ = true;
-    
+    requestStopVoices(VOICE_PRIORITY_SAMPLE, index);
     return true;
 }
 
@@ -315,57 +996,233 @@ void SampleLibrary::setSampleSpeed(int index, float speed) {
     }
 }
 
-// Spawn a new grain from a sample
-bool SampleLibrary::spawnGrain(int sampleIndex, float startPosition, float duration, float speed) {
-    // Use granularSampleIndex_ if sampleIndex is -1
-    int actualSampleIndex = sampleIndex;
-    if (sampleIndex < 0) {
-        actualSampleIndex = granularSampleIndex_;
+float SampleLibrary::getSampleSpeed(int index) const {
+    if (index >= 0 && index < sampleCount_) {
+        return sampleSpeeds_[index];
+    }
+    return 1.0f;
+}
+
+void SampleLibrary::setSampleMipmapped(int index, bool enabled) {
+    if (index < 0 || index >= sampleCount_ || samples_[index].mipmapped == enabled) {
+        return;
+    }
+    SampleInfo& sample = samples_[index];
+    sample.mipmapped = enabled;
+    if (sample.streamed) {
+        return;  // Never has levels
     }
     
-    // Validate sample index
-    if (actualSampleIndex < 0 || actualSampleIndex >= sampleCount_) {
-        debugGrainSpawnFailures++;
+    // Resident (or half read) with the other layout: read it again if it is still
+    // wanted, otherwise just let it go (it gets the new layout when next loaded)
+    bool wanted = cache_.isPinned(index);
+    if (load_.index == index) {
+        cancelDataLoad(nullptr);
+        wanted = true;
+    } else if (sample.audioDataLoaded && enabled != (sample.mipLevels > 1)) {
+        retireSample(index);
+    } else {
+        return;
+    }
+    loadWanted_[index] = wanted;
+}
+
+bool SampleLibrary::isSampleMipmapped(int index) const {
+    return index >= 0 && index < sampleCount_ && samples_[index].mipmapped;
+}
+
+SampleLibraryStats SampleLibrary::getStats() const {
+    SampleLibraryStats stats;
+    stats.cacheCapacity = cache_.getCapacity();
+    stats.cacheUsedBytes = cache_.getUsedBytes();
+    stats.mipBytes = 0;
+    stats.cachedSamples = 0;
+    stats.mippedSamples = 0;
+    for (int i = 0; i < sampleCount_; i++) {
+        if (!samples_[i].audioDataLoaded) {
+            continue;
+        }
+        stats.cachedSamples++;
+        if (samples_[i].mipLevels > 1) {
+            stats.mippedSamples++;
+            stats.mipBytes += samples_[i].mipBytes;
+        }
+    }
+    return stats;
+}
+
+// Start a pooled voice on a sample
+bool SampleLibrary::triggerVoice(int index, int priority, int owner, int maxPerOwner,
+                                 VoiceStealMode stealMode, float volume) {
+    // Validate index bounds
+    if (index < 0 || index >= sampleCount_) {
         return false;
     }
     
-    // Validate sample is loaded
-    if (!samples_[actualSampleIndex].audioDataLoaded) {
-        debugGrainSpawnFailures++;
+    // Audio data must have been paged in (queued by requestSampleLoad / retainSample,
+    // read by the loader; see getLoaderProgress)
+    SampleInfo& sample = samples_[index];
+    if (!sample.audioDataLoaded) {
         return false;
     }
+    cache_.touch(index);
     
-    // Find an available grain slot
-    int availableSlot = -1;
-    for (int i = 0; i < Constants::SampleLibrary::MAX_GRAINS; i++) {
-        if (grains_[i].ticker.finished_) {
-            availableSlot = i;
+    // Look for a voice to reuse: the sample's stream voice (there is only one ring
+    // per streamed sample), or one of the owner's own voices once it is at its limit
+    int reuse = -1;
+    int ownerVoices = 0;
+    float reuseLevel = 0.0f;
+    for (int i = voices_.firstActive(); i >= 0; i = voices_.nextActive(i)) {
+        const Voice& voice = voices_.getVoice(i);
+        if (sample.streamed && voice.streamVoice >= 0 && voice.sampleIndex == index) {
+            reuse = i;
+            ownerVoices = maxPerOwner;
             break;
         }
+        if (voice.priority != priority || voice.owner != owner) {
+            continue;
+        }
+        ownerVoices++;
+        
+        float level = (stealMode == STEAL_QUIETEST) ? getVoiceLevel(voice) : 0.0f;
+        
+        // Quietest first (always equal in STEAL_OLDEST), then oldest (wrap-safe)
+        if (reuse < 0 || level < reuseLevel ||
+            (level == reuseLevel && (int32_t)(voice.startOrder - voices_.getVoice(reuse).startOrder) < 0)) {
+            reuse = i;
+            reuseLevel = level;
+        }
     }
     
-    // No available slot
-    if (availableSlot < 0) {
-        debugGrainSpawnFailures++;
+    int voiceIndex;
+    if (reuse >= 0 && ownerVoices >= maxPerOwner) {
+        // Restart in place, keeping a stream voice that belongs to this sample
+        int streamVoice = voices_.getVoice(reuse).streamVoice;
+        voices_.getVoice(reuse).streamVoice = -1;
+        stopVoice(reuse);
+        voiceIndex = allocateVoice(priority);
+        if (voiceIndex >= 0) {
+            voices_.getVoice(voiceIndex).streamVoice = streamVoice;
+        }
+    } else {
+        voiceIndex = allocateVoice(priority);
+    }
+    if (voiceIndex < 0) {
         return false;
     }
+    Voice& voice = voices_.getVoice(voiceIndex);
     
-    // Get sample info
-    SampleInfo& sample = samples_[actualSampleIndex];
-    double totalFrames = static_cast<double>(sample.numFrames);
-    double sampleRate = static_cast<double>(sample.sampleRate);
+    // Streamed samples need a ring buffer voice behind the resident head
+    // (claiming one this sample already owns just restarts it)
+    if (sample.streamed) {
+        voice.streamVoice = streamer_.claim(index);
+        if (voice.streamVoice < 0) {
+            voices_.release(voiceIndex);
+            return false;
+        }
+    }
     
-    // Create a new ticker from the sample
-    grains_[availableSlot].ticker = sample.reader.createWavTicker(Config::samplerate);
+    sample.reader.resetWavTicker(voice.ticker, Config::samplerate);
+    if (Constants::SampleLibrary::DECLICK_VOICES) {
+        voice.ticker.window_ = B3_WINDOW_DECLICK;
+    }
+    voice.ticker.interp_ = getSampleInterpolation(index);
+    voice.sampleIndex = index;
+    voice.owner = owner;
+    voice.volume = volume;
+    return true;
+}
+
+// Level of the block the voice is currently in
+float SampleLibrary::getVoiceLevel(const Voice& voice) const {
+    if (voice.ticker.finished_) {
+        return 0.0f;
+    }
+    const SampleInfo& sample = samples_[voice.sampleIndex];
+    uint32_t block = (uint32_t)voice.ticker.time_ / Constants::SampleLibrary::LEVEL_BLOCK_FRAMES;
+    if (sample.levels == nullptr || block >= sample.levelBlocks) {
+        return 1.0f;  // Not measured: assume loud
+    }
+    return sample.levels[block] * (1.0f / 255.0f);
+}
+
+// Output frames until the next auto-spawned grain
+double SampleLibrary::nextGrainInterval() {
+    // Jitter the rate per grain; the spawn rate floor keeps the interval bounded
+    float rate = granularSpawnRate_ + grainRandom_[GRAIN_RANDOM_RATE].take(random_) * granularSpawnRateRandom_;
+    if (rate < 1.0f) rate = 1.0f;
+    return (double)Config::samplerate / rate;
+}
+
+void SampleLibrary::refillGrainRandom() {
+    if (reseedRequested_) {
+        random_.seed(pendingSeed_);
+        for (int i = 0; i < NUM_GRAIN_RANDOM_PARAMS; i++) {
+            grainRandom_[i].reset();
+        }
+        reseedRequested_ = false;
+    }
     
-    // Apply randomness to start position
-    float positionRandomOffset = randomFloat(-1.0f, 1.0f) * granularPositionRandom_;
+    for (int i = 0; i < NUM_GRAIN_RANDOM_PARAMS; i++) {
+        if (grainRandom_[i].getDistribution() != granularDistribution_[i]) {
+            grainRandom_[i].setDistribution(granularDistribution_[i]);
+        }
+        grainRandom_[i].refill(random_);
+    }
+}
+
+// Spawn a new grain from a sample
+bool SampleLibrary::spawnGrain(int sampleIndex, float startPosition, float duration, float speed, int offset) {
+    // Apply randomness to start position, duration and speed
+    float positionRandomOffset = grainRandom_[GRAIN_RANDOM_POSITION].take(random_) * granularPositionRandom_;
     float randomizedPosition = startPosition + positionRandomOffset;
     
     // Clamp position to valid range
     if (randomizedPosition < 0.0f) randomizedPosition = 0.0f;
     if (randomizedPosition > 1.0f) randomizedPosition = 1.0f;
     
+    float durationRandomOffset = grainRandom_[GRAIN_RANDOM_DURATION].take(random_) * granularDurationRandom_;
+    float randomizedDuration = duration + durationRandomOffset;
+    
+    // Clamp duration to valid range
+    if (randomizedDuration < 0.01f) randomizedDuration = 0.01f;
+    if (randomizedDuration > 1.0f) randomizedDuration = 1.0f;
+    
+    float speedRandomOffset = grainRandom_[GRAIN_RANDOM_SPEED].take(random_) * granularSpeedRandom_;
+    float randomizedSpeed = speed + speedRandomOffset;
+    
+    // Clamp speed to valid range
+    if (randomizedSpeed < 0.1f) randomizedSpeed = 0.1f;
+    if (randomizedSpeed > 4.0f) randomizedSpeed = 4.0f;
+    
+    // Live source: read the input ring instead of a sample
+    if (sampleIndex < 0 && granularLiveSource_) {
+        return spawnLiveGrain(randomizedPosition, randomizedDuration, randomizedSpeed, offset);
+    }
+    
+    // Use granularSampleIndex_ if sampleIndex is -1
+    int actualSampleIndex = sampleIndex;
+    if (sampleIndex < 0) {
+        actualSampleIndex = granularSampleIndex_;
+    }
+    
+    // Validate sample index
+    if (actualSampleIndex < 0 || actualSampleIndex >= sampleCount_) {
+        debugGrainSpawnFailures++;
+        return false;
+    }
+    
+    // Validate sample is fully loaded (grains jump around, so streamed samples can't be used)
+    if (!samples_[actualSampleIndex].audioDataLoaded || samples_[actualSampleIndex].streamed) {
+        debugGrainSpawnFailures++;
+        return false;
+    }
+    
+    // Get sample info
+    SampleInfo& sample = samples_[actualSampleIndex];
+    double totalFrames = static_cast<double>(sample.playFrames);
+    double sampleRate = static_cast<double>(sample.playRate);
+    
     // Calculate start position (convert 0.0-1.0 to frame number)
     double startFrame = randomizedPosition * totalFrames;
     
@@ -373,44 +1230,28 @@ bool SampleLibrary::spawnGrain(int sampleIndex, float startPosition, float durat
     if (startFrame < 0.0) startFrame = 0.0;
     if (startFrame >= totalFrames) startFrame = totalFrames - 1.0;
     
-    // Set grain position
-    grains_[availableSlot].ticker.time_ = startFrame;
-    grains_[availableSlot].ticker.starttime_ = startFrame;
-    
-    // Apply randomness to duration
-    float durationRandomOffset = randomFloat(-1.0f, 1.0f) * granularDurationRandom_;
-    float randomizedDuration = duration + durationRandomOffset;
-    
-    // Clamp duration to valid range
-    if (randomizedDuration < 0.01f) randomizedDuration = 0.01f;
-    if (randomizedDuration > 1.0f) randomizedDuration = 1.0f;
-    
     // Calculate end position
     double durationFrames = sampleRate * randomizedDuration;
     double endFrame = startFrame + durationFrames;
     
-    // Clamp to end of file
-    if (endFrame > totalFrames) {
-        endFrame = totalFrames;
+    // Clamp to the last frame (interpolation reads one frame ahead)
+    if (endFrame > totalFrames - 1.0) {
+        endFrame = totalFrames - 1.0;
     }
     
-    grains_[availableSlot].ticker.endtime_ = endFrame;
-    
-    // Apply randomness to speed
-    float speedRandomOffset = randomFloat(-1.0f, 1.0f) * granularSpeedRandom_;
-    float randomizedSpeed = speed + speedRandomOffset;
-    
-    // Clamp speed to valid range
-    if (randomizedSpeed < 0.1f) randomizedSpeed = 0.1f;
-    if (randomizedSpeed > 4.0f) randomizedSpeed = 4.0f;
+    // Frames read per output frame (resampling to the output rate, then the grain's speed)
+    double step = sampleRate / Config::samplerate * randomizedSpeed;
     
-    // Set grain properties
-    grains_[availableSlot].ticker.speed_ = randomizedSpeed;
-    grains_[availableSlot].sampleIndex = actualSampleIndex;
-    grains_[availableSlot].envelopePhase = 0.0f;
+    // Fast grains read a pre-filtered octave so they don't alias (powers of two scale exactly)
+    int level = b3ReadWavFile::mipLevelForStep(step, sample.mipLevels);
+    double scale = (double)(1 << level);
     
-    // Mark grain as active
-    grains_[availableSlot].ticker.finished_ = false;
+    // Hand the grain to the engine (fails when the grain budget is used up)
+    if (!grains_.spawn(actualSampleIndex, sample.mipData[level], sample.channels, 0,
+                       startFrame / scale, endFrame / scale, step / scale, granularWindow_, offset)) {
+        debugGrainSpawnFailures++;
+        return false;
+    }
     
     // DEBUG: Track successful spawns
     debugGrainSpawnCount++;
@@ -418,6 +1259,55 @@ bool SampleLibrary::spawnGrain(int sampleIndex, float startPosition, float durat
     return true;
 }
 
+// Spawn a grain from the live input ring
+// The readable window is placed relative to the write head so that the grain
+// never reads past the head, nor audio the head overwrites while it plays.
+bool SampleLibrary::spawnLiveGrain(float position, float duration, float speed, int offset) {
+    if (!live_.isReady()) {
+        debugGrainSpawnFailures++;
+        return false;
+    }
+    
+    double length = (double)live_.getLength();
+    double head = (double)live_.getWriteHead();
+    double recorded = (double)live_.getRecordedFrames();
+    double safety = (double)Constants::LiveInput::SAFETY_FRAMES;
+    
+    // Input frames read, and output frames the grain lasts (input and output share a rate)
+    double span = (double)Config::samplerate * duration;
+    double outFrames = span / speed;
+    
+    // Newest and oldest start, relative to the head. While recording, the
+    // head moves on by outFrames during the grain, and so does the oldest frame.
+    double newest;
+    double oldest;
+    if (live_.isFrozen()) {
+        newest = -1.0 - safety - span;
+        oldest = -recorded + safety;
+    } else {
+        newest = -1.0 - safety - ((span > outFrames) ? span - outFrames : 0.0);
+        oldest = -recorded + safety + ((outFrames > span) ? outFrames - span : 0.0);
+    }
+    if (newest < oldest) {
+        debugGrainSpawnFailures++;  // Not enough input recorded for this grain
+        return false;
+    }
+    
+    // Position counts back from the head: 1.0 = newest, 0.0 = oldest
+    double startFrame = head + oldest + position * (newest - oldest);
+    if (startFrame < 0.0) startFrame += length;
+    if (startFrame >= length) startFrame -= length;
+    
+    if (!grains_.spawn(LIVE_SOURCE, live_.getFrames(), LiveInput::CHANNELS, live_.getLength(),
+                       startFrame, startFrame + span, speed, granularWindow_, offset)) {
+        debugGrainSpawnFailures++;
+        return false;
+    }
+    
+    debugGrainSpawnCount++;
+    return true;
+}
+
 void SampleLibrary::setGranularMode(bool enabled) {
 
     
@@ -425,9 +1315,7 @@ void SampleLibrary::setGranularMode(bool enabled) {
     
     // Clear all grains when disabling
     if (!enabled) {
-        for (int i = 0; i < Constants::SampleLibrary::MAX_GRAINS; i++) {
-            grains_[i].ticker.finished_ = true;
-        }
+        grains_.requestClear();
         activeGrainCount_ = 0;
         debugGrainSpawnCount = 0;
         debugGrainSpawnFailures = 0;
@@ -441,16 +1329,83 @@ bool SampleLibrary::setGranularSampleIndex(int index) {
         return false;
     }
     
-    if (!samples_[index].audioDataLoaded) {
+    // Grains need the whole sample in SDRAM
+    if (samples_[index].streamed) {
+        display_.showMessagef("Too long for*granular!*%d", 300, index);
+        return false;
+    }
+    
+    // Page the sample in and keep it resident while selected. Grains play it
+    // pitched up, so it gets octave levels (the previous one gives its back)
+    if (!retainSample(index)) {
         display_.showMessagef("Sample not*loaded!*%d", 300, index);
         return false;
     }
+    if (granularSampleRetained_) {
+        releaseSample(granularSampleIndex_);
+        if (granularSampleIndex_ != index) {
+            setSampleMipmapped(granularSampleIndex_, Constants::SampleLibrary::MIPMAP_SAMPLES);
+        }
+    }
+    granularSampleRetained_ = true;
+    setSampleMipmapped(index, true);
     
     granularSampleIndex_ = index;
     display_.showMessagef("granularSampleIndex_*%d", 300, index);
     return true;
 }
 
+bool SampleLibrary::setGranularLiveSource(bool live) {
+    if (live && !live_.isReady()) {
+        display_.showMessage("No live buffer!", 300);
+        return false;
+    }
+    granularLiveSource_ = live;
+    return true;
+}
+
+void SampleLibrary::recordInput(const float* const* in, size_t size) {
+    live_.write(in[0], in[1], size);
+}
+
+void SampleLibrary::setInterpolation(int tier) {
+    if (tier < B3_INTERP_DROP) tier = B3_INTERP_DROP;
+    if (tier > B3_INTERP_SINC) tier = B3_INTERP_SINC;
+    interpolation_ = tier;
+}
+
+void SampleLibrary::setSampleInterpolation(int index, int tier) {
+    if (index < 0 || index >= Constants::SampleLibrary::MAX_SAMPLES) return;
+    if (tier > B3_INTERP_SINC) tier = B3_INTERP_SINC;
+    sampleInterpolation_[index] = (int8_t)((tier < 0) ? -1 : tier);
+}
+
+int SampleLibrary::getSampleInterpolation(int index) const {
+    if (index < 0 || index >= Constants::SampleLibrary::MAX_SAMPLES || sampleInterpolation_[index] < 0) {
+        return interpolation_;
+    }
+    return sampleInterpolation_[index];
+}
+
+void SampleLibrary::updateInterpolationCeiling(uint32_t loadPercent) {
+    // Drop straight away when close to the deadline, give back slowly
+    if (loadPercent >= Constants::SampleLibrary::INTERP_DROP_LOAD_PERCENT) {
+        if (interpCeiling_ > B3_INTERP_DROP) {
+            interpCeiling_--;
+        }
+        calmCallbacks_ = 0;
+    } else if (loadPercent < Constants::SampleLibrary::INTERP_RESTORE_LOAD_PERCENT) {
+        if (++calmCallbacks_ >= Constants::SampleLibrary::INTERP_RESTORE_CALLBACKS) {
+            if (interpCeiling_ < B3_INTERP_SINC) {
+                interpCeiling_++;
+            }
+            calmCallbacks_ = 0;
+        }
+    } else {
+        calmCallbacks_ = 0;
+    }
+}
+
 // ========== Debug Getter Methods ==========
 
 int SampleLibrary::getDebugGrainSpawnCount() const {
@@ -461,14 +1416,18 @@ int SampleLibrary::getDebugGrainSpawnFailures() const {
     return debugGrainSpawnFailures;
 }
 
+float SampleLibrary::getTimeUntilNextGrain() const {
+    return (float)(framesUntilGrain_ / Config::samplerate);
+}
+
 // ========== Gate Control Methods ==========
 
 void SampleLibrary::setGateOpen(bool open) {
     gateOpen_ = open;
     
-    // Reset timer when closing gate to prevent burst on next open
+    // Disarm timer when closing gate to prevent burst on next open
     if (!open) {
-        timeSinceLastGrain_ = 0.0f;
+        framesUntilGrain_ = -1.0;
     }
 }
 
@@ -502,6 +1461,13 @@ void SampleLibrary::setGranularPosition(float position) {
     granularPosition_ = position;
 }
 
+void SampleLibrary::setGranularWindow(int window) {
+    // Wrap around so the menu can cycle through the shapes
+    if (window < 0) window = NUM_GRAIN_WINDOWS - 1;
+    if (window >= NUM_GRAIN_WINDOWS) window = 0;
+    granularWindow_ = window;
+}
+
 // ========== Granular Randomness Control Methods ==========
 
 void SampleLibrary::setGranularSpawnRateRandom(float random) {
@@ -532,3 +1498,19 @@ void SampleLibrary::setGranularPositionRandom(float random) {
     granularPositionRandom_ = random;
 }
 
+void SampleLibrary::setGranularDistribution(int param, int distribution) {
+    if (param < 0 || param >= NUM_GRAIN_RANDOM_PARAMS) return;
+    if (distribution < 0 || distribution >= NUM_RANDOM_DISTRIBUTIONS) return;
+    granularDistribution_[param] = distribution;
+}
+
+int SampleLibrary::getGranularDistribution(int param) const {
+    if (param < 0 || param >= NUM_GRAIN_RANDOM_PARAMS) return RANDOM_UNIFORM;
+    return granularDistribution_[param];
+}
+
+void SampleLibrary::setRandomSeed(uint64_t seed) {
+    // Seed first, flag second: the audio callback reads the seed once it sees the flag
+    pendingSeed_ = seed;
+    reseedRequested_ = true;
+}
@@ -4,6 +4,15 @@
 #include "daisy_core.h"
 #include "daisy_seed.h"
 #include "DisplayManager.h"
+#include "SampleStreamer.h"
+#include "SampleCache.h"
+#include "VoicePool.h"
+#include "GrainEngine.h"
+#include "Random.h"
+#include "LiveInput.h"
+#include "SampleRateConverter.h"
+#include "SampleBank.h"
+#include "SampleIndex.h"
 
 #include <string>
 #include "Constants.h"
@@ -11,44 +20,97 @@
 using namespace daisy;
 using namespace std;
 
+// Granular parameters that take a random offset per grain
+enum GrainRandomParam {
+    GRAIN_RANDOM_RATE,       // Spawn interval jitter
+    GRAIN_RANDOM_POSITION,
+    GRAIN_RANDOM_DURATION,
+    GRAIN_RANDOM_SPEED,
+    NUM_GRAIN_RANDOM_PARAMS
+};
+
 // Structure to hold information about a loaded sample
 struct SampleInfo {
     char name[32];              // Filename
+    const char* file;           // File the audio is read from: name, or the sample bank
     int numFrames;              // Number of sample frames
     int channels;               // 1 = mono, 2 = stereo
     int sampleRate;             // Sample rate (e.g., 48000)
     int bitsPerSample;          // 8, 16, 24, or 32
-    MemoryDataSource dataSource;       // Pointer to audio data in SDRAM
-    b3ReadWavFile reader;      // WAV file reader/parser
+    uint32_t playFrames;        // Frames in audioData once loaded (differs after sample-rate conversion)
+    int playRate;               // Rate of audioData (Config::samplerate after conversion)
+    void* audioData;            // Decoded interleaved frames in SDRAM
+    size_t audioDataSize;       // Size of audioData in bytes
+    b3ReadWavFile reader;      // WAV file reader/parser (plays from audioData)
     bool loaded;               // Is metadata loaded?
-    bool audioDataLoaded;       // Is full audio data loaded in RAM?
+    volatile bool audioDataLoaded;  // Is the audio data it plays from paged into the cache? (read by the audio callback)
+    bool streamed;              // Only the head is cached; the rest streams from SD
+    uint32_t residentFrames;    // Frames held in audioData when streamed
+    uint8_t* levels;            // Peak level per LEVEL_BLOCK_FRAMES (255 = full scale), for voice stealing
+    uint32_t levelBlocks;       // Number of entries in levels
+    bool mipmapped;             // Build octave levels when the audio data is loaded
+    int mipLevels;              // Levels in mipData (1 = only audioData itself)
+    const void* mipData[Constants::SampleLibrary::MIP_LEVELS + 1];   // Level i: 1/2^i rate, inside audioData
+    uint32_t mipFrames[Constants::SampleLibrary::MIP_LEVELS + 1];    // Frames in each level
+    size_t mipBytes;            // Part of audioDataSize taken by levels 1 and up
 };
 
-// Structure representing a single grain in granular synthesis
-// A grain is a short segment of audio that plays with an envelope
-struct Grain {
-    b3WavTicker ticker;          // Playback position tracker
-    int sampleIndex;              // Which sample file this grain uses
-    float envelopePhase;          // Progress through grain (0.0 to 1.0)
+// What the background loader is doing, for the menus
+struct SampleLoaderProgress {
+    bool scanning;              // Headers are still being read
+    int samplesFound;           // Samples listed so far (getSampleCount())
+    int scanTotal;              // Samples expected (known for a bank; -1 while walking the directory)
+    int loadingSample;          // Sample whose audio is being read (-1 = none)
+    int loadPercent;            // How far along that sample is (0 - 100)
+    int queued;                 // Samples waiting for their audio (including the one loading)
 };
 
+// Cache and mip memory, for the debug display
+struct SampleLibraryStats {
+    size_t cacheCapacity;       // Bytes the sample cache may hold
+    size_t cacheUsedBytes;      // Bytes of audio data cached (mip levels included)
+    size_t mipBytes;            // Of which octave levels
+    int cachedSamples;          // Samples with audio data in the cache
+    int mippedSamples;          // Of which have octave levels
+};
 
 class SampleLibrary {
 private:
     SampleInfo samples_[Constants::SampleLibrary::MAX_SAMPLES];  // Array of loaded samples
-    b3WavTicker wavTickers_[Constants::SampleLibrary::MAX_SAMPLES]; // Array of tickers for playback -- currently only one per sample
     float sampleSpeeds_[Constants::SampleLibrary::MAX_SAMPLES];   // Per-sample playback speed (default 1.0 = normal speed)
 
-    int sampleCount_;                 // How many samples are loaded
+    volatile int sampleCount_;        // Samples listed so far (grows while the loader scans)
+    
+    // SDRAM cache that audio data is paged into on demand
+    SampleCache cache_;
+    
+    // Streaming playback for samples too large to keep in SDRAM
+    SampleStreamer streamer_;
+    
+    // Every playing voice: sequencer hits and triggered samples
+    VoicePool voices_;
+    
+    // Stop requests from the main loop, applied by the audio callback
+    // (single producer / single consumer; only the audio callback touches the pool)
+    struct StopRequest {
+        int priority;
+        int owner;                // -1 = every voice of that priority
+    };
+    StopRequest stopQueue_[Constants::Voices::STOP_QUEUE_SIZE];
+    volatile uint32_t stopWrite_;
+    volatile uint32_t stopRead_;
     
     // Granular synthesis state
-    Grain grains_[Constants::SampleLibrary::MAX_GRAINS];  // Pool of grain objects
+    GrainEngine grains_;                                   // Structure-of-arrays grain store
     int activeGrainCount_;                                 // Number of currently active grains
     bool granularModeEnabled_;                              // Is granular synthesis active?
     int granularSampleIndex_;                               // Which sample to use for granular
+    bool granularSampleRetained_;                           // Granular sample holds a cache pin
+    volatile bool granularLiveSource_;                      // Grains read the live input instead of a sample
+    LiveInput live_;                                        // Ring of recent audio input
     
     // Spawning timer (auto-spawning)
-    float timeSinceLastGrain_;  // Time elapsed since last grain spawned
+    double framesUntilGrain_;   // Output frames from the current block start to the next spawn (< 0 = not armed)
     float spawnRate_;           // Grains per second (legacy, use granularSpawnRate_)
     
     // Configurable granular parameters
@@ -56,6 +118,7 @@ private:
     float granularDuration_;     // Grain duration in seconds (0.01 - 1.0)
     float granularSpeed_;       // Playback speed multiplier (0.1 - 4.0)
     float granularPosition_;     // Start position within sample (0.0 - 1.0)
+    int granularWindow_;         // Grain envelope shape (GrainWindowType)
     
     // Randomness parameters (additive variation per grain)
     float granularSpawnRateRandom_;    // Spawn rate randomness (0 - 50 grains/sec)
@@ -63,6 +126,19 @@ private:
     float granularSpeedRandom_;        // Speed randomness (0 - 2.0x)
     float granularPositionRandom_;     // Position randomness (0 - 0.5)
     
+    // Interpolation quality
+    int interpolation_;                                        // Default tier for new voices (B3_INTERP_*)
+    int8_t sampleInterpolation_[Constants::SampleLibrary::MAX_SAMPLES];  // Per-sample tier (-1 = default)
+    int interpCeiling_;                                        // Highest tier rendered right now (drops under load)
+    int calmCallbacks_;                                        // Callbacks in a row below the restore load
+    
+    // Random source for the randomness parameters (audio callback only)
+    RandomGenerator random_;
+    RandomBatch grainRandom_[NUM_GRAIN_RANDOM_PARAMS];             // Values drawn at block rate
+    volatile int granularDistribution_[NUM_GRAIN_RANDOM_PARAMS];   // Requested RandomDistribution
+    volatile uint64_t pendingSeed_;
+    volatile bool reseedRequested_;
+    
     // Gate control for manual grain spawning
     bool gateOpen_;             // Gate is open when Button1 is held
     
@@ -71,31 +147,157 @@ private:
     FatFSInterface& fileSystem_;
     DisplayManager& display_;         // Display manager for showing messages
     
+    // Output frames until the next auto-spawned grain (spawn rate plus jitter)
+    double nextGrainInterval();
+    
+    // Helper: Apply a pending reseed and top up the random batches (audio callback)
+    void refillGrainRandom();
+    
+    // Helper: Spawn a grain from the live input ring (audio callback)
+    bool spawnLiveGrain(float position, float duration, float speed, int offset);
+    
+    // ========== Background Loader (main loop) ==========
+    
+    enum LoaderStage {
+        LOADER_START,           // Nothing read yet
+        LOADER_BANK,            // Reading the sample bank's index
+        LOADER_SCAN,            // Walking the root directory for WAVs
+        LOADER_READY            // Every header is known; only audio loads remain
+    };
+    
+    // A sample's audio being read into the cache, a chunk per step. Level 0 is the
+    // decoded (or rate-converted) frames, levels 1 and up its octaves.
+    struct DataLoad {
+        int index;              // Sample being loaded (-1 = none)
+        bool convert;           // Level 0 is converted to the output rate
+        int level;              // Level being written
+        int levels;             // Levels to write
+        uint32_t done;          // Frames of the current level written
+        uint32_t frames[Constants::SampleLibrary::MIP_LEVELS + 1];
+        size_t offsets[Constants::SampleLibrary::MIP_LEVELS + 1];
+        size_t baseSize;        // Bytes of level 0 (with guard frames)
+        size_t size;            // Bytes of the whole buffer
+        void* buffer;
+        FIL file;               // Open while level 0 is read
+        SampleRateConverter converter;  // Rate converter for level 0, then the halfband for the octaves
+        float* input;           // Chunk scratch for the converters
+        float* output;
+    };
+    
+    LoaderStage loaderStage_;
+    FIL bankFile_;              // Open during LOADER_BANK
+    SampleBankHeader bank_;
+    uint32_t bankEntriesRead_;
+    DIR scanDir_;               // Open during LOADER_SCAN
+    SampleIndex index_;         // Cached WAV headers, held during LOADER_SCAN
+    bool indexed_;
+    DataLoad load_;
+    volatile bool loadWanted_[Constants::SampleLibrary::MAX_SAMPLES];  // Audio requested but not loaded
+    int nextWanted_;            // Where the search for the next wanted sample starts
+    
+    // Evicted samples whose memory is held until no audio callback can still be reading it
+    bool retiring_[Constants::SampleLibrary::MAX_SAMPLES];
+    uint32_t retiredAt_[Constants::SampleLibrary::MAX_SAMPLES];   // audioBlocks_ when retired
+    int retiringCount_;
+    bool waitingForRetire_;     // A load is waiting for retired memory to come back
+    volatile uint32_t audioBlocks_;  // Audio callbacks finished (see audioBlockDone)
+    
+    // Helper: Do one bounded piece of loader work; false when there is nothing to do
+    bool loaderStep();
+    
+    // Helper: Open the bank, or failing that the root directory
+    void startScan();
+    
+    // Helper: List the next block of bank entries / the next directory entry
+    void scanBankStep();
+    void scanDirectoryStep();
+    
+    // Helper: Report the scan and move on to LOADER_READY
+    void finishScan();
+    
     // Helper function to load only metadata (WAV header) from a file
     bool loadSampleInfo(const char* filename, int index);
     
-    // Helper function to load full audio data for a sample (lazy loading)
-    bool loadSampleData(int index);
+    // Helper: Fill in a sample from its reader's metadata once the header has been read
+    // and list it (sampleCount_ moves past it once everything is in place)
+    void initSampleInfo(int index, const char* name, const char* file, int bitsPerSample);
+    
+    // Helper: Lay out, allocate and open a sample's audio load
+    // Evicts least-recently-used samples when the cache is full
+    bool beginDataLoad(int index);
+    
+    // Helper: Write the next chunk of the current load; publishes the sample when done
+    void stepDataLoad();
+    
+    // Helper: Abandon the current load, handing its memory back (no message when null)
+    void cancelDataLoad(const char* message);
     
-    // Helper: Scan directory and load all WAV files
-    bool scanAndLoadFiles();
+    // Helper: Decode one chunk of a sample and convert it to the output rate
+    bool convertChunk(uint32_t outFirst, int count);
+    
+    // Helper: Low-pass and halve one chunk of a level into the next (halfband: a 2:1 converter)
+    void buildMipChunk(int level, uint32_t outFirst, int count);
+    
+    // Helper: Stop new voices and grains on an eviction victim; its memory is
+    // freed by drainRetired() once that is safe
+    void retireSample(int index);
+    
+    // Helper: Free retired samples that a whole callback has passed without playing
+    // Returns true if any memory came back
+    bool drainRetired();
+    
+    // Helper: Drop a sample's audio data from the cache
+    void unloadSampleData(int index);
+    
+    // Helper: Measure the coarse level envelope of freshly decoded audio
+    void buildLevelEnvelope(int index, uint32_t decodedFrames);
+    
+    // Helper: Is any voice (sequencer hit, triggered sample or grain) playing this sample?
+    bool isSamplePlaying(int index) const;
+    
+    // Helper: Stop a voice, handing back its stream voice (audio callback)
+    void stopVoice(int voiceIndex);
+    
+    // Helper: Allocate a pool voice, stealing a lower-or-equal priority one if needed
+    int allocateVoice(int priority);
+    
+    // Helper: Render one voice; returns false once it has finished
+    bool renderVoice(Voice& voice, float** out, size_t size);
+    
+    // Helper: Approximate level (0.0 - 1.0) of a voice's sample at its position
+    float getVoiceLevel(const Voice& voice) const;
+    
+    // Helper: Decoded sample format used for all cached audio
+    static int decodeFormat();
     
-    // Helper: Load a single WAV file
-    bool loadWavFile(const char* filename, int index);
 
 public:
     // Constructor
     SampleLibrary(daisy::SdmmcHandler& sdHandler, FatFSInterface& fileSystem, DisplayManager& display);
     
-    // Initialize: Scan SD card and load all WAV files
+    // Initialize: Reserve the sample cache and start the background loader
+    // Samples appear as serviceLoader() reads their headers
     bool init();
     
+    // Read headers and sample audio from the SD card, a bounded slice per call
+    // Call this from the main loop (never from the audio callback)
+    void serviceLoader();
+    
+    // Background loader state (scan and audio loads)
+    SampleLoaderProgress getLoaderProgress() const;
+    bool isScanComplete() const { return loaderStage_ == LOADER_READY; }
+    
+    // Queue a sample's audio to be read by serviceLoader(); returns false for an invalid index
+    bool requestSampleLoad(int index);
+    
     // Get a sample by index
     SampleInfo* getSample(int index);
     
-    // Load audio data for a sample (lazy loading)
-    // Call this before playing a sample if audioDataLoaded is false
-    bool ensureSampleLoaded(int index);
+    // Pin a sample in the cache while it is selected (by a sequencer track or the
+    // granular engine) and queue its audio; it plays once the loader has read it.
+    // Pair with releaseSample().
+    bool retainSample(int index);
+    void releaseSample(int index);
     
     // Get number of loaded samples
     int getSampleCount() const { return sampleCount_; }
@@ -103,21 +305,61 @@ public:
     // Find sample by name (returns index, or -1 if not found)
     int findSample(const char* name);
     
+    // Refill streaming buffers from the SD card
+    // Call this from the main loop (never from the audio callback)
+    void serviceStreams();
+    
     // Process audio for active samples
     // Called from AudioCallback to generate audio output
     void processAudio(float** out, size_t size);
     
-    // Trigger a sample to start playing
-    // Returns true if sample was triggered successfully
+    // Trigger a sample to start playing (audio callback)
+    // Retriggering restarts it; returns true if sample was triggered successfully
     bool triggerSample(int index);
     
-    // Stop a currently playing sample
+    // Stop a currently playing sample (main loop; takes effect on the next audio block)
     // Returns true if sample was stopped successfully
     bool stopSample(int index);
     
     // Set the playback speed for a sample
     // Speed values: 0.1 = 10% speed, 1.0 = normal speed, 3.0 = 300% speed
     void setSampleSpeed(int index, float speed);
+    float getSampleSpeed(int index) const;
+    
+    // Build octave levels (1/2, 1/4, 1/8 rate) for a sample so fast playback doesn't alias
+    // Off by default (MIPMAP_SAMPLES): the levels take 0.875x the sample's SDRAM again
+    // On for the granular sample while it is selected. A resident sample is read
+    // again with the new layout if still pinned, otherwise dropped (main loop)
+    void setSampleMipmapped(int index, bool enabled);
+    bool isSampleMipmapped(int index) const;
+    
+    // Cache and mip memory use (main loop)
+    SampleLibraryStats getStats() const;
+
+    // ========== Voice Methods ==========
+
+    // Start a pooled voice playing a sample from the top (audio callback)
+    // priority:    VoicePriority; decides what may be stolen if the pool is full
+    // owner:       Tag for per-owner limits (e.g. track index)
+    // maxPerOwner: Voices this owner may hold; beyond that one of its own is stolen per stealMode
+    // volume:      Gain for this voice
+    // Streamed samples only ever have one voice, which is restarted.
+    // Returns true if a voice was started
+    bool triggerVoice(int index, int priority, int owner, int maxPerOwner,
+                      VoiceStealMode stealMode, float volume);
+
+    // Stop every voice with this priority and owner (-1 = any owner)
+    // Main loop; takes effect on the next audio block
+    void requestStopVoices(int priority, int owner);
+
+    // Apply the queued stop requests (audio callback, at the start of each
+    // callback before anything triggers or renders)
+    void processStopRequests();
+
+    // Voice budget: maximum voices rendered at once
+    void setVoiceLimit(int limit) { voices_.setVoiceLimit(limit); }
+    int getVoiceLimit() const { return voices_.getVoiceLimit(); }
+    int getActiveVoiceCount() const { return voices_.getActiveCount(); }
 
     // ========== Granular Synthesis Methods ==========
 
@@ -128,6 +370,44 @@ public:
     // Set which sample to use for granular synthesis
     bool setGranularSampleIndex(int index);
     int getGranularSampleIndex() const { return granularSampleIndex_; }
+    
+    // ========== Live Input ==========
+    
+    // Grain index used for grains reading the live input
+    static constexpr int LIVE_SOURCE = Constants::SampleLibrary::MAX_SAMPLES;
+    
+    // Record an input block into the live ring (audio callback, before processAudio)
+    void recordInput(const float* const* in, size_t size);
+    
+    // Count a finished audio callback (at the end of every callback). Evicted
+    // sample memory is only freed after a whole callback has passed without it.
+    void audioBlockDone() { audioBlocks_++; }
+    
+    // ========== Interpolation Quality ==========
+    
+    // Default interpolation for new voices (B3_INTERP_DROP .. B3_INTERP_SINC)
+    void setInterpolation(int tier);
+    int getInterpolation() const { return interpolation_; }
+    
+    // Interpolation for voices of one sample (-1 = use the default)
+    void setSampleInterpolation(int index, int tier);
+    int getSampleInterpolation(int index) const;
+    
+    // Lower or restore the interpolation ceiling from the last callback's load
+    // (audio callback, once per callback). Voices keep their tier but render at
+    // most the ceiling, which drops a tier whenever the load nears the deadline.
+    void updateInterpolationCeiling(uint32_t loadPercent);
+    int getInterpolationCeiling() const { return interpCeiling_; }
+    
+    // Use the live input as the granular source instead of a sample
+    // Grain position then counts back from the write head: 1.0 = newest audio, 0.0 = oldest
+    bool setGranularLiveSource(bool live);
+    bool isGranularLiveSource() const { return granularLiveSource_; }
+    bool isLiveInputReady() const { return live_.isReady(); }
+    
+    // Freeze: stop recording so grains scan a fixed stretch of input
+    void setLiveFrozen(bool frozen) { live_.setFrozen(frozen); }
+    bool isLiveFrozen() const { return live_.isFrozen(); }
 
     // Spawn a new grain from a sample
     // sampleIndex: which sample to use (or -1 to use granularSampleIndex_)
@@ -135,11 +415,16 @@ public:
     // duration: how long grain lasts (in seconds)
     // speed: playback speed/pitch (1.0 = normal)
     // Returns true if grain was spawned successfully
-    bool spawnGrain(int sampleIndex, float startPosition, float duration, float speed);
+    // offset: output frame within the next audio block where the grain starts
+    bool spawnGrain(int sampleIndex, float startPosition, float duration, float speed, int offset = 0);
 
     // Get number of currently active grains
     int getActiveGrainCount() const { return activeGrainCount_; }
     
+    // Grain budget: maximum grains playing at once (up to MAX_GRAINS)
+    void setGrainLimit(int limit) { grains_.setGrainLimit(limit); }
+    int getGrainLimit() const { return grains_.getGrainLimit(); }
+    
     // ========== Debug Methods ==========
     
     // Get debug grain spawn count
@@ -148,8 +433,8 @@ public:
     // Get debug grain spawn failures
     int getDebugGrainSpawnFailures() const;
     
-    // Get time since last grain spawn
-    float getTimeSinceLastGrain() const { return timeSinceLastGrain_; }
+    // Get time until the next scheduled grain spawn (seconds, negative when not armed)
+    float getTimeUntilNextGrain() const;
     
     // Get spawn rate (grains per second)
     float getSpawnRate() const { return spawnRate_; }
@@ -181,6 +466,10 @@ public:
     void setGranularPosition(float position);
     float getGranularPosition() const { return granularPosition_; }
     
+    // Set grain envelope shape (GrainWindowType)
+    void setGranularWindow(int window);
+    int getGranularWindow() const { return granularWindow_; }
+    
     // ========== Granular Randomness Control Methods ==========
     
     // Set spawn rate randomness (grains per second, range: 0.0 - 50.0)
@@ -198,4 +487,11 @@ public:
     // Set position randomness (normalized, range: 0.0 - 0.5)
     void setGranularPositionRandom(float random);
     float getGranularPositionRandom() const { return granularPositionRandom_; }
+    
+    // Shape of the random offsets for one parameter (RandomDistribution, default uniform)
+    void setGranularDistribution(int param, int distribution);
+    int getGranularDistribution(int param) const;
+    
+    // Restart the random sequence so grain clouds repeat exactly (applied at the next block)
+    void setRandomSeed(uint64_t seed);
 };
@@ -0,0 +1,145 @@
+#include "SampleRateConverter.h"
+
+#include <cmath>
+#include <cstddef>
+
+// External declarations for custom memory allocator defined in SimpleSampler.cpp
+extern void* custom_pool_allocate(size_t size);
+extern void custom_pool_free(void* ptr);
+
+// Kaiser window shape (about 80 dB stopband)
+static constexpr double KAISER_BETA = 8.0;
+
+// Passband edge as a fraction of the lower Nyquist frequency
+static constexpr double CUTOFF = 0.92;
+
+// Zeroth-order modified Bessel function (series), for the Kaiser window
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double half = x * 0.5;
+    for (int k = 1; k < 32; k++) {
+        term *= (half / k) * (half / k);
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+SampleRateConverter::SampleRateConverter()
+    : table_(nullptr)
+    , inRate_(0)
+    , outRate_(0)
+{
+}
+
+SampleRateConverter::~SampleRateConverter()
+{
+    release();
+}
+
+bool SampleRateConverter::init(int inRate, int outRate)
+{
+    release();
+    if (inRate <= 0 || outRate <= 0) {
+        return false;
+    }
+
+    table_ = (float*)custom_pool_allocate((PHASES + 1) * TAPS * sizeof(float));
+    if (table_ == nullptr) {
+        return false;
+    }
+    inRate_ = (uint32_t)inRate;
+    outRate_ = (uint32_t)outRate;
+
+    // Cutoff in input-rate terms: the input's Nyquist when upsampling, the output's when downsampling
+    const double pi = 3.14159265358979323846;
+    double cutoff = CUTOFF * ((outRate < inRate) ? (double)outRate / inRate : 1.0);
+    double norm = besselI0(KAISER_BETA);
+
+    for (int phase = 0; phase <= PHASES; phase++) {
+        double frac = (double)phase / PHASES;
+        float* row = table_ + phase * TAPS;
+        double sum = 0.0;
+        double taps[TAPS];
+        for (int k = 0; k < TAPS; k++) {
+            // Tap k reads input frame (i - HALF_TAPS + 1 + k)
+            double x = (double)(k - HALF_TAPS + 1) - frac;
+            double sinc = (x == 0.0) ? 1.0 : sin(pi * cutoff * x) / (pi * cutoff * x);
+            double r = x / HALF_TAPS;
+            double window = (r <= -1.0 || r >= 1.0) ? 0.0 : besselI0(KAISER_BETA * sqrt(1.0 - r * r)) / norm;
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+        // Unity gain at DC for every phase
+        for (int k = 0; k < TAPS; k++) {
+            row[k] = (float)(taps[k] / sum);
+        }
+    }
+    return true;
+}
+
+void SampleRateConverter::release()
+{
+    if (table_ != nullptr) {
+        custom_pool_free(table_);
+        table_ = nullptr;
+    }
+}
+
+uint32_t SampleRateConverter::outputFrames(uint32_t inFrames, int inRate, int outRate)
+{
+    if (inFrames == 0 || inRate <= 0 || outRate <= 0) {
+        return 0;
+    }
+    // Last output frame lands at or before the last input frame
+    return (uint32_t)((uint64_t)(inFrames - 1) * (uint32_t)outRate / (uint32_t)inRate) + 1;
+}
+
+void SampleRateConverter::position(uint32_t n, int64_t& frame, float& frac) const
+{
+    uint64_t scaled = (uint64_t)n * inRate_;
+    frame = (int64_t)(scaled / outRate_);
+    frac = (float)(scaled % outRate_) / (float)outRate_;
+}
+
+void SampleRateConverter::inputRange(uint32_t outFirst, int count, int64_t& first, int64_t& last) const
+{
+    int64_t frame;
+    float frac;
+    position(outFirst, frame, frac);
+    first = frame - HALF_TAPS + 1;
+    position(outFirst + (uint32_t)(count > 0 ? count - 1 : 0), frame, frac);
+    last = frame + HALF_TAPS;
+}
+
+void SampleRateConverter::process(const float* in, int64_t inFirst, int channels,
+                                  uint32_t outFirst, int count, float* out) const
+{
+    for (int n = 0; n < count; n++) {
+        int64_t frame;
+        float frac;
+        position(outFirst + (uint32_t)n, frame, frac);
+
+        float scaled = frac * PHASES;
+        int phase = (int)scaled;
+        float blend = scaled - (float)phase;
+        const float* h0 = table_ + phase * TAPS;
+        const float* h1 = h0 + ((phase < PHASES) ? TAPS : 0);
+        const float* src = in + (frame - HALF_TAPS + 1 - inFirst) * channels;
+
+        for (int c = 0; c < channels; c++) {
+            float acc0 = 0.0f;
+            float acc1 = 0.0f;
+            for (int k = 0; k < TAPS; k++) {
+                float x = src[k * channels + c];
+                acc0 += h0[k] * x;
+                acc1 += h1[k] * x;
+            }
+            out[n * channels + c] = acc0 + blend * (acc1 - acc0);
+        }
+    }
+}
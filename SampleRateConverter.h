@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * SampleRateConverter - High-quality offline resampler for load-time conversion
+ *
+ * A polyphase Kaiser-windowed sinc with TAPS taps and PHASES phases (blended
+ * linearly between neighbours). The cutoff follows the lower of the two
+ * Nyquist frequencies, so downsampling is band-limited too.
+ *
+ * Output frame n sits at input position n * inRate / outRate, worked out in
+ * integers so long samples never drift. Conversion runs in chunks: ask
+ * inputRange() which input frames a chunk of output needs, fill a buffer with
+ * them (zeros outside the sample) and call process().
+ *
+ * The coefficient table comes from the SDRAM pool and is only held while
+ * converting (init() ... release()).
+ */
+class SampleRateConverter {
+public:
+    static constexpr int HALF_TAPS = 32;
+    static constexpr int TAPS = 2 * HALF_TAPS;
+    static constexpr int PHASES = 256;
+
+    SampleRateConverter();
+    ~SampleRateConverter();
+
+    /**
+     * Build the filter for a conversion
+     *
+     * @return false if the rates are invalid or the table cannot be allocated
+     */
+    bool init(int inRate, int outRate);
+
+    // Free the coefficient table
+    void release();
+
+    // Output frames produced from inFrames input frames
+    static uint32_t outputFrames(uint32_t inFrames, int inRate, int outRate);
+
+    // Input frames [first, last] read by output frames [outFirst, outFirst + count)
+    void inputRange(uint32_t outFirst, int count, int64_t& first, int64_t& last) const;
+
+    /**
+     * Render output frames
+     *
+     * @param in Interleaved float input frames, in[0] being input frame inFirst;
+     *           must cover inputRange(outFirst, count)
+     * @param out Interleaved float output, count frames
+     */
+    void process(const float* in, int64_t inFirst, int channels,
+                 uint32_t outFirst, int count, float* out) const;
+
+private:
+    float* table_;      // (PHASES + 1) x TAPS coefficients
+    uint32_t inRate_;
+    uint32_t outRate_;
+
+    // Integer input frame and fraction (0 - 1) under output frame n
+    void position(uint32_t n, int64_t& frame, float& frac) const;
+};
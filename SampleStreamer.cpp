@@ -0,0 +1,334 @@
+#include "SampleStreamer.h"
+#include "SampleLibrary.h"
+#include "FatFileDataSource.h"
+#include <math.h>
+#include <string.h>
+
+// External declaration for custom memory allocator defined in SimpleSampler.cpp
+extern void* custom_pool_allocate(size_t size);
+
+// Streaming is limited to mono/stereo files so each ring has a fixed size
+static constexpr int MAX_STREAM_CHANNELS = 2;
+
+SampleStreamer::SampleStreamer()
+    : format_(B3_DECODED_FLOAT32)
+    , initialized_(false)
+    , startCounter_(0)
+{
+    for (int i = 0; i < Constants::Streaming::MAX_STREAM_VOICES; i++) {
+        voices_[i].sampleIndex = -1;
+        voices_[i].active = false;
+        voices_[i].request = 0;
+        voices_[i].readFrame = 0;
+        voices_[i].startOrder = 0;
+        voices_[i].underruns = 0;
+        voices_[i].served = 0;
+        voices_[i].filledFrames = 0;
+        voices_[i].fileOpen = false;
+        voices_[i].fileSample = -1;
+        voices_[i].ring = nullptr;
+    }
+}
+
+bool SampleStreamer::init(int format)
+{
+    if (initialized_) {
+        return format == format_;
+    }
+
+    format_ = format;
+    size_t bytesPerSample = (format == B3_DECODED_INT16) ? sizeof(short) : sizeof(float);
+    size_t ringSize = (Constants::Streaming::RING_FRAMES + GUARD_FRAMES) * MAX_STREAM_CHANNELS * bytesPerSample;
+
+    for (int i = 0; i < Constants::Streaming::MAX_STREAM_VOICES; i++) {
+        voices_[i].ring = custom_pool_allocate(ringSize);
+        if (voices_[i].ring == nullptr) {
+            return false;
+        }
+    }
+
+    initialized_ = true;
+    return true;
+}
+
+uint32_t SampleStreamer::residentFramesFor(const SampleInfo& sample)
+{
+    uint32_t frames = (uint32_t)((int64_t)Constants::Streaming::RESIDENT_MS * sample.sampleRate / 1000);
+    if (frames > (uint32_t)sample.numFrames) {
+        frames = sample.numFrames;
+    }
+    return frames;
+}
+
+int SampleStreamer::claim(int sampleIndex)
+{
+    if (!initialized_) {
+        return -1;
+    }
+
+    // Retrigger: restart the voice already streaming this sample
+    int slot = -1;
+    for (int i = 0; i < Constants::Streaming::MAX_STREAM_VOICES; i++) {
+        if (voices_[i].active && voices_[i].sampleIndex == sampleIndex) {
+            slot = i;
+            break;
+        }
+    }
+
+    // Otherwise take a free voice
+    if (slot < 0) {
+        for (int i = 0; i < Constants::Streaming::MAX_STREAM_VOICES; i++) {
+            if (!voices_[i].active) {
+                slot = i;
+                break;
+            }
+        }
+    }
+
+    // Otherwise steal the oldest
+    if (slot < 0) {
+        slot = 0;
+        for (int i = 1; i < Constants::Streaming::MAX_STREAM_VOICES; i++) {
+            if ((int32_t)(voices_[i].startOrder - voices_[slot].startOrder) < 0) {
+                slot = i;
+            }
+        }
+    }
+
+    // Publish the new owner before bumping request so the main loop sees a consistent voice
+    StreamVoice& voice = voices_[slot];
+    voice.sampleIndex = sampleIndex;
+    voice.readFrame = 0;
+    voice.startOrder = startCounter_++;
+    voice.active = true;
+    voice.request = voice.request + 1;
+    return slot;
+}
+
+bool SampleStreamer::ownsVoice(int voice, int sampleIndex) const
+{
+    if (voice < 0 || voice >= Constants::Streaming::MAX_STREAM_VOICES) {
+        return false;
+    }
+    return voices_[voice].active && voices_[voice].sampleIndex == sampleIndex;
+}
+
+void SampleStreamer::release(int voice)
+{
+    if (voice >= 0 && voice < Constants::Streaming::MAX_STREAM_VOICES) {
+        voices_[voice].active = false;
+    }
+}
+
+void SampleStreamer::render(int v, const SampleInfo& sample, b3WavTicker& ticker,
+                            double speed, float volume, int size, float* out0, float* out1, int maxInterp)
+{
+    StreamVoice& voice = voices_[v];
+    const b3ReadWavFile& reader = sample.reader;
+    const uint32_t resident = sample.residentFrames;
+    const uint32_t ringFrames = Constants::Streaming::RING_FRAMES;
+    const double step = ticker.rate_ * speed;
+
+    // The ring only guarantees frame index + 1
+    int interp = (ticker.interp_ < maxInterp) ? ticker.interp_ : maxInterp;
+    if (interp > B3_INTERP_LINEAR) {
+        interp = B3_INTERP_LINEAR;
+    }
+
+    // Nothing is in the ring until the main loop has served this trigger
+    uint32_t filled = (voice.served == voice.request) ? voice.filledFrames : resident;
+
+    int pos = 0;
+    while (pos < size) {
+        if (ticker.time_ < ticker.starttime_ || ticker.time_ > ticker.endtime_) {
+            ticker.finished_ = true;
+            break;
+        }
+
+        int count = b3ReadWavFile::framesUntilEnd(&ticker, step, size - pos);
+        if (count == 0) {
+            ticker.finished_ = true;
+            break;
+        }
+
+        // Pick the contiguous region holding the current frame and how far it reaches
+        uint32_t index = (uint32_t)ticker.time_;
+        const void* frames;
+        uint32_t origin;
+        uint32_t boundary;
+        if (index < resident) {
+            frames = reader.getDecodedFrames();
+            origin = 0;
+            boundary = resident;
+        } else {
+            origin = resident + ((index - resident) / ringFrames) * ringFrames;
+            frames = voice.ring;
+            boundary = origin + ringFrames;
+
+            // Interpolation also reads index + 1
+            if (filled == 0 || filled - 1 < boundary) {
+                boundary = (filled > 0) ? filled - 1 : 0;
+            }
+            if (index >= boundary) {
+                // Ring has not caught up: leave the rest of the block silent but keep time,
+                // so a late refill never pushes the sample out of sync with the sequencer
+                ticker.time_ += step * (size - pos);
+                voice.underruns++;
+                break;
+            }
+        }
+
+        if (step > 0.0) {
+            double toBoundary = ceil(((double)boundary - ticker.time_) / step);
+            if (toBoundary < (double)count) {
+                count = (toBoundary < 1.0) ? 1 : (int)toBoundary;
+            }
+        }
+
+        double t = ticker.time_ - origin;
+        reader.render(frames, t, step, ticker.starttime_ - origin, ticker.endtime_ - origin,
+                      ticker.window_, interp, volume, out0 + pos, out1 + pos, count);
+        ticker.time_ = t + origin;
+        pos += count;
+    }
+
+    if (ticker.time_ > ticker.endtime_) {
+        ticker.finished_ = true;
+    }
+
+    // Let the main loop refill everything behind the playback position
+    voice.readFrame = (ticker.time_ > 0.0) ? (uint32_t)ticker.time_ : 0;
+}
+
+void SampleStreamer::restart(StreamVoice& voice, SampleInfo* samples)
+{
+    // Read request before the owner: if the audio callback retriggers in between,
+    // request moves on again and the next service() call restarts once more
+    uint32_t request = voice.request;
+    int index = voice.sampleIndex;
+
+    if (voice.fileOpen && voice.fileSample != index) {
+        f_close(&voice.file);
+        voice.fileOpen = false;
+    }
+    if (!voice.fileOpen && index >= 0) {
+        if (f_open(&voice.file, samples[index].file, (FA_OPEN_EXISTING | FA_READ)) == FR_OK) {
+            voice.fileOpen = true;
+            voice.fileSample = index;
+        }
+    }
+
+    // Reset the ring before marking the request served
+    voice.filledFrames = (index >= 0) ? samples[index].residentFrames : 0;
+    voice.served = request;
+}
+
+bool SampleStreamer::refill(StreamVoice& voice, SampleInfo& sample)
+{
+    const uint32_t resident = sample.residentFrames;
+    const uint32_t ringFrames = Constants::Streaming::RING_FRAMES;
+    const uint32_t numFrames = sample.numFrames;
+    const uint32_t total = numFrames + 1;  // One zeroed frame after the end for interpolation
+
+    uint32_t readFrame = voice.readFrame;
+    if (readFrame < resident) {
+        readFrame = resident;
+    }
+
+    // After an underrun playback may have moved past what was decoded
+    uint32_t filled = voice.filledFrames;
+    if (filled < readFrame) {
+        filled = readFrame;
+    }
+
+    // Never overwrite the slot of a frame the audio callback may still read
+    uint32_t limit = readFrame + ringFrames;
+    if (limit > total) {
+        limit = total;
+    }
+    if (filled >= limit) {
+        return false;
+    }
+
+    // Decode up to one chunk, stopping at the end of the ring
+    uint32_t slot = (filled - resident) % ringFrames;
+    uint32_t count = limit - filled;
+    if (count > (uint32_t)Constants::Streaming::REFILL_CHUNK_FRAMES) {
+        count = Constants::Streaming::REFILL_CHUNK_FRAMES;
+    }
+    if (count > ringFrames - slot) {
+        count = ringFrames - slot;
+    }
+
+    size_t frameSize = sample.reader.getDecodedFrameSize(format_);
+    char* dest = (char*)voice.ring + slot * frameSize;
+    uint32_t decodable = (filled < numFrames) ? numFrames - filled : 0;
+    if (decodable > count) {
+        decodable = count;
+    }
+
+    FatFileDataSource dataSource(&voice.file);
+    if (decodable > 0 && !sample.reader.decodeFrames(dataSource, filled, decodable, dest, format_)) {
+        // Read error: play silence rather than stall the voice
+        memset(dest, 0, decodable * frameSize);
+    }
+    if (count > decodable) {
+        memset(dest + decodable * frameSize, 0, (count - decodable) * frameSize);
+    }
+
+    // Mirror the head of the ring after its end so reads can cross the wrap
+    if (slot < (uint32_t)GUARD_FRAMES) {
+        uint32_t mirrored = GUARD_FRAMES - slot;
+        if (mirrored > count) {
+            mirrored = count;
+        }
+        memcpy((char*)voice.ring + (ringFrames + slot) * frameSize, dest, mirrored * frameSize);
+    }
+
+    // Publish only after the data is in place
+    voice.filledFrames = filled + count;
+    return true;
+}
+
+void SampleStreamer::service(SampleInfo* samples)
+{
+    if (!initialized_) {
+        return;
+    }
+
+    for (int i = 0; i < Constants::Streaming::MAX_STREAM_VOICES; i++) {
+        StreamVoice& voice = voices_[i];
+
+        if (voice.request != voice.served) {
+            restart(voice, samples);
+        }
+
+        // Close files of voices that have finished
+        if (!voice.active) {
+            if (voice.fileOpen) {
+                f_close(&voice.file);
+                voice.fileOpen = false;
+            }
+            continue;
+        }
+
+        if (!voice.fileOpen || voice.request != voice.served) {
+            continue;
+        }
+
+        for (int chunk = 0; chunk < Constants::Streaming::REFILL_CHUNKS_PER_SERVICE; chunk++) {
+            if (!refill(voice, samples[voice.fileSample])) {
+                break;
+            }
+        }
+    }
+}
+
+uint32_t SampleStreamer::getUnderrunCount() const
+{
+    uint32_t total = 0;
+    for (int i = 0; i < Constants::Streaming::MAX_STREAM_VOICES; i++) {
+        total += voices_[i].underruns;
+    }
+    return total;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "b3ReadWavFile.h"
+#include "daisy_seed.h"
+#include "Constants.h"
+
+struct SampleInfo;
+
+/**
+ * StreamVoice - One streaming playback slot
+ *
+ * Holds the open file and the SDRAM ring buffer for a streamed sample.
+ * The ring is single-producer/single-consumer:
+ * - the audio callback claims the voice, renders from it and publishes readFrame
+ * - the main loop opens the file and decodes frames ahead of readFrame
+ *
+ * Frame numbers are absolute positions in the sample. Frame f (f >= residentFrames)
+ * lives in ring slot (f - residentFrames) % RING_FRAMES. The first GUARD_FRAMES
+ * slots are mirrored after the end of the ring so interpolation can read past
+ * the wrap point without an extra test.
+ */
+struct StreamVoice {
+    // Written by the audio callback
+    volatile int sampleIndex;          // Sample being streamed (-1 = none)
+    volatile bool active;              // Voice is playing
+    volatile uint32_t request;         // Bumped on every (re)trigger
+    volatile uint32_t readFrame;       // Lowest frame the audio callback still needs
+    uint32_t startOrder;               // For stealing the oldest voice
+    uint32_t underruns;                // Blocks where the ring had not caught up
+
+    // Written by the main loop
+    volatile uint32_t served;          // Last request the ring was reset for
+    volatile uint32_t filledFrames;    // Frames [0, filledFrames) are available
+    FIL file;                          // Open WAV file for refills
+    bool fileOpen;
+    int fileSample;                    // Sample the open file belongs to
+
+    void* ring;                        // RING_FRAMES + GUARD_FRAMES decoded frames in SDRAM
+};
+
+/**
+ * SampleStreamer - Plays long samples from the SD card
+ *
+ * Samples whose decoded size exceeds Constants::Streaming::STREAM_THRESHOLD_BYTES
+ * keep only their first RESIDENT_MS in SDRAM. When one is triggered, playback
+ * starts from that resident head straight away while the main loop (service())
+ * opens the file and keeps a per-voice ring buffer filled ahead of the playback
+ * position. The audio callback never touches FatFS.
+ */
+class SampleStreamer {
+public:
+    // Extra frames mirrored after the ring (and decoded after the resident head)
+    static constexpr int GUARD_FRAMES = 2;
+
+    SampleStreamer();
+
+    /**
+     * Allocate the ring buffers from the SDRAM pool (first call only)
+     *
+     * @param format Decoded sample format (B3_DECODED_FLOAT32 / B3_DECODED_INT16)
+     * @return true if the rings are available
+     */
+    bool init(int format);
+
+    /**
+     * Number of frames of a sample to keep resident in SDRAM
+     */
+    static uint32_t residentFramesFor(const SampleInfo& sample);
+
+    /**
+     * Claim a voice for a sample (audio callback)
+     * Retriggering a sample that is already streaming restarts its voice;
+     * otherwise a free voice is used, or the oldest one is stolen.
+     *
+     * @return Voice index, or -1 if streaming is unavailable
+     */
+    int claim(int sampleIndex);
+
+    /**
+     * Check that a voice still belongs to a sample (it may have been stolen)
+     */
+    bool ownsVoice(int voice, int sampleIndex) const;
+
+    /**
+     * Release a voice once its sample has finished (audio callback)
+     */
+    void release(int voice);
+
+    /**
+     * Render a streamed sample (audio callback)
+     * Reads the resident head first, then the voice's ring. If the ring has not
+     * caught up, the rest of the block is silent and playback keeps time (the
+     * position moves on as if the frames had been played).
+     * Interpolation is at most linear: the ring has no frames before its start
+     * for the wider kernels.
+     */
+    void render(int voice, const SampleInfo& sample, b3WavTicker& ticker,
+                double speed, float volume, int size, float* out0, float* out1, int maxInterp);
+
+    /**
+     * Refill rings from the SD card (main loop)
+     *
+     * @param samples The sample table, used to reopen files and decode frames
+     */
+    void service(SampleInfo* samples);
+
+    // Total ring underruns since boot (for debugging)
+    uint32_t getUnderrunCount() const;
+
+private:
+    StreamVoice voices_[Constants::Streaming::MAX_STREAM_VOICES];
+    int format_;
+    bool initialized_;
+    uint32_t startCounter_;
+
+    // Open the voice's file for a new request and reset its ring
+    void restart(StreamVoice& voice, SampleInfo* samples);
+
+    // Decode the next chunk into the ring; returns false when nothing was written
+    bool refill(StreamVoice& voice, SampleInfo& sample);
+};
@@ -0,0 +1,284 @@
+#include "SdramHeap.h"
+
+static inline size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+SdramHeap::SdramHeap()
+    : base_(nullptr)
+    , size_(0)
+    , freeList_(nullptr)
+    , usedBytes_(0)
+    , highWaterBytes_(0)
+    , allocationCount_(0)
+    , failedAllocations_(0)
+{
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++) {
+        slabs_[i] = nullptr;
+    }
+}
+
+size_t SdramHeap::headerSize()
+{
+    // Keep the payload after the header on an ALIGNMENT boundary
+    return alignUp(sizeof(Block), ALIGNMENT);
+}
+
+int SdramHeap::sizeClassFor(size_t size)
+{
+    size_t slot = ALIGNMENT;
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++, slot <<= 1) {
+        if (size <= slot) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void SdramHeap::init(void* base, size_t size)
+{
+    uintptr_t start = alignUp((uintptr_t)base, ALIGNMENT);
+    size_t usable = (size - (start - (uintptr_t)base)) & ~(ALIGNMENT - 1);
+
+    base_ = (char*)start;
+    size_ = usable;
+    usedBytes_ = 0;
+    highWaterBytes_ = 0;
+    allocationCount_ = 0;
+    failedAllocations_ = 0;
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++) {
+        slabs_[i] = nullptr;
+    }
+
+    // Start with one free block covering the whole region
+    freeList_ = nullptr;
+    Block* block = (Block*)base_;
+    block->size = size_;
+    block->prevPhys = nullptr;
+    block->isFree = 1;
+    insertFree(block);
+}
+
+SdramHeap::Block* SdramHeap::nextPhys(Block* block) const
+{
+    char* next = (char*)block + block->size;
+    return (next < base_ + size_) ? (Block*)next : nullptr;
+}
+
+void SdramHeap::insertFree(Block* block)
+{
+    block->prevFree = nullptr;
+    block->nextFree = freeList_;
+    if (freeList_ != nullptr) {
+        freeList_->prevFree = block;
+    }
+    freeList_ = block;
+}
+
+void SdramHeap::removeFree(Block* block)
+{
+    if (block->prevFree != nullptr) {
+        block->prevFree->nextFree = block->nextFree;
+    } else {
+        freeList_ = block->nextFree;
+    }
+    if (block->nextFree != nullptr) {
+        block->nextFree->prevFree = block->prevFree;
+    }
+    block->nextFree = nullptr;
+    block->prevFree = nullptr;
+}
+
+void* SdramHeap::allocateBlock(size_t size)
+{
+    size_t needed = headerSize() + alignUp(size, ALIGNMENT);
+
+    // Best fit: smallest free block that is large enough
+    Block* best = nullptr;
+    for (Block* block = freeList_; block != nullptr; block = block->nextFree) {
+        if (block->size >= needed && (best == nullptr || block->size < best->size)) {
+            best = block;
+            if (best->size == needed) {
+                break;
+            }
+        }
+    }
+    if (best == nullptr) {
+        return nullptr;
+    }
+
+    removeFree(best);
+
+    // Split off the tail if it can hold another block
+    if (best->size - needed >= headerSize() + ALIGNMENT) {
+        Block* tail = (Block*)((char*)best + needed);
+        tail->size = best->size - needed;
+        tail->prevPhys = best;
+        tail->isFree = 1;
+        Block* after = nextPhys(tail);
+        if (after != nullptr) {
+            after->prevPhys = tail;
+        }
+        best->size = needed;
+        insertFree(tail);
+    }
+
+    best->isFree = 0;
+    usedBytes_ += best->size;
+    return (char*)best + headerSize();
+}
+
+void SdramHeap::freeBlock(Block* block)
+{
+    usedBytes_ -= block->size;
+    block->isFree = 1;
+
+    // Merge with the following block
+    Block* next = nextPhys(block);
+    if (next != nullptr && next->isFree) {
+        removeFree(next);
+        block->size += next->size;
+        Block* after = nextPhys(block);
+        if (after != nullptr) {
+            after->prevPhys = block;
+        }
+    }
+
+    // Merge into the preceding block
+    Block* prev = block->prevPhys;
+    if (prev != nullptr && prev->isFree) {
+        removeFree(prev);
+        prev->size += block->size;
+        Block* after = nextPhys(prev);
+        if (after != nullptr) {
+            after->prevPhys = prev;
+        }
+        block = prev;
+    }
+
+    insertFree(block);
+}
+
+void* SdramHeap::allocateSlot(int sizeClass)
+{
+    // Use a page of this class with a free slot, or carve a new one
+    SlabPage* page = slabs_[sizeClass];
+    while (page != nullptr && page->freeSlots == nullptr) {
+        page = page->next;
+    }
+
+    if (page == nullptr) {
+        void* memory = allocateBlock(SLAB_PAGE_SIZE);
+        if (memory == nullptr) {
+            return nullptr;
+        }
+        page = (SlabPage*)memory;
+        page->slotSize = (uint16_t)(ALIGNMENT << sizeClass);
+        size_t firstSlot = alignUp(sizeof(SlabPage), ALIGNMENT);
+        page->totalSlots = (uint16_t)((SLAB_PAGE_SIZE - firstSlot) / page->slotSize);
+        page->usedSlots = 0;
+
+        // Thread the free list through the slots
+        page->freeSlots = nullptr;
+        for (int i = page->totalSlots - 1; i >= 0; i--) {
+            void** slot = (void**)((char*)page + firstSlot + i * page->slotSize);
+            *slot = page->freeSlots;
+            page->freeSlots = slot;
+        }
+
+        page->next = slabs_[sizeClass];
+        slabs_[sizeClass] = page;
+    }
+
+    void** slot = (void**)page->freeSlots;
+    page->freeSlots = *slot;
+    page->usedSlots++;
+    return slot;
+}
+
+SdramHeap::SlabPage* SdramHeap::findSlabPage(void* ptr, int* sizeClass) const
+{
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++) {
+        for (SlabPage* page = slabs_[i]; page != nullptr; page = page->next) {
+            if ((char*)ptr > (char*)page && (char*)ptr < (char*)page + SLAB_PAGE_SIZE) {
+                *sizeClass = i;
+                return page;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void* SdramHeap::allocate(size_t size)
+{
+    if (base_ == nullptr || size == 0) {
+        return nullptr;
+    }
+
+    int sizeClass = (size <= MAX_SLAB_SIZE) ? sizeClassFor(size) : -1;
+    void* ptr = (sizeClass >= 0) ? allocateSlot(sizeClass) : allocateBlock(size);
+
+    if (ptr == nullptr) {
+        failedAllocations_++;
+        return nullptr;
+    }
+
+    allocationCount_++;
+    if (usedBytes_ > highWaterBytes_) {
+        highWaterBytes_ = usedBytes_;
+    }
+    return ptr;
+}
+
+void SdramHeap::free(void* ptr)
+{
+    if (ptr == nullptr || base_ == nullptr) {
+        return;
+    }
+    allocationCount_--;
+
+    int sizeClass;
+    SlabPage* page = findSlabPage(ptr, &sizeClass);
+    if (page == nullptr) {
+        freeBlock((Block*)((char*)ptr - headerSize()));
+        return;
+    }
+
+    *(void**)ptr = page->freeSlots;
+    page->freeSlots = ptr;
+    page->usedSlots--;
+
+    // Give empty pages back to the free list
+    if (page->usedSlots == 0) {
+        SlabPage** link = &slabs_[sizeClass];
+        while (*link != page) {
+            link = &(*link)->next;
+        }
+        *link = page->next;
+        freeBlock((Block*)((char*)page - headerSize()));
+    }
+}
+
+SdramHeap::Stats SdramHeap::getStats() const
+{
+    Stats stats;
+    stats.totalBytes = size_;
+    stats.usedBytes = usedBytes_;
+    stats.highWaterBytes = highWaterBytes_;
+    stats.freeBytes = 0;
+    stats.largestFreeBlock = 0;
+    stats.freeBlockCount = 0;
+    stats.allocationCount = allocationCount_;
+    stats.failedAllocations = failedAllocations_;
+
+    for (Block* block = freeList_; block != nullptr; block = block->nextFree) {
+        stats.freeBytes += block->size;
+        stats.freeBlockCount++;
+        size_t payload = block->size - headerSize();
+        if (payload > stats.largestFreeBlock) {
+            stats.largestFreeBlock = payload;
+        }
+    }
+    return stats;
+}
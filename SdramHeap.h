@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * SdramHeap - Freeing allocator for the SDRAM pool
+ *
+ * Replaces the old bump pointer so samples can be evicted, swapped and
+ * rescanned without leaking memory until reboot.
+ *
+ * - Small requests (metadata) come from fixed size-class slabs.
+ * - Larger requests (audio buffers) come from a best-fit free list with
+ *   boundary tags, and neighbouring free blocks are merged on free.
+ * - Every pointer handed out is 32-byte aligned (one cache line), ready for DMA.
+ *
+ * Not thread safe: allocate and free from the main loop only.
+ */
+class SdramHeap {
+public:
+    static constexpr size_t ALIGNMENT = 32;
+    static constexpr int NUM_SIZE_CLASSES = 5;         // 32, 64, 128, 256, 512 bytes
+    static constexpr size_t MAX_SLAB_SIZE = 512;       // Larger requests use the free list
+    static constexpr size_t SLAB_PAGE_SIZE = 4096;     // Slab pages are carved from the free list
+
+    // Usage numbers for the debug screen
+    struct Stats {
+        size_t totalBytes;         // Size of the managed region
+        size_t usedBytes;          // Bytes in live blocks (including headers and slab pages)
+        size_t highWaterBytes;     // Peak of usedBytes since init
+        size_t freeBytes;          // Bytes in free blocks
+        size_t largestFreeBlock;   // Biggest single allocation that could succeed right now
+        uint32_t freeBlockCount;   // Number of free-list fragments
+        uint32_t allocationCount;  // Live allocations (slab and free list)
+        uint32_t failedAllocations;
+
+        // 0 = all free space in one block, 100 = free space fully scattered
+        int fragmentationPercent() const
+        {
+            if (freeBytes == 0) {
+                return 0;
+            }
+            return (int)(100 - (uint64_t)largestFreeBlock * 100 / freeBytes);
+        }
+    };
+
+    SdramHeap();
+
+    /**
+     * Take over a memory region
+     *
+     * @param base Start of the region (aligned up to ALIGNMENT)
+     * @param size Size in bytes
+     */
+    void init(void* base, size_t size);
+
+    /**
+     * Allocate size bytes (32-byte aligned)
+     *
+     * @return Pointer, or nullptr if no block is large enough
+     */
+    void* allocate(size_t size);
+
+    /**
+     * Return memory from allocate(); nullptr is ignored
+     */
+    void free(void* ptr);
+
+    Stats getStats() const;
+
+private:
+    // Header in front of every free-list block (free or used)
+    struct Block {
+        size_t size;           // Whole block, header included
+        Block* prevPhys;       // Block physically before this one (nullptr for the first)
+        Block* nextFree;       // Free-list links (valid while free)
+        Block* prevFree;
+        uint32_t isFree;
+    };
+
+    // Header at the start of every slab page
+    struct SlabPage {
+        SlabPage* next;        // Next page of the same size class
+        void* freeSlots;       // Singly linked list through the free slots
+        uint16_t slotSize;
+        uint16_t usedSlots;
+        uint16_t totalSlots;
+    };
+
+    static size_t headerSize();
+    static int sizeClassFor(size_t size);
+
+    Block* nextPhys(Block* block) const;
+    void insertFree(Block* block);
+    void removeFree(Block* block);
+
+    void* allocateBlock(size_t size);
+    void freeBlock(Block* block);
+
+    void* allocateSlot(int sizeClass);
+    SlabPage* findSlabPage(void* ptr, int* sizeClass) const;
+
+    char* base_;
+    size_t size_;
+    Block* freeList_;
+    SlabPage* slabs_[NUM_SIZE_CLASSES];
+
+    size_t usedBytes_;
+    size_t highWaterBytes_;
+    uint32_t allocationCount_;
+    uint32_t failedAllocations_;
+};
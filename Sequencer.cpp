@@ -1,11 +1,18 @@
 #include "Sequencer.h"
 #include "Utils.h"
+#include "AudioProfiler.h"
 #include <string.h>
 
+// Audio callback profiler defined in SimpleSampler.cpp
+extern AudioProfiler audioProfiler;
+
 Sequencer::Sequencer(SampleLibrary* sampleLibrary, int sampleRate)
     : sampleLibrary_(sampleLibrary)
+    , metronome_(nullptr)
     , sampleRate_(sampleRate)
-    , samplesSinceLastStep_(0)
+    , clock_(sampleRate)
+    , resetPending_(false)
+    , stealMode_(STEAL_OLDEST)
 {
 }
 
@@ -14,20 +21,10 @@ void Sequencer::init()
     // Initialize the sequencer state
     state_.init();
 
-    // Calculate initial samples per step
-    state_.samplesPerStep = calculateSamplesPerStep(state_.bpm);
-
-    // Reset sample counter
-    samplesSinceLastStep_ = 0;
-}
-
-uint32_t Sequencer::calculateSamplesPerStep(int bpm)
-{
-    // Formula: samplesPerStep = (sampleRate * 60) / (bpm * 4)
-    // This gives samples per 16th note
-    // - sampleRate * 60 = samples per minute
-    // - bpm * 4 = 16th notes per minute (4 per quarter note)
-    return (sampleRate_ * 60) / (bpm * 4);
+    // Start the step clock at the default tempo
+    clock_.setTempo(state_.bpm);
+    clock_.requestRestart();
+    state_.samplesPerStep = clock_.samplesPerStepFor(state_.bpm);
 }
 
 void Sequencer::setBpm(float bpm)
@@ -39,54 +36,86 @@ void Sequencer::setBpm(float bpm)
         bpm = Constants::UI::MAX_BPM;
     }
 
-    state_.bpm = static_cast<int>(bpm);
+    state_.bpm = bpm;
+    state_.samplesPerStep = clock_.samplesPerStepFor(bpm);
 
-    // Recalculate samples per step
-    state_.samplesPerStep = calculateSamplesPerStep(state_.bpm);
+    // The audio callback picks this up at the next step boundary (or start)
+    clock_.setTempo(bpm);
 }
 
 void Sequencer::setRunning(bool running)
 {
-    state_.isRunning = running;
-
     if (running) {
-        // Reset sample counter when starting
-        samplesSinceLastStep_ = 0;
+        // Restart the step clock when starting (the callback does it before
+        // counting the next block)
+        clock_.requestRestart();
         state_.stepStartTime = daisy::System::GetNow();
     }
+
+    state_.isRunning = running;
 }
 
 void Sequencer::processAudio(float** out, size_t size)
 {
-    // Delegate audio processing to SampleLibrary
-    // The sequencer only handles timing and triggering
-    sampleLibrary_->processAudio(out, size);
+    ScopedProfile profile(audioProfiler, STAGE_SEQUENCER);
 
-    // If not running, no step advancement
-    if (!state_.isRunning) {
-        return;
+    // Start or reset requested by the main loop
+    if (clock_.serviceRestart() && resetPending_) {
+        resetPending_ = false;
+        state_.currentStep = 0;
     }
 
-    // Track samples processed in this audio callback
-    samplesSinceLastStep_ += static_cast<uint32_t>(size);
+    // Render the block in segments that end on step boundaries, so a step's
+    // triggers land on the sample where the step starts
+    size_t offset = 0;
+    while (offset < size) {
+        size_t segment = size - offset;
 
-    // Check if we need to advance to next step
-    while (samplesSinceLastStep_ >= state_.samplesPerStep) {
-        samplesSinceLastStep_ -= state_.samplesPerStep;
+        if (state_.isRunning) {
+            // A step is due on this sample
+            if (clock_.stepDue()) {
+                advanceStep();
+            }
 
-        // Advance to next step
-        state_.currentStep = (state_.currentStep + 1) % Constants::Sequencer::NUM_STEPS;
+            segment = clock_.samplesUntilStep(segment);
+            clock_.advance(segment);
+        }
 
-        // Update step start time
-        state_.stepStartTime = daisy::System::GetNow();
+        renderSegment(out, offset, segment);
+        offset += segment;
+    }
+}
 
-        // Trigger samples for active steps at the new step
-        triggerStep(state_.currentStep);
+void Sequencer::renderSegment(float** out, size_t offset, size_t count)
+{
+    float* segmentOut[2] = { out[0] + offset, out[1] + offset };
 
-        // Trigger metronome if enabled
-        if (state_.metronomeEnabled) {
-            triggerMetronome();
-        }
+    // Delegate audio processing to SampleLibrary (clears the segment first;
+    // track voices live in its voice pool)
+    sampleLibrary_->processAudio(segmentOut, count);
+
+    // Metronome adds its click on top
+    if (metronome_ != nullptr) {
+        uint32_t start = AudioProfiler::now();
+        metronome_->process(segmentOut, count);
+        audioProfiler.add(STAGE_METRONOME, start);
+    }
+}
+
+void Sequencer::advanceStep()
+{
+    // Advance to next step
+    state_.currentStep = (state_.currentStep + 1) % Constants::Sequencer::NUM_STEPS;
+
+    // Update step start time
+    state_.stepStartTime = daisy::System::GetNow();
+
+    // Trigger samples for active steps at the new step
+    triggerStep(state_.currentStep);
+
+    // Trigger metronome if enabled
+    if (state_.metronomeEnabled) {
+        triggerMetronome();
     }
 }
 
@@ -125,41 +154,10 @@ void Sequencer::triggerTrack(int trackIndex)
         return;
     }
 
-    // Trigger the sample via SampleLibrary
-    // SampleLibrary will handle the actual playback
-    sampleLibrary_->triggerSample(track.sampleIndex);
-
-    // Mark track as playing
-    track.isPlaying = true;
-}
-
-void Sequencer::triggerStep(int step)
-{
-    // Check all tracks and trigger those with active steps
-    for (int trackIdx = 0; trackIdx < Constants::Sequencer::NUM_TRACKS; trackIdx++) {
-        if (shouldTriggerTrack(trackIdx, step)) {
-            triggerTrack(trackIdx);
-        }
-    }
-}
-
-void Sequencer::triggerMetronome()
-{
-    // Placeholder for metronome implementation
-    // This will be implemented when the Metronome class is added
-    // For now, this is a no-op
-}
-
-Track* Sequencer::getTrack(int index)
-{
-    if (index < 0 || index >= Constants::Sequencer::NUM_TRACKS) {
-        return nullptr;
-    }
-    return &state_.tracks[index];
-}
-
-const Track* Sequencer::getTrack(int index) const {
-    return const_cast<Sequencer*>(this)->getTrack(index);
+    // Start a pooled voice tagged with the track, so earlier hits keep ringing
+    // up to the track's polyphony; drums outrank grains when the pool is full
+    sampleLibrary_->triggerVoice(track.sampleIndex, VOICE_PRIORITY_TRACK, trackIndex,
+                                 track.polyphony, stealMode_, track.volume);
 }
 
 void Sequencer::setTrackSample(int trackIndex, int sampleIndex)
@@ -169,6 +167,17 @@ void Sequencer::setTrackSample(int trackIndex, int sampleIndex)
         return;
     }
 
+    // Keep the new sample resident while assigned; let the old one be evicted
+    if (sampleIndex >= 0 && !sampleLibrary_->retainSample(sampleIndex)) {
+        return;
+    }
+    if (track->sampleIndex >= 0) {
+        // Hits of the old sample stop on the next block (the library keeps
+        // the sample from being evicted until they have)
+        sampleLibrary_->requestStopVoices(VOICE_PRIORITY_TRACK, trackIndex);
+        sampleLibrary_->releaseSample(track->sampleIndex);
+    }
+
     track->sampleIndex = sampleIndex;
 
     // Update sample name cache
@@ -185,6 +194,29 @@ void Sequencer::setTrackSample(int trackIndex, int sampleIndex)
     }
 }
 
+void Sequencer::setTrackPolyphony(int trackIndex, int voices)
+{
+    Track* track = getTrack(trackIndex);
+    if (track == nullptr) {
+        return;
+    }
+
+    if (voices < 1) {
+        voices = 1;
+    } else if (voices > Constants::Sequencer::MAX_VOICES_PER_TRACK) {
+        voices = Constants::Sequencer::MAX_VOICES_PER_TRACK;
+    }
+
+    // Voices already playing finish naturally; the limit applies to new hits
+    track->polyphony = voices;
+}
+
+int Sequencer::getTrackPolyphony(int trackIndex) const
+{
+    const Track* track = getTrack(trackIndex);
+    return (track != nullptr) ? track->polyphony : 0;
+}
+
 void Sequencer::setStepActive(int trackIndex, int stepIndex, bool active)
 {
     Track* track = getTrack(trackIndex);
@@ -213,8 +245,9 @@ bool Sequencer::isStepActive(int trackIndex, int stepIndex) const
 
 void Sequencer::reset()
 {
-    state_.currentStep = 0;
-    samplesSinceLastStep_ = 0;
+    // Applied by the audio callback before its next block
+    resetPending_ = true;
+    clock_.requestRestart();
     state_.stepStartTime = daisy::System::GetNow();
 }
 
@@ -2,6 +2,8 @@
 
 #include "b3ReadWavFile.h"
 #include "SampleLibrary.h"
+#include "Metronome.h"
+#include "StepClock.h"
 #include "daisy_core.h"
 #include "Constants.h"
 
@@ -11,7 +13,7 @@
  * Each track has:
  * - A sample assigned from the SampleLibrary
  * - A 16-step pattern (active/inactive)
- * - A b3WavTicker for independent polyphonic playback
+ * - Up to polyphony overlapping hits, played on voices from SampleLibrary's shared pool
  * - Volume, mute, and solo controls
  */
 struct Track {
@@ -23,8 +25,7 @@ struct Track {
     bool steps[Constants::Sequencer::NUM_STEPS];
 
     // Playback State
-    b3WavTicker ticker;          // Independent ticker for polyphonic playback
-    bool isPlaying;              // Is this track currently playing?
+    int polyphony;               // Voices this track may use (1 - MAX_VOICES_PER_TRACK)
 
     // Track Properties
     float volume;                // Track volume (0.0 - 1.0)
@@ -38,7 +39,7 @@ struct Track {
         for (int i = 0; i < Constants::Sequencer::NUM_STEPS; i++) {
             steps[i] = false;
         }
-        isPlaying = false;
+        polyphony = Constants::Sequencer::DEFAULT_POLYPHONY;
         volume = 1.0f;
         mute = false;
         solo = false;
@@ -53,10 +54,10 @@ struct Track {
  */
 struct SequencerState {
     // Timing
-    int bpm;                     // Current tempo (60-180)
+    float bpm;                   // Requested tempo (60-180, fractional)
     int currentStep;             // Current step position (0-15)
     uint32_t stepStartTime;      // Timestamp when current step started
-    uint32_t samplesPerStep;     // Number of audio samples per step
+    uint32_t samplesPerStep;     // Nominal audio samples per step (rounded, informational)
     bool isRunning;              // Sequencer running state
 
     // Track Data
@@ -68,7 +69,7 @@ struct SequencerState {
 
     // Initialization
     void init() {
-        bpm = 120;               // Default BPM
+        bpm = 120.0f;            // Default BPM
         currentStep = 0;
         stepStartTime = 0;
         samplesPerStep = 0;
@@ -86,27 +87,33 @@ struct SequencerState {
  * Sequencer - Core timing and step logic for 16-step sequencer
  *
  * Manages:
- * - BPM-based timing calculation
+ * - BPM-based timing calculation (exact phase accumulator, see StepClock)
  * - Step advancement synchronized to audio callback
  * - Track triggering when steps become active
  * - Integration with SampleLibrary for sample playback
  *
  * The sequencer handles timing and triggering, but audio mixing
- * is delegated to SampleLibrary::processAudio().
+ * is delegated to SampleLibrary::processAudio() and Metronome::process().
+ * Each audio block is split at step boundaries, so triggers and clicks
+ * start on the exact sample rather than at the next block.
+ *
+ * Step timing is a StepClock (exact phase accumulator, no drift). Only the
+ * audio callback moves it: tempo changes wait for the next step boundary,
+ * and start/reset are staged for the next block like the tempo.
  */
 class Sequencer {
 private:
     SequencerState state_;
     SampleLibrary* sampleLibrary_;
+    Metronome* metronome_;
     int sampleRate_;
 
-    // Sample count tracking for step timing
-    uint32_t samplesSinceLastStep_;
+    // Step timing; moved only by processAudio()
+    StepClock clock_;
+    volatile bool resetPending_;          // reset() asked for step 0 with the clock restart
 
-    // Calculate samples per step based on BPM
-    // Formula: samplesPerStep = (sampleRate * 60) / (bpm * 4)
-    // This gives samples per 16th note
-    uint32_t calculateSamplesPerStep(int bpm);
+    // Which of a track's voices is stolen when it runs out
+    VoiceStealMode stealMode_;
 
     // Check if step should trigger for a track
     bool shouldTriggerTrack(int trackIndex, int step);
@@ -117,6 +124,12 @@ private:
     // Trigger a specific track
     void triggerTrack(int trackIndex);
 
+    // Move to the next step and fire its triggers
+    void advanceStep();
+
+    // Render samples and metronome into out[0..1][offset, offset + count)
+    void renderSegment(float** out, size_t offset, size_t count);
+
 public:
     // Constructor
     Sequencer(SampleLibrary* sampleLibrary, int sampleRate);
@@ -127,8 +140,8 @@ public:
     // Set BPM (clamped to MIN_BPM - MAX_BPM)
     void setBpm(float bpm);
 
-    // Get current BPM
-    float getBpm() const { return static_cast<float>(state_.bpm); }
+    // Get current BPM (as requested; takes effect at the next step while running)
+    float getBpm() const { return state_.bpm; }
 
     // Start/stop sequencer
     void setRunning(bool running);
@@ -143,7 +156,10 @@ public:
     // Get current step index (0-15)
     int getCurrentStep() const { return state_.currentStep; }
 
-    // Trigger metronome (for future metronome integration)
+    // Attach the metronome that is clicked on each step and mixed into the output
+    void setMetronome(Metronome* metronome) { metronome_ = metronome; }
+
+    // Trigger a metronome click
     void triggerMetronome();
 
     // Get track by index (0-2)
@@ -155,6 +171,14 @@ public:
     // Assign sample to track
     void setTrackSample(int trackIndex, int sampleIndex);
 
+    // Set how many overlapping voices a track may use (clamped to 1 - MAX_VOICES_PER_TRACK)
+    void setTrackPolyphony(int trackIndex, int voices);
+    int getTrackPolyphony(int trackIndex) const;
+
+    // Choose which voice is stolen when a track runs out of voices
+    void setVoiceStealMode(VoiceStealMode mode) { stealMode_ = mode; }
+    VoiceStealMode getVoiceStealMode() const { return stealMode_; }
+
     // Set step active/inactive
     void setStepActive(int trackIndex, int stepIndex, bool active);
 
@@ -7,6 +7,7 @@
 
 #include "Config.h"
 #include "DisplayManager.h"
+#include "PagedOledDisplay.h"
 #include "SampleLibrary.h"
 #include "Sequencer.h"
 #include "Metronome.h"
@@ -14,6 +15,8 @@
 #include "Menus.h"
 #include "daisysp.h"
 #include "Constants.h"
+#include "SdramHeap.h"
+#include "AudioProfiler.h"
 
 using namespace daisy;
 using namespace daisysp;
@@ -24,10 +27,11 @@ namespace Config {
     int samplerate;
 }
 
-using MyOledDisplay = OledDisplay<SSD130x4WireSpi128x64Driver>;
-
 DaisyPod      hw;
+// The OLED (sends only changed pages, without blocking), as DisplayManager's backend
+using MyOledDisplay = PagedOledDisplay;
 MyOledDisplay display;
+static OledDisplayBackend displayBackend(display);
 Parameter p_knob1, p_knob2;
 
 // SD Card and filesystem
@@ -48,6 +52,11 @@ static SampleLibrary* library = nullptr;
 static uint32_t debugLastDisplayUpdate = 0;
 static const uint32_t DEBUG_DISPLAY_INTERVAL_MS = 500;  // Update debug display every 0.5 seconds
 static bool debugEnabled = false;  // Set to true to enable debug output
+static uint32_t debugPageCounter = 0;  // Debug screen alternates between state and CPU pages
+static const uint32_t DEBUG_UPDATES_PER_PAGE = 4;  // 2 seconds per page
+
+// Audio callback CPU profiler (read by the debug screen)
+AudioProfiler audioProfiler;
 
 // Sequencer components (pointers, initialized in main)
 static Sequencer* sequencer = nullptr;
@@ -57,18 +66,23 @@ static UIManager* uiManager = nullptr;
 // Granular test mode state
 static AppMode previousMode = MODE_MAIN_MENU;
 
+// Last time the controls were read (microseconds)
+static uint32_t lastControlPollUs = 0;
+
 // Memory pool for SDRAM
-DSY_SDRAM_BSS char custom_pool[Constants::Memory::CUSTOM_POOL_SIZE];
-size_t pool_index = 0;
+DSY_SDRAM_BSS char custom_pool[Constants::Memory::CUSTOM_POOL_SIZE] __attribute__((aligned(32)));
+static SdramHeap sdramHeap;
 
 // Custom memory allocator
+// Allocations are 32-byte aligned (one cache line) so decoded sample frames start aligned.
+// Main loop only: the heap is not safe to use from the audio callback.
 void* custom_pool_allocate(size_t size) {
-    if (pool_index + size >= Constants::Memory::CUSTOM_POOL_SIZE) {
-        return nullptr;
-    }
-    void* ptr = &custom_pool[pool_index];
-    pool_index += size;
-    return ptr;
+    return sdramHeap.allocate(size);
+}
+
+// Return memory from custom_pool_allocate() to the pool
+void custom_pool_free(void* ptr) {
+    sdramHeap.free(ptr);
 }
 
 
@@ -89,6 +103,8 @@ void AudioCallback(AudioHandle::InputBuffer  in,
                    AudioHandle::OutputBuffer out,
                    size_t                                size)
 {
+    audioProfiler.beginCallback();
+
     // Clear output buffers
     for(size_t i = 0; i < size; i++) {
         out[0][i] = 0.0f;
@@ -103,17 +119,29 @@ void AudioCallback(AudioHandle::InputBuffer  in,
         // The display update will be handled in the main loop
     }
     
+    // Keep recording the input for live granular (stops while frozen)
+    library->recordInput(in, size);
+    
+    // Trade voice interpolation quality for headroom when the last callback ran close to the deadline
+    library->updateInterpolationCeiling(audioProfiler.getLastLoadPercent());
+    
+    // Stops queued by the main loop go first, so this block's triggers and
+    // the grain budget already see the freed voices
+    library->processStopRequests();
+    
     // Process audio based on current mode
     if (uiManager->getCurrentMode() == MODE_SEQUENCER) {
-        // Process sequencer audio (includes sample playback and metronome triggering)
+        // Process sequencer audio (sample playback and metronome, split at step boundaries)
         sequencer->processAudio(out, size);
-        
-        // Process metronome (adds metronome sound to output)
-        metronome->process(out, size);
     } else if (uiManager->getCurrentMode() == MODE_GRANULAR) {
         // Process granular synthesis audio
         library->processAudio(out, size);
     }
+
+    // Lets the loader free evicted sample memory once no callback can be reading it
+    library->audioBlockDone();
+
+    audioProfiler.endCallback(size);
 }
 
 void updateSequencerLED(DaisyPod& hw, Sequencer* sequencer)
@@ -135,6 +163,36 @@ void updateSequencerLED(DaisyPod& hw, Sequencer* sequencer)
 }
 
 
+// DEBUG: Display audio callback CPU usage (avg/max microseconds per stage)
+void debugDisplayProfile()
+{
+    static const char* stageNames[NUM_PROFILE_STAGES] = { "All", "Seq", "Smp", "Grn", "Met" };
+    
+    ProfileStats stats;
+    audioProfiler.getStats(stats);
+    uint32_t cyclesPerUs = (stats.cyclesPerUs > 0) ? stats.cyclesPerUs : 1;
+    
+    display_.clear();
+    char line[32];
+    display_.setCursor(0, 0);
+    snprintf(line, sizeof(line), "CPU%3u%% pk%3u%% o%u",
+             (unsigned)stats.loadPercent, (unsigned)stats.peakPercent, (unsigned)stats.overruns);
+    display_.writeString(line, Font_7x10);
+    
+    for (int i = 0; i < NUM_PROFILE_STAGES; i++) {
+        display_.setCursor(0, 10 + i * 10);
+        snprintf(line, sizeof(line), "%s %5u/%5uus", stageNames[i],
+                 (unsigned)(stats.stages[i].avg / cyclesPerUs),
+                 (unsigned)(stats.stages[i].max / cyclesPerUs));
+        display_.writeString(line, Font_7x10);
+    }
+    
+    display_.update();
+    
+    // Peaks cover one page cycle
+    audioProfiler.requestReset();
+}
+
 // DEBUG: Display current mode and sequencer state
 void debugDisplayState()
 {
@@ -146,14 +204,26 @@ void debugDisplayState()
     }
     debugLastDisplayUpdate = now;
     
+    // Every other page shows the CPU profiler
+    debugPageCounter++;
+    if ((debugPageCounter / DEBUG_UPDATES_PER_PAGE) % 2 == 1) {
+        debugDisplayProfile();
+        return;
+    }
+    
     // Get current state
     AppMode mode = uiManager->getCurrentMode();
     bool isRunning = sequencer->isRunning();
     
-    // Clear and display debug info
+    // Clear and display debug info (UI frame time avg/max, bytes of the last OLED frame)
+    const RenderStats& renderStats = uiManager->getRenderStats();
+    OledFrameStats frameStats = display_.getFrameStats();
+    char header[32];
+    snprintf(header, sizeof(header), "UI%u/%uus %uB", (unsigned)renderStats.avgUs, (unsigned)renderStats.maxUs,
+             (unsigned)frameStats.lastBytes);
     display_.clear();
     display_.setCursor(0, 0);
-    display_.writeString("DEBUG INFO:", Font_7x10);
+    display_.writeString(header, Font_7x10);
     
     // Display mode
     display_.setCursor(0, 12);
@@ -183,11 +253,15 @@ void debugDisplayState()
         snprintf(line, sizeof(line), "%d", library->getDebugGrainSpawnFailures());
         display_.writeString(line, Font_7x10);
         
-        // Display active grain count
+        // Display active grain count and average cycles per grain per block
+        ProfileStats stats;
+        audioProfiler.getStats(stats);
+        int activeGrains = library->getActiveGrainCount();
+        unsigned cyclesPerGrain = (activeGrains > 0) ? (unsigned)(stats.stages[STAGE_GRAINS].avg / activeGrains) : 0;
         display_.setCursor(0, 48);
         display_.writeString("Active:", Font_7x10);
         display_.setCursor(56, 48);
-        snprintf(line, sizeof(line), "%d", library->getActiveGrainCount());
+        snprintf(line, sizeof(line), "%d %uc", activeGrains, cyclesPerGrain);
         display_.writeString(line, Font_7x10);
     } else {
         // Sequencer mode debug info
@@ -202,11 +276,99 @@ void debugDisplayState()
         display_.writeString("Audio: ", Font_7x10);
         display_.setCursor(56, 36);
         display_.writeString((mode == MODE_SEQUENCER) ? "ENABLED" : "DISABLED", Font_7x10);
+        
+        // Display SDRAM heap usage (used / high-water in MB, fragmentation, sample octave levels)
+        SdramHeap::Stats heapStats = sdramHeap.getStats();
+        SampleLibraryStats libraryStats = library->getStats();
+        char line[32];
+        display_.setCursor(0, 48);
+        snprintf(line, sizeof(line), "Mem:%u/%uM f%d%% m%u",
+                 (unsigned)(heapStats.usedBytes >> 20),
+                 (unsigned)(heapStats.highWaterBytes >> 20),
+                 heapStats.fragmentationPercent(),
+                 (unsigned)(libraryStats.mipBytes >> 20));
+        display_.writeString(line, Font_7x10);
     }
     
     display_.update();
 }
 
+// Read the knobs, encoder and buttons and pass them to the UI
+// Called at a fixed rate (Constants::UI::CONTROL_POLL_US) so debouncing and hold
+// timing don't depend on how long the rest of the main loop pass took
+void processControls()
+{
+    hw.ProcessDigitalControls();
+
+    // === Knob and Button Handling (only in sequencer mode) ===
+    if (uiManager->getCurrentMode() == MODE_SEQUENCER) {
+        // === Knob 1: BPM Control (60-180) ===
+        float knob1_value = p_knob1.Process();
+        float bpm = Constants::UI::MIN_BPM + (knob1_value * Constants::UI::BPM_RANGE);  // Map 0.0-1.0 to 60-180 BPM
+        sequencer->setBpm(bpm);
+        
+        // === Knob 2: Metronome Volume (0.0-1.0) ===
+        float knob2_value = p_knob2.Process();
+        metronome->setVolume(knob2_value);
+    } else {
+        // Process knobs anyway to prevent stale values
+        p_knob1.Process();
+        p_knob2.Process();
+    }
+    
+    // === Encoder Handling ===
+    int32_t enc_incr = hw.encoder.Increment();
+    if(enc_incr > 0) {
+        uiManager->handleEncoderIncrement();
+    } else if(enc_incr < 0) {
+        uiManager->handleEncoderDecrement();
+    }
+    
+    // Encoder click detection (rising edge = button pressed)
+    if(hw.encoder.RisingEdge()) {
+        // Record press time for hold detection
+        uiManager->getState().encoderPressed = true;
+        uiManager->getState().encoderPressTime = System::GetNow();
+        uiManager->getState().encoderHeld = false;
+        uiManager->handleEncoderClick();
+    }
+    
+    // Encoder release detection (falling edge = button released)
+    if(hw.encoder.FallingEdge()) {
+        // Reset hold state
+        uiManager->getState().encoderPressed = false;
+        uiManager->getState().encoderHeld = false;
+    }
+    
+    // Non-blocking hold detection (check if pressed for more than 500ms)
+    if(uiManager->getState().encoderPressed && !uiManager->getState().encoderHeld) {
+        uint32_t pressDuration = System::GetNow() - uiManager->getState().encoderPressTime;
+        if(pressDuration >= Constants::UI::HOLD_DETECT_MS) {
+            // Hold detected - call handleEncoderHold() once
+            uiManager->getState().encoderHeld = true;
+            uiManager->handleEncoderHold();
+        }
+    }
+    
+    // === Button Handling ===
+    if(hw.button1.RisingEdge()) {
+        uiManager->handleButton1Press();
+        // Open the gate in granular mode when Button1 is pressed
+        if (uiManager->getCurrentMode() == MODE_GRANULAR) {
+            library->setGateOpen(true);
+        }
+    }
+    if(hw.button1.FallingEdge()) {
+        // Close the gate in granular mode when Button1 is released
+        if (uiManager->getCurrentMode() == MODE_GRANULAR) {
+            library->setGateOpen(false);
+        }
+    }
+    if(hw.button2.RisingEdge()) {
+        uiManager->handleButton2Press();
+    }
+}
+
 int main(void)
 {
     hw.Init();
@@ -215,14 +377,17 @@ int main(void)
 
     /** Configure then initialize the Display */
     MyOledDisplay::Config disp_cfg;
-    disp_cfg.driver_config.transport_config.pin_config.dc = hw.seed.GetPin(9);
-    disp_cfg.driver_config.transport_config.pin_config.reset = hw.seed.GetPin(22);
+    disp_cfg.transport_config.pin_config.dc = hw.seed.GetPin(9);
+    disp_cfg.transport_config.pin_config.reset = hw.seed.GetPin(22);
     display.Init(disp_cfg);
 
     // Initialize DisplayManager - wraps the display for easy access
-    new (&display_) DisplayManager(display, hw);
+    new (&display_) DisplayManager(displayBackend);
 
-    display_.showMessage("Initializing...", 100);
+    display_.showMessageBlocking("Initializing...", 0);
+
+    // Hand the SDRAM pool to the heap before anything allocates from it
+    sdramHeap.init(custom_pool, Constants::Memory::CUSTOM_POOL_SIZE);
 
     // Initialize the knobs
     float r = 0, g = 0, b = 0;
@@ -244,10 +409,10 @@ int main(void)
     // Mount SD Card
     f_mount(&fsi.GetSDFileSystem(), "/", 1);
         
-    // Initialize library
+    // Initialize library (samples are read from the card by the main loop, after audio starts)
     library = new SampleLibrary(sdcard, fsi, display_);
     if (!library->init()) {
-        display_.showMessage("SD Card Error!", 2000);
+        display_.showMessageBlocking("SD Card Error!", 0);
         while(1);  // Halt
     }
 
@@ -256,6 +421,7 @@ int main(void)
     sequencer->init();
     metronome = new Metronome();
     metronome->init(static_cast<float>(Config::samplerate));
+    sequencer->setMetronome(metronome);
     uiManager = new UIManager(&display_, sequencer, library);
     uiManager->init();
     
@@ -265,13 +431,27 @@ int main(void)
     
     display_.showMessage("Ready!", 400);
 
-    // Start the audio callback
+    // Start the audio callback (profiled against the core clock)
+    audioProfiler.init(static_cast<float>(Config::samplerate), System::GetSysClkFreq());
     hw.StartAudio(AudioCallback);
 
     while(1)
     {
-        uint32_t now = System::GetNow();
-        hw.ProcessDigitalControls();
+        // === Controls, polled at a fixed rate independent of rendering ===
+        uint32_t nowUs = System::GetUs();
+        if (nowUs - lastControlPollUs >= Constants::UI::CONTROL_POLL_US) {
+            lastControlPollUs = nowUs;
+            processControls();
+        }
+
+        // === Send the rest of the last OLED frame ===
+        display_.serviceTransfer();
+
+        // === Read sample headers and audio in the background ===
+        library->serviceLoader();
+
+        // === Keep streaming samples fed from the SD card ===
+        library->serviceStreams();
 
         // === Granular Test Mode Logic ===
         AppMode currentMode = uiManager->getCurrentMode();
@@ -293,75 +473,7 @@ int main(void)
         // Note: Auto-spawning is now handled in SampleLibrary::processAudio()
         // This legacy code has been removed to avoid conflicts
 
-        // === Knob and Button Handling (only in sequencer mode) ===
-        if (uiManager->getCurrentMode() == MODE_SEQUENCER) {
-            // === Knob 1: BPM Control (60-180) ===
-            float knob1_value = p_knob1.Process();
-            float bpm = Constants::UI::MIN_BPM + (knob1_value * Constants::UI::BPM_RANGE);  // Map 0.0-1.0 to 60-180 BPM
-            sequencer->setBpm(bpm);
-            
-            // === Knob 2: Metronome Volume (0.0-1.0) ===
-            float knob2_value = p_knob2.Process();
-            metronome->setVolume(knob2_value);
-        } else {
-            // Process knobs anyway to prevent stale values
-            p_knob1.Process();
-            p_knob2.Process();
-        }
-        
-        // === Encoder Handling ===
-        int32_t enc_incr = hw.encoder.Increment();
-        if(enc_incr > 0) {
-            uiManager->handleEncoderIncrement();
-        } else if(enc_incr < 0) {
-            uiManager->handleEncoderDecrement();
-        }
-        
-        // Encoder click detection (rising edge = button pressed)
-        if(hw.encoder.RisingEdge()) {
-            // Record press time for hold detection
-            uiManager->getState().encoderPressed = true;
-            uiManager->getState().encoderPressTime = System::GetNow();
-            uiManager->getState().encoderHeld = false;
-            uiManager->handleEncoderClick();
-        }
-        
-        // Encoder release detection (falling edge = button released)
-        if(hw.encoder.FallingEdge()) {
-            // Reset hold state
-            uiManager->getState().encoderPressed = false;
-            uiManager->getState().encoderHeld = false;
-        }
-        
-        // Non-blocking hold detection (check if pressed for more than 500ms)
-        if(uiManager->getState().encoderPressed && !uiManager->getState().encoderHeld) {
-            uint32_t pressDuration = System::GetNow() - uiManager->getState().encoderPressTime;
-            if(pressDuration >= Constants::UI::HOLD_DETECT_MS) {
-                // Hold detected - call handleEncoderHold() once
-                uiManager->getState().encoderHeld = true;
-                uiManager->handleEncoderHold();
-            }
-        }
-        
-        // === Button Handling ===
-        if(hw.button1.RisingEdge()) {
-            uiManager->handleButton1Press();
-            // Open the gate in granular mode when Button1 is pressed
-            if (uiManager->getCurrentMode() == MODE_GRANULAR) {
-                library->setGateOpen(true);
-            }
-        }
-        if(hw.button1.FallingEdge()) {
-            // Close the gate in granular mode when Button1 is released
-            if (uiManager->getCurrentMode() == MODE_GRANULAR) {
-                library->setGateOpen(false);
-            }
-        }
-        if(hw.button2.RisingEdge()) {
-            uiManager->handleButton2Press();
-        }
-        
-        // === Update UI ===
+        // === Update UI (redraws are capped at Constants::Display::FPS) ===
         uiManager->update();
         
         // === DEBUG: Display debug state ===
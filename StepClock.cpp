@@ -0,0 +1,65 @@
+#include "StepClock.h"
+
+StepClock::StepClock(int sampleRate)
+    : phase_(0)
+    , stepLength_((uint64_t)sampleRate * 60 * Constants::Sequencer::BPM_RESOLUTION)
+    , increment_(incrementFor(120.0f))
+    , pendingIncrement_(increment_)
+    , restartPending_(false)
+{
+}
+
+uint32_t StepClock::incrementFor(float bpm)
+{
+    // Tempo in 1/100 BPM, times steps per beat = 1/100ths of a step per minute
+    uint32_t bpmFixed = static_cast<uint32_t>(bpm * Constants::Sequencer::BPM_RESOLUTION + 0.5f);
+    return bpmFixed * Constants::Sequencer::STEPS_PER_BEAT;
+}
+
+uint32_t StepClock::samplesPerStepFor(float bpm) const
+{
+    // Formula: samplesPerStep = (sampleRate * 60) / (bpm * 4), rounded
+    uint32_t increment = incrementFor(bpm);
+    return static_cast<uint32_t>((stepLength_ + increment / 2) / increment);
+}
+
+void StepClock::applyPendingTempo()
+{
+    uint32_t increment = pendingIncrement_;
+    if (increment == increment_) {
+        return;
+    }
+
+    // The phase carried past the boundary is a fraction of a sample at the old
+    // tempo; keep the same fraction at the new one
+    phase_ = phase_ * increment / increment_;
+    increment_ = increment;
+}
+
+bool StepClock::serviceRestart()
+{
+    if (!restartPending_) {
+        return false;
+    }
+    restartPending_ = false;
+    increment_ = pendingIncrement_;
+    phase_ = 0;
+    return true;
+}
+
+bool StepClock::stepDue()
+{
+    if (phase_ < stepLength_) {
+        return false;
+    }
+    phase_ -= stepLength_;
+    applyPendingTempo();
+    return true;
+}
+
+size_t StepClock::samplesUntilStep(size_t limit) const
+{
+    // First sample whose phase reaches the end of the step
+    uint64_t until = (stepLength_ - phase_ + increment_ - 1) / increment_;
+    return (until < limit) ? static_cast<size_t>(until) : limit;
+}
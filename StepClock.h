@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "Constants.h"
+
+/**
+ * StepClock - Sample-exact sequencer step timing
+ *
+ * An integer phase accumulator instead of a rounded samples-per-step count.
+ * Each sample adds the tempo in 1/100 BPM times STEPS_PER_BEAT; a step lasts
+ * sampleRate * 60 * BPM_RESOLUTION phase units. The remainder carries into
+ * the next step, so the pattern never drifts and fractional tempos like
+ * 127.5 are exact.
+ *
+ * Only the audio callback moves the clock. The main loop requests a tempo
+ * or a restart through volatile fields that the callback picks up: a tempo
+ * at the next step boundary, a restart before the next block is counted.
+ */
+class StepClock {
+public:
+    explicit StepClock(int sampleRate);
+
+    // Phase units per sample for a tempo
+    static uint32_t incrementFor(float bpm);
+
+    // Nominal samples per step at a tempo (rounded, for display only)
+    uint32_t samplesPerStepFor(float bpm) const;
+
+    // Main loop: tempo to switch to at the next step boundary
+    void setTempo(float bpm) { pendingIncrement_ = incrementFor(bpm); }
+
+    // Main loop: start counting from the beginning of a step again
+    void requestRestart() { restartPending_ = true; }
+
+    // Audio callback: take a requested restart (also takes the pending tempo)
+    bool serviceRestart();
+
+    // Audio callback: true when a step starts on the current sample; the
+    // clock is then in the new step, at the pending tempo
+    bool stepDue();
+
+    // Audio callback: samples before the next step starts, at most limit
+    size_t samplesUntilStep(size_t limit) const;
+
+    // Audio callback: move the clock on by a number of samples
+    void advance(size_t samples) { phase_ += (uint64_t)samples * increment_; }
+
+private:
+    uint64_t phase_;                      // Position within the current step
+    uint64_t stepLength_;                 // Phase units per step
+    uint32_t increment_;                  // Phase units per sample at the current tempo
+    volatile uint32_t pendingIncrement_;  // Tempo requested by setTempo()
+    volatile bool restartPending_;        // Restart requested by requestRestart()
+
+    // Switch to the pending tempo, rescaling the carried-over phase
+    void applyPendingTempo();
+};
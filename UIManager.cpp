@@ -1,6 +1,7 @@
 #include "UIManager.h"
 #include "Menus.h"
 #include <string.h>
+#include <stdio.h>
 
 // BaseMenu Implementation
 BaseMenu::BaseMenu(DisplayManager* display, Sequencer* sequencer,
@@ -21,6 +22,9 @@ UIManager::UIManager(DisplayManager* display, Sequencer* sequencer,
     , sampleLibrary_(sampleLibrary)
     , stackDepth_(0)
     , currentMenu_(nullptr)
+    , lastFrameUs_(0)
+    , frameDeferred_(false)
+    , renderStats_()
 {
     // Initialize all menu pointers to null
     for (int i = 0; i < UIManager::NUM_SCREENS; i++) {
@@ -72,10 +76,63 @@ void UIManager::update()
         updateScrolling();
     }
 
-    // Check if display needs updating
-    if (state_.displayDirty) {
-        render();
-        state_.displayDirty = false;
+    updateLoaderProgress();
+
+    // Toasts come and go on their own timers
+    if (display_->serviceOverlay(System::GetNow())) {
+        state_.displayDirty = true;
+    }
+
+    // Check if display needs updating; changes made before the next frame is
+    // due are drawn together
+    if (!state_.displayDirty) {
+        return;
+    }
+    uint32_t start = System::GetUs();
+    if (start - lastFrameUs_ < Constants::Display::FRAME_INTERVAL_US) {
+        if (!frameDeferred_) {
+            frameDeferred_ = true;
+            renderStats_.deferred++;
+        }
+        return;
+    }
+    lastFrameUs_ = start;
+    frameDeferred_ = false;
+    state_.displayDirty = false;
+    render();
+
+    // Time the frame (menus start sending it to the OLED at the end of render())
+    uint32_t elapsed = System::GetUs() - start;
+    renderStats_.frames++;
+    renderStats_.lastUs = elapsed;
+    if (elapsed > renderStats_.maxUs) {
+        renderStats_.maxUs = elapsed;
+    }
+    if (renderStats_.frames == 1) {
+        renderStats_.avgUs = elapsed;
+    } else {
+        renderStats_.avgUs += ((int32_t)elapsed - (int32_t)renderStats_.avgUs) / 8;
+    }
+}
+
+void UIManager::updateLoaderProgress()
+{
+    SampleLoaderProgress progress = sampleLibrary_->getLoaderProgress();
+    char label[Constants::Display::MAX_CHARS_PER_LINE + 1];
+
+    if (progress.loadingSample >= 0) {
+        SampleInfo* sample = sampleLibrary_->getSample(progress.loadingSample);
+        snprintf(label, sizeof(label), "Load %s", (sample != nullptr) ? sample->name : "");
+        display_->showProgress(label, progress.loadPercent);
+    } else if (progress.scanning) {
+        int percent = -1;
+        if (progress.scanTotal > 0) {
+            percent = progress.samplesFound * 100 / progress.scanTotal;
+        }
+        snprintf(label, sizeof(label), "Scan %d", progress.samplesFound);
+        display_->showProgress(label, percent);
+    } else {
+        display_->hideProgress();
     }
 }
 
@@ -133,6 +133,17 @@ public:
     virtual void onButton2Press() {}
 };
 
+/**
+ * RenderStats - Time spent drawing UI frames, for the debug screen
+ */
+struct RenderStats {
+    uint32_t frames;             // Frames drawn since boot
+    uint32_t deferred;           // Frames held back by the FPS cap (their changes were merged)
+    uint32_t lastUs;             // Render + SPI transfer time of the last frame
+    uint32_t avgUs;              // Running average (1/8 weight per frame)
+    uint32_t maxUs;
+};
+
 /**
  * UIManager - Main UI manager for navigation and display rendering
  * 
@@ -141,6 +152,10 @@ public:
  * 
  * Maintains a navigation stack for proper exit behavior
  * and delegates input handling to the current active menu.
+ * 
+ * Input handlers only mark the display dirty; update() redraws it at most
+ * Constants::Display::FPS times a second, so a fast encoder spin costs one
+ * frame per interval instead of one per detent.
  */
 class UIManager {
 private:
@@ -165,6 +180,14 @@ private:
     // Update horizontal text scrolling state
     void updateScrolling();
 
+    // Mirror the sample loader's progress in the display's progress bar
+    void updateLoaderProgress();
+
+    // Frame scheduling: a dirty display is redrawn at most once per FRAME_INTERVAL_US
+    uint32_t lastFrameUs_;
+    bool frameDeferred_;         // The current dirty frame has already waited for the cap
+    RenderStats renderStats_;
+
 public:
     // Constructor
     UIManager(DisplayManager* display, Sequencer* sequencer,
@@ -197,6 +220,9 @@ public:
     // Render current screen
     void render();
 
+    // Frame timing (for the debug screen)
+    const RenderStats& getRenderStats() const { return renderStats_; }
+
     // Get UI state (non-const version for modification)
     UIState& getState() { return state_; }
 
@@ -0,0 +1,124 @@
+#include "VoicePool.h"
+
+VoicePool::VoicePool()
+    : freeHead_(-1)
+    , activeHead_(-1)
+    , activeCount_(0)
+    , voiceLimit_(Constants::Voices::DEFAULT_VOICE_LIMIT)
+    , startCounter_(0)
+    , stealCount_(0)
+{
+    init();
+}
+
+void VoicePool::init()
+{
+    // Chain every voice onto the free list
+    for (int i = 0; i < POOL_SIZE; i++) {
+        voices_[i].ticker.finished_ = true;
+        voices_[i].sampleIndex = -1;
+        voices_[i].priority = VOICE_PRIORITY_SAMPLE;
+        voices_[i].owner = -1;
+        voices_[i].streamVoice = -1;
+        voices_[i].volume = 0.0f;
+        voices_[i].startOrder = 0;
+        voices_[i].active = false;
+        voices_[i].prev = -1;
+        voices_[i].next = (i + 1 < POOL_SIZE) ? i + 1 : -1;
+    }
+    freeHead_ = 0;
+    activeHead_ = -1;
+    activeCount_ = 0;
+    for (int p = 0; p < NUM_VOICE_PRIORITIES; p++) {
+        priorityCount_[p] = 0;
+    }
+}
+
+void VoicePool::setVoiceLimit(int limit)
+{
+    if (limit < 1) {
+        limit = 1;
+    } else if (limit > POOL_SIZE) {
+        limit = POOL_SIZE;
+    }
+    voiceLimit_ = limit;
+}
+
+int VoicePool::findVictim(int priority) const
+{
+    int victim = -1;
+    for (int i = activeHead_; i >= 0; i = voices_[i].next) {
+        const Voice& voice = voices_[i];
+        if (voice.priority > priority) {
+            continue;
+        }
+        // Lowest priority first, then oldest (wrap-safe)
+        if (victim < 0 || voice.priority < voices_[victim].priority ||
+            (voice.priority == voices_[victim].priority &&
+             (int32_t)(voice.startOrder - voices_[victim].startOrder) < 0)) {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+void VoicePool::unlinkActive(int index)
+{
+    Voice& voice = voices_[index];
+    if (voice.prev >= 0) {
+        voices_[voice.prev].next = voice.next;
+    } else {
+        activeHead_ = voice.next;
+    }
+    if (voice.next >= 0) {
+        voices_[voice.next].prev = voice.prev;
+    }
+    voice.prev = -1;
+    voice.next = -1;
+}
+
+int VoicePool::allocate(int priority)
+{
+    if (freeHead_ < 0 || activeCount_ >= voiceLimit_) {
+        return -1;
+    }
+
+    // Pop the free list
+    int index = freeHead_;
+    freeHead_ = voices_[index].next;
+
+    // Push onto the active list
+    Voice& voice = voices_[index];
+    voice.prev = -1;
+    voice.next = activeHead_;
+    if (activeHead_ >= 0) {
+        voices_[activeHead_].prev = index;
+    }
+    activeHead_ = index;
+
+    voice.priority = priority;
+    voice.owner = -1;
+    voice.streamVoice = -1;
+    voice.startOrder = ++startCounter_;
+    voice.active = true;
+    activeCount_++;
+    priorityCount_[priority]++;
+    return index;
+}
+
+void VoicePool::release(int index)
+{
+    Voice& voice = voices_[index];
+    if (!voice.active) {
+        return;
+    }
+
+    unlinkActive(index);
+    voice.active = false;
+    voice.ticker.finished_ = true;
+    activeCount_--;
+    priorityCount_[voice.priority]--;
+
+    voice.next = freeHead_;
+    freeHead_ = index;
+}
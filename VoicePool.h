@@ -0,0 +1,117 @@
+#pragma once
+
+#include "b3ReadWavFile.h"
+#include "Constants.h"
+
+/**
+ * VoicePriority - Who wins when the pool has to steal a voice
+ *
+ * A new voice can only steal from an equal or lower priority,
+ * so sequencer hits always beat triggered samples. Grains rank below
+ * both: they only get the budget the voices leave (getGrainBudget).
+ */
+enum VoicePriority {
+    VOICE_PRIORITY_SAMPLE = 0,   // SampleLibrary::triggerSample()
+    VOICE_PRIORITY_TRACK = 1,    // Sequencer track hits
+    NUM_VOICE_PRIORITIES
+};
+
+/**
+ * VoiceStealMode - Which of an owner's voices is given up when it hits its polyphony limit
+ */
+enum VoiceStealMode {
+    STEAL_OLDEST,                // Voice that started first
+    STEAL_QUIETEST               // Voice whose sample is currently quietest (ties go to the oldest)
+};
+
+/**
+ * Voice - One playing instance of a sample (sequencer hit or triggered sample)
+ */
+struct Voice {
+    b3WavTicker ticker;          // Playback position
+    int sampleIndex;             // Sample being played
+    int priority;                // VoicePriority
+    int owner;                   // Track index or sample index; used for per-owner limits
+    int streamVoice;             // SampleStreamer voice for streamed samples (-1 = resident)
+    float volume;                // Gain applied when rendering
+    uint32_t startOrder;         // For stealing the oldest voice
+    volatile bool active;        // On the active list (readable from the main loop)
+
+    int prev;                    // Links in the active or free list (-1 = end)
+    int next;
+};
+
+/**
+ * VoicePool - Fixed set of voices shared by the sequencer and triggered samples
+ *
+ * Idle voices sit on a free list and playing voices on an active list, so
+ * rendering only touches live voices and allocation is O(1). When the pool is
+ * empty, or the voice limit (the CPU budget) is reached, the owner steals
+ * findVictim(): the lowest-priority, oldest voice, but never one with a higher
+ * priority than the request.
+ *
+ * Audio callback only. The main loop may read Voice::active and sampleIndex
+ * by scanning getVoice(0 .. POOL_SIZE-1), but must not follow the links.
+ */
+class VoicePool {
+public:
+    static constexpr int POOL_SIZE = Constants::Voices::POOL_SIZE;
+
+    VoicePool();
+
+    // Put every voice on the free list
+    void init();
+
+    /**
+     * Take a voice from the free list
+     *
+     * @param priority VoicePriority of the new voice
+     * @return Voice index (already on the active list), or -1 if the pool is
+     *         empty or at its voice limit (release findVictim() and retry)
+     */
+    int allocate(int priority);
+
+    // Lowest-priority, oldest active voice at or below priority (-1 = none)
+    int findVictim(int priority) const;
+
+    // Return a voice to the free list
+    void release(int index);
+
+    Voice& getVoice(int index) { return voices_[index]; }
+    const Voice& getVoice(int index) const { return voices_[index]; }
+
+    // Walk the active list: for (i = firstActive(); i >= 0; i = nextActive(i))
+    // Fetch nextActive() before releasing the current voice
+    int firstActive() const { return activeHead_; }
+    int nextActive(int index) const { return voices_[index].next; }
+
+    int getActiveCount() const { return activeCount_; }
+    int getActiveCount(int priority) const { return priorityCount_[priority]; }
+
+    // Cap on voices playing at once (CPU budget), clamped to 1 - POOL_SIZE
+    void setVoiceLimit(int limit);
+    int getVoiceLimit() const { return voiceLimit_; }
+
+    // Grains that fit in the budget the active voices leave; every allocate()
+    // takes GRAINS_PER_VOICE of it back
+    int getGrainBudget() const
+    {
+        return (voiceLimit_ - activeCount_) * Constants::Voices::GRAINS_PER_VOICE;
+    }
+
+    // Voices stolen since boot (for debugging; counted by the caller)
+    uint32_t getStealCount() const { return stealCount_; }
+    void countSteal() { stealCount_++; }
+
+private:
+    Voice voices_[POOL_SIZE];
+    int freeHead_;
+    int activeHead_;
+    int activeCount_;
+    int priorityCount_[NUM_VOICE_PRIORITIES];
+    int voiceLimit_;
+    uint32_t startCounter_;
+    uint32_t stealCount_;
+
+    void unlinkActive(int index);
+};
@@ -15,9 +15,20 @@ const unsigned long B3_SINT32 = 0x8;
 const unsigned long B3_FLOAT32 = 0x10;
 const unsigned long B3_FLOAT64 = 0x20;
 
+static void b3InitSincTable();
+
 b3ReadWavFile::b3ReadWavFile()
+	: m_numFrames(0),
+	  channels_(0),
+	  decodedFrames_(0),
+	  decodedFormat_(B3_DECODED_FLOAT32),
+	  decodedNumFrames_(0),
+	  decodedRate_(0.),
+	  mipLevels_(1)
 {
 	m_machineIsLittleEndian = 1;// b3MachineIsLittleEndian();
+	mipFrames_[0] = 0;
+	b3InitSincTable();
 }
 b3ReadWavFile::~b3ReadWavFile()
 {
@@ -45,184 +56,464 @@ void b3ReadWavFile::normalize(double peak)
 #endif
 }
 
-void b3ReadWavFile::interpolate(b3WavTicker* ticker, b3DataSource& dataSource, double speed, double volume, int size, float* out0, float* out1, int oIndex) const
+// Scale that maps a decoded sample to [-1, 1)
+template <typename SampleT>
+static inline float b3SampleScale()
 {
-	int iIndex = (int)ticker->time_;                        // integer part of index
-	double output, alpha = ticker->time_ - (double)iIndex;  // fractional part of index
+	return 1.0f;
+}
 
-	iIndex = iIndex * channels_;
-	
-    if (dataType_ == B3_FLOAT32)
+template <>
+inline float b3SampleScale<short>()
+{
+	return 1.0f / 32768.0f;
+}
+
+// Polyphase windowed-sinc table: B3_SINC_PHASES + 1 rows (the last is a whole
+// frame on) of B3_SINC_TAPS coefficients, for taps at frames i-3 .. i+4
+#define B3_SINC_PHASES 128
+static float b3SincTable[B3_SINC_PHASES + 1][B3_SINC_TAPS];
+static bool b3SincTableReady = false;
+
+static void b3InitSincTable()
+{
+	if (b3SincTableReady)
+		return;
+
+	// Blackman-windowed sinc, cut off a little below Nyquist; each phase normalized to unity gain
+	const double pi = 3.14159265358979323846;
+	const double cutoff = 0.9;
+	const double halfWidth = B3_SINC_TAPS / 2;
+	for (int phase = 0; phase <= B3_SINC_PHASES; phase++)
 	{
-	  float buf[4];
-		if (dataSource.fseek( dataOffset_ + (iIndex * 4), B3_SEEK_SET) == -1)
-			return;
-		if (dataSource.fread(buf, 2*channels_ * 4, 1) != 1)
-			return;
-		double tmp0 = buf[0];
-		double tmp1 = buf[1];
-		if (alpha > 0.0)
+		double alpha = (double)phase / B3_SINC_PHASES;
+		double sum = 0.0;
+		double taps[B3_SINC_TAPS];
+		for (int k = 0; k < B3_SINC_TAPS; k++)
 		{
-	  	tmp0 += (alpha * (buf[channels_] - tmp0));
-	  	tmp1 += (alpha * (buf[channels_+1] - tmp1));
-	  }
-	  out0[oIndex]+=tmp0*volume;
-	  out1[oIndex]+= (channels_ >1) ? tmp1*volume : tmp0 * volume;
-	}
-	
-	if (dataType_ == B3_SINT8)
-	{  // signed 8-bit data
-		unsigned char buf[4];
-		if (dataSource.fseek( dataOffset_ + iIndex, B3_SEEK_SET) == -1)
-			return;
-		if (dataSource.fread(buf, 2*channels_, 1) != 1)
-			return;
-		double gain = 1.0 / 128.0;
-		
-		double tmp0  = (buf[0] - 128)*gain;
-		double tmp1  = (buf[1] - 128)*gain;
-		if (alpha > 0.0)
-		{
-	  	tmp0 += (alpha * ((buf[channels_]-128)*gain - tmp0));
-	  	tmp1 += (alpha * ((buf[channels_+1]-128)*gain - tmp1));
-	  }
-	  out0[oIndex]+=tmp0*volume;
-	  out1[oIndex]+= (channels_ >1) ? tmp1*volume : tmp0 * volume;
+			double x = (double)(k - (B3_SINC_TAPS / 2 - 1)) - alpha;
+			double sinc = (x == 0.0) ? 1.0 : sin(pi * cutoff * x) / (pi * cutoff * x);
+			double w = 0.5 + 0.5 * x / halfWidth;
+			double window = (w <= 0.0 || w >= 1.0) ? 0.0 : 0.42 - 0.5 * cos(2.0 * pi * w) + 0.08 * cos(4.0 * pi * w);
+			taps[k] = sinc * window;
+			sum += taps[k];
+		}
+		for (int k = 0; k < B3_SINC_TAPS; k++)
+			b3SincTable[phase][k] = (float)(taps[k] / sum);
 	}
+	b3SincTableReady = true;
+}
 
-  if (dataType_ == B3_SINT24)
+// Frames an interpolator reads before frame i
+template <int Interp>
+static inline int b3InterpLeftTaps()
+{
+	return (Interp == B3_INTERP_SINC) ? B3_SINC_TAPS / 2 - 1 : (Interp == B3_INTERP_HERMITE) ? 1 : 0;
+}
+
+// Interpolate one channel at frame i + alpha; buf points at frame i of that channel
+template <int Interp, typename SampleT>
+static inline float b3Interpolate(const SampleT* buf, unsigned int stride, float alpha)
+{
+	if (Interp == B3_INTERP_DROP)
 	{
-		// 24-bit values are harder to import efficiently since there is
-		// no native 24-bit type.  The following routine works but is much
-		// less efficient than that used for the other data types.
-		double buf[4];
-		int temp;
-		unsigned char *ptr = (unsigned char *)&temp;
-		double gain = 1.0 / 2147483648.0;
-		if (dataSource.fseek( dataOffset_ + (iIndex * 3), B3_SEEK_SET) == -1)
-			return;
-		for (int i = 0; i < 2*channels_; i++)
+		return (float)buf[0];
+	}
+	else if (Interp == B3_INTERP_LINEAR)
+	{
+		float y0 = (float)buf[0];
+		return y0 + alpha * ((float)buf[stride] - y0);
+	}
+	else if (Interp == B3_INTERP_HERMITE)
+	{
+		// 4-point, 3rd-order Hermite (Catmull-Rom)
+		float ym1 = (float)buf[-(int)stride];
+		float y0 = (float)buf[0];
+		float y1 = (float)buf[stride];
+		float y2 = (float)buf[2 * stride];
+		float c1 = 0.5f * (y1 - ym1);
+		float c2 = ym1 - 2.5f * y0 + 2.0f * y1 - 0.5f * y2;
+		float c3 = 0.5f * (y2 - ym1) + 1.5f * (y0 - y1);
+		return ((c3 * alpha + c2) * alpha + c1) * alpha + y0;
+	}
+	else
+	{
+		// Blend the two nearest phases so the fractional position is not quantized
+		float position = alpha * B3_SINC_PHASES;
+		int phase = (int)position;
+		float blend = position - (float)phase;
+		if (phase >= B3_SINC_PHASES)
 		{
-			if (m_machineIsLittleEndian)
-			{
-				if (byteswap_)
-				{
-					if (dataSource.fread(ptr, 3, 1) != 1)
-						return;
-					temp &= 0x00ffffff;
-					b3Swap32((unsigned char *)ptr);
-				}
-				else
-				{
-					if (dataSource.fread(ptr + 1, 3, 1) != 1)
-						return;
-					temp &= 0xffffff00;
-				}
-			}
-			buf[i] = (double)temp * gain;  // "gain" also  includes 1 / 256 factor.
+			// alpha rounded up to 1.0f: the last row is the next whole frame
+			phase = B3_SINC_PHASES - 1;
+			blend = 1.0f;
 		}
-		
-		double tmp0 = buf[0];
-		double tmp1 = buf[1];
-		if (alpha > 0.0)
+		const float* h0 = b3SincTable[phase];
+		const float* h1 = b3SincTable[phase + 1];
+		const SampleT* src = buf - (B3_SINC_TAPS / 2 - 1) * (int)stride;
+		float acc0 = 0.0f;
+		float acc1 = 0.0f;
+		for (int k = 0; k < B3_SINC_TAPS; k++)
 		{
-	  	tmp0 += (alpha * (buf[channels_] - tmp0));
-	  	tmp1 += (alpha * (buf[channels_+1] - tmp1));
-	  }
-	  out0[oIndex]+=tmp0*volume;
-	  out1[oIndex]+= (channels_ >1) ? tmp1*volume : tmp0 * volume;
-		
+			float x = (float)src[k * stride];
+			acc0 += h0[k] * x;
+			acc1 += h1[k] * x;
+		}
+		return acc0 + blend * (acc1 - acc0);
 	}
+}
 
-	if (dataType_ == B3_SINT32)
+// Render count frames of one voice into out0/out1, optionally with declick ramps.
+// Specialized at compile time on the decoded sample type, on mono vs stereo, on
+// the interpolator and on the declick, so the inner loop carries no format,
+// channel, quality or window tests. B3_INTERP_DROP reads the nearest frame; at
+// unity step from a whole frame it is exact and the cheapest path.
+template <typename SampleT, bool Stereo, int Interp, bool Declick>
+static void b3RenderFrames(const SampleT* frames, unsigned int stride, double& time, double step,
+						   double starttime, double endtime, float volume,
+						   float* out0, float* out1, int count)
+{
+	const float scale = b3SampleScale<SampleT>();
+	const double invRamp = 1.0 / B3_DECLICK_FRAMES;
+	const double rounding = (Interp == B3_INTERP_DROP) ? 0.5 : 0.0;
+	double t = time;
+
+	for (int xx = 0; xx < count; xx++)
 	{
-		int buf[4];
-		if (dataSource.fseek( dataOffset_ + (iIndex * 4), B3_SEEK_SET) == -1)
-			return;
-		if (dataSource.fread(buf, 2*channels_ * 4, 1) != 1)
-			return;
-		double gain = 1.0 / 2147483648.0;
-		
-		double tmp0 = buf[0]*gain;
-		double tmp1 = buf[1]*gain;
-		
-		if (alpha > 0.0)
+		int iIndex = (int)(t + rounding);
+		float alpha = (float)(t - (double)iIndex);
+
+		float gain = volume * scale;
+		if (Declick)
 		{
-	  	tmp0 += (alpha * (buf[channels_]*gain - tmp0));
-	  	tmp1 += (alpha * (buf[channels_+1]*gain - tmp1));
-	  }
-	  out0[oIndex]+=tmp0*volume;
-	  out1[oIndex]+= (channels_ >1) ? tmp1*volume : tmp0 * volume;
-	}
+			// Linear ramps over the first and last B3_DECLICK_FRAMES, unity in between
+			float rampIn = (float)((t - starttime) * invRamp);
+			float rampOut = (float)((endtime - t) * invRamp);
+			float envelope = (rampIn < rampOut) ? rampIn : rampOut;
+			gain *= (envelope < 1.0f) ? envelope : 1.0f;
+		}
 
-	if (dataType_ == B3_SINT16)
-	{
-		signed short int buf[4];
-		if (dataSource.fseek( dataOffset_ + (iIndex * 2), B3_SEEK_SET) == -1)
-			return;
-		if (dataSource.fread(buf, 2*channels_ * 2, 1) != 1)
-			return;
-		double gain = 1.0 / 32768.0;
-		
-		double tmp0 = buf[0]*gain;
-		double tmp1 = buf[1]*gain;
-		if (alpha > 0.0)
+		const SampleT* buf = frames + iIndex * stride;
+		float tmp0;
+		float tmp1;
+		if (b3InterpLeftTaps<Interp>() > 0 && iIndex < b3InterpLeftTaps<Interp>())
+		{
+			// Too close to the first frame for the wide kernels
+			tmp0 = b3Interpolate<B3_INTERP_LINEAR>(buf, stride, alpha);
+			tmp1 = Stereo ? b3Interpolate<B3_INTERP_LINEAR>(buf + 1, stride, alpha) : tmp0;
+		}
+		else
 		{
-	  	tmp0 += (alpha * (buf[channels_]*gain - tmp0));
-	  	tmp1 += (alpha * (buf[channels_+1]*gain - tmp1));
-	  }
-	  out0[oIndex]+=tmp0*volume;
-	  out1[oIndex]+= (channels_ >1) ? tmp1*volume : tmp0 * volume;
+			tmp0 = b3Interpolate<Interp>(buf, stride, alpha);
+			tmp1 = Stereo ? b3Interpolate<Interp>(buf + 1, stride, alpha) : tmp0;
+		}
+		out0[xx] += tmp0 * gain;
+		out1[xx] += tmp1 * gain;
+
+		t += step;
 	}
-	
-	
-	if (dataType_ == B3_FLOAT64)
+	time = t;
+}
+
+template <typename SampleT, int Interp, bool Declick>
+static void b3RenderFramesFor(const SampleT* frames, unsigned int channels, double& time, double step,
+							  double starttime, double endtime, float volume,
+							  float* out0, float* out1, int count)
+{
+	if (channels > 1)
+		b3RenderFrames<SampleT, true, Interp, Declick>(frames, channels, time, step, starttime, endtime, volume, out0, out1, count);
+	else
+		b3RenderFrames<SampleT, false, Interp, Declick>(frames, channels, time, step, starttime, endtime, volume, out0, out1, count);
+}
+
+template <typename SampleT, bool Declick>
+static void b3RenderFramesInterp(const SampleT* frames, unsigned int channels, double& time, double step,
+								 double starttime, double endtime, int interp, float volume,
+								 float* out0, float* out1, int count)
+{
+	// Unity step from a whole frame: every tier reads exact frames, so take the integer path
+	if (step == 1.0 && time == floor(time))
+		interp = B3_INTERP_DROP;
+
+	switch (interp)
 	{
-		double buf[4];
-		if (dataSource.fseek( dataOffset_ + (iIndex * 8), B3_SEEK_SET) == -1)
-			return;
-		if (dataSource.fread(buf, 2*channels_ * 8, 1) != 1)
-			return;
-	
-	  double tmp0 = buf[0];
-		double tmp1 = buf[1];
-		if (alpha > 0.0)
-		{
-	  	tmp0 += (alpha * (buf[channels_] - tmp0));
-	  	tmp1 += (alpha * (buf[channels_+1] - tmp1));
-	  }
-	  out0[oIndex]+=tmp0*volume;
-	  out1[oIndex]+= (channels_ >1) ? tmp1*volume : tmp0 * volume;
-  }
+		case B3_INTERP_DROP:
+			b3RenderFramesFor<SampleT, B3_INTERP_DROP, Declick>(frames, channels, time, step, starttime, endtime, volume, out0, out1, count);
+			break;
+		case B3_INTERP_HERMITE:
+			b3RenderFramesFor<SampleT, B3_INTERP_HERMITE, Declick>(frames, channels, time, step, starttime, endtime, volume, out0, out1, count);
+			break;
+		case B3_INTERP_SINC:
+			b3RenderFramesFor<SampleT, B3_INTERP_SINC, Declick>(frames, channels, time, step, starttime, endtime, volume, out0, out1, count);
+			break;
+		case B3_INTERP_LINEAR:
+		default:
+			b3RenderFramesFor<SampleT, B3_INTERP_LINEAR, Declick>(frames, channels, time, step, starttime, endtime, volume, out0, out1, count);
+			break;
+	}
+}
+
+template <typename SampleT>
+static void b3RenderFramesWindowed(const SampleT* frames, unsigned int channels, double& time, double step,
+								   double starttime, double endtime, int window, int interp, float volume,
+								   float* out0, float* out1, int count)
+{
+	if (window == B3_WINDOW_DECLICK)
+		b3RenderFramesInterp<SampleT, true>(frames, channels, time, step, starttime, endtime, interp, volume, out0, out1, count);
+	else
+		b3RenderFramesInterp<SampleT, false>(frames, channels, time, step, starttime, endtime, interp, volume, out0, out1, count);
+}
+
+void b3ReadWavFile::render(double& time, double step, double starttime, double endtime, int window, int interp, float volume, float* out0, float* out1, int count) const
+{
+	render(decodedFrames_, time, step, starttime, endtime, window, interp, volume, out0, out1, count);
+}
 
+void b3ReadWavFile::render(const void* frames, double& time, double step, double starttime, double endtime, int window, int interp, float volume, float* out0, float* out1, int count) const
+{
+	// Dispatch once per block; the kernels below have no per-sample branches on format
+	if (decodedFormat_ == B3_DECODED_INT16)
+		b3RenderFramesWindowed((const short*)frames, channels_, time, step, starttime, endtime, window, interp, volume, out0, out1, count);
+	else
+		b3RenderFramesWindowed((const float*)frames, channels_, time, step, starttime, endtime, window, interp, volume, out0, out1, count);
 }
 
+int b3ReadWavFile::framesUntilEnd(const b3WavTicker* ticker, double step, int size)
+{
+	if (step <= 0.0)
+		return size;
+	double avail = floor((ticker->endtime_ - ticker->time_) / step) + 1.0;
+	if (avail < 0.0)
+		return 0;
+	return (avail < (double)size) ? (int)avail : size;
+}
 
-void b3ReadWavFile::tick(b3WavTicker *ticker, b3DataSource& dataSource, double speed, double volume, int size, float* out0, float* out1)
+void b3ReadWavFile::tick(b3WavTicker *ticker, double speed, double volume, int size, float* out0, float* out1, int maxInterp)
 {
 	if (ticker->finished_)
 	  return;
+	if (decodedFrames_ == 0)
+	{
+		ticker->finished_ = true;
+		return;
+	}
 	if (ticker->time_ < ticker->starttime_ || ticker->time_ > ticker->endtime_)
 	{
 		ticker->finished_ = true;
 		return;
 	}
 
-	for (int xx=0;xx<size;xx++)
+	// Work out how many frames can be produced before endtime_ and render them in one pass
+	double step = ticker->rate_ * speed;
+	int count = framesUntilEnd(ticker, step, size);
+	int interp = (ticker->interp_ < maxInterp) ? ticker->interp_ : maxInterp;
+	int level = mipLevelForStep(step, mipLevels_);
+	if (level == 0)
+	{
+		render(ticker->time_, step, ticker->starttime_, ticker->endtime_, ticker->window_, interp, (float)volume, out0, out1, count);
+	}
+	else
 	{
-		// Apply triangular envelope to smooth grain boundaries and eliminate clicking
-		// The envelope ramps up from 0 to 1 in the first half, then down from 1 to 0 in the second half
-		double envelope = ticker->env_volume2();
-		double envelopeVolume = volume * envelope;
-		
-		interpolate(ticker, dataSource, speed, envelopeVolume, size, out0, out1, xx);
-		ticker->time_ += ticker->rate_*speed;
-		if (ticker->time_ < ticker->starttime_ || ticker->time_ > ticker->endtime_)
+		// Same positions in the level's frames; powers of two scale exactly
+		double scale = (double)(1 << level);
+		double time = ticker->time_ / scale;
+		render(mipFrames_[level], time, step / scale, ticker->starttime_ / scale, ticker->endtime_ / scale,
+			   ticker->window_, interp, (float)volume, out0, out1, count);
+		ticker->time_ = time * scale;
+	}
+
+	if (count < size || ticker->time_ < ticker->starttime_ || ticker->time_ > ticker->endtime_)
+	{
+		ticker->finished_ = true;
+	}
+}
+
+size_t b3ReadWavFile::getDecodedFrameSize(int format) const
+{
+	size_t bytesPerSample = (format == B3_DECODED_INT16) ? sizeof(short) : sizeof(float);
+	return channels_ * bytesPerSample;
+}
+
+size_t b3ReadWavFile::getDecodedSize(int format) const
+{
+	return (m_numFrames + B3_DECODED_GUARD_FRAMES) * getDecodedFrameSize(format);
+}
+
+// Convert one raw sample at src to a float in [-1, 1)
+static inline float b3DecodeSample(const unsigned char* src, unsigned long dataType)
+{
+	switch (dataType)
+	{
+		case B3_SINT8:
+			return (src[0] - 128) * (1.0f / 128.0f);
+		case B3_SINT16:
+		{
+			short v;
+			memcpy(&v, src, 2);
+			return v * (1.0f / 32768.0f);
+		}
+		case B3_SINT24:
+		{
+			int v = (src[0] << 8) | (src[1] << 16) | (src[2] << 24);
+			return (float)(v * (1.0 / 2147483648.0));
+		}
+		case B3_SINT32:
 		{
-			ticker->finished_ = true;
-			return;
+			int v;
+			memcpy(&v, src, 4);
+			return (float)(v * (1.0 / 2147483648.0));
+		}
+		case B3_FLOAT32:
+		{
+			float v;
+			memcpy(&v, src, 4);
+			return v;
+		}
+		case B3_FLOAT64:
+		{
+			double v;
+			memcpy(&v, src, 8);
+			return (float)v;
 		}
 	}
+	return 0.0f;
+}
+
+bool b3ReadWavFile::decode(b3DataSource& dataSource, void* dest, int format)
+{
+	if (!decodeFrames(dataSource, 0, m_numFrames, dest, format))
+		return false;
+
+	// Zero the guard frames read by interpolation past the last frame
+	memset((char*)dest + m_numFrames * getDecodedFrameSize(format), 0,
+		   B3_DECODED_GUARD_FRAMES * getDecodedFrameSize(format));
+	return true;
+}
+
+bool b3ReadWavFile::decodeFrames(b3DataSource& dataSource, unsigned long firstFrame, unsigned long numFrames, void* dest, int format)
+{
+	unsigned int bytesPerSample = getBitsPerSample() / 8;
+	unsigned int bytesPerFrame = bytesPerSample * channels_;
+	if (bytesPerFrame == 0 || byteswap_)
+		return false;
+	if (firstFrame + numFrames > m_numFrames)
+		return false;
+
+	// Read whole frames at a time so a frame never straddles two chunks
+	unsigned char chunk[2048];
+	unsigned long framesPerChunk = sizeof(chunk) / bytesPerFrame;
+	if (framesPerChunk == 0)
+		return false;
+
+	if (numFrames == 0)
+		return true;
+	if (dataSource.fseek(dataOffset_ + firstFrame * bytesPerFrame, B3_SEEK_SET) == -1)
+		return false;
+
+	// Stored in the target format already: one read, no chunk buffer
+	if ((format == B3_DECODED_INT16 && dataType_ == B3_SINT16) ||
+		(format == B3_DECODED_FLOAT32 && dataType_ == B3_FLOAT32))
+	{
+		return dataSource.fread(dest, bytesPerFrame, numFrames) == numFrames;
+	}
+
+	float* outFloat = (float*)dest;
+	short* outShort = (short*)dest;
+	unsigned long outIndex = 0;
+	unsigned long framesLeft = numFrames;
+	while (framesLeft > 0)
+	{
+		unsigned long frames = framesLeft < framesPerChunk ? framesLeft : framesPerChunk;
+		if (dataSource.fread(chunk, bytesPerFrame, frames) != frames)
+			return false;
+
+		unsigned long samples = frames * channels_;
+		const unsigned char* src = chunk;
+		if (format == B3_DECODED_INT16)
+		{
+			for (unsigned long i = 0; i < samples; i++, src += bytesPerSample)
+			{
+				float v = b3DecodeSample(src, dataType_) * 32768.0f;
+				if (v > 32767.0f) v = 32767.0f;
+				if (v < -32768.0f) v = -32768.0f;
+				outShort[outIndex++] = (short)v;
+			}
+		}
+		else
+		{
+			for (unsigned long i = 0; i < samples; i++, src += bytesPerSample)
+				outFloat[outIndex++] = b3DecodeSample(src, dataType_);
+		}
+		framesLeft -= frames;
+	}
+	return true;
+}
+
+b3WavInfo b3ReadWavFile::getInfo() const
+{
+	b3WavInfo info;
+	info.numFrames = m_numFrames;
+	info.dataType = dataType_;
+	info.dataOffset = dataOffset_;
+	info.rate = fileDataRate_;
+	info.channels = channels_;
+	info.byteswap = byteswap_;
+	return info;
+}
+
+void b3ReadWavFile::setInfo(const b3WavInfo& info)
+{
+	m_numFrames = info.numFrames;
+	dataType_ = info.dataType;
+	dataOffset_ = info.dataOffset;
+	fileDataRate_ = info.rate;
+	channels_ = info.channels;
+	byteswap_ = info.byteswap;
+	wavFile_ = true;
+	decodedNumFrames_ = m_numFrames;
+	decodedRate_ = fileDataRate_;
+}
+
+void b3ReadWavFile::setStoredFrames(unsigned long numFrames, unsigned int channels, double rate, int format, unsigned long dataOffset)
+{
+	m_numFrames = numFrames;
+	channels_ = channels;
+	fileDataRate_ = rate;
+	dataType_ = (format == B3_DECODED_INT16) ? B3_SINT16 : B3_FLOAT32;
+	dataOffset_ = dataOffset;
+	byteswap_ = false;
+	wavFile_ = true;
+	decodedNumFrames_ = numFrames;
+	decodedRate_ = rate;
+}
+
+void b3ReadWavFile::setDecodedFrames(const void* frames, int format)
+{
+	setDecodedFrames(frames, format, m_numFrames, fileDataRate_);
+}
+
+void b3ReadWavFile::setDecodedFrames(const void* frames, int format, unsigned long numFrames, double rate)
+{
+	decodedFrames_ = frames;
+	decodedFormat_ = format;
+	decodedNumFrames_ = numFrames;
+	decodedRate_ = rate;
+	mipFrames_[0] = frames;
+	mipLevels_ = 1;
+}
+
+void b3ReadWavFile::setMipLevels(const void* const* levels, int count)
+{
+	if (count > B3_MAX_MIP_LEVELS)
+		count = B3_MAX_MIP_LEVELS;
+	if (count < 1)
+		count = 1;
+	for (int i = 1; i < count; i++)
+	{
+		mipFrames_[i] = levels[i];
+	}
+	mipFrames_[0] = decodedFrames_;
+	mipLevels_ = count;
 }
 
 void b3ReadWavFile::resize()
@@ -236,13 +527,27 @@ b3WavTicker b3ReadWavFile::createWavTicker(double sampleRate)
 	ticker.lastFrame_.resize(this->channels_);
 	ticker.time_ = 0;
 	ticker.starttime_ = 0.;
-	ticker.endtime_ = (double)(this->m_numFrames - 1.0);
+	ticker.endtime_ = (double)(this->decodedNumFrames_ - 1.0);
 	ticker.finished_ = false;
-	ticker.rate_ = fileDataRate_ / sampleRate;
+	ticker.rate_ = decodedRate_ / sampleRate;
 	ticker.speed_ = 1.;
+	ticker.window_ = B3_WINDOW_NONE;
+	ticker.interp_ = B3_INTERP_LINEAR;
 	return ticker;
 }
 
+void b3ReadWavFile::resetWavTicker(b3WavTicker& ticker, double sampleRate) const
+{
+	ticker.time_ = 0;
+	ticker.starttime_ = 0.;
+	ticker.endtime_ = (double)(this->decodedNumFrames_ - 1.0);
+	ticker.rate_ = decodedRate_ / sampleRate;
+	ticker.speed_ = 1.;
+	ticker.window_ = B3_WINDOW_NONE;
+	ticker.interp_ = B3_INTERP_LINEAR;
+	ticker.finished_ = false;
+}
+
 bool b3ReadWavFile::getWavInfo(b3DataSource& dataSource)
 {
 	
@@ -412,6 +717,10 @@ bool b3ReadWavFile::getWavInfo(b3DataSource& dataSource)
 		byteswap_ = true;
 	}
 	wavFile_ = true;
+
+	// Until a converted buffer says otherwise, playback uses the file's own frames and rate
+	decodedNumFrames_ = m_numFrames;
+	decodedRate_ = fileDataRate_;
 	return true;
 }
 
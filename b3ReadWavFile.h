@@ -10,6 +10,33 @@
 #define B3_SEEK_END    12
 #define B3_SEEK_SET    10
 
+// Storage formats for sample data decoded once at load time (see b3ReadWavFile::decode)
+#define B3_DECODED_FLOAT32  0
+#define B3_DECODED_INT16    1
+
+// Interpolation quality for rendering a ticker (b3WavTicker::interp_), cheapest first
+#define B3_INTERP_DROP      0   // Nearest frame (exact at unity speed)
+#define B3_INTERP_LINEAR    1   // 2-point linear
+#define B3_INTERP_HERMITE   2   // 4-point cubic Hermite
+#define B3_INTERP_SINC      3   // 8-tap polyphase windowed sinc
+#define B3_NUM_INTERP       4
+
+// Taps of the B3_INTERP_SINC kernel (frames i-3 .. i+4)
+#define B3_SINC_TAPS 8
+
+// Zeroed frames appended after the decoded data so interpolation can always read up to frame i+4
+#define B3_DECODED_GUARD_FRAMES (B3_SINC_TAPS / 2)
+
+// Envelope applied while rendering a ticker (b3WavTicker::window_)
+#define B3_WINDOW_NONE      0   // Play the sample as is
+#define B3_WINDOW_DECLICK   1   // Short linear ramps at the start and end only
+
+// Length of the declick ramps, in sample frames
+#define B3_DECLICK_FRAMES   32
+
+// Decoded frames plus pre-filtered copies at 1/2, 1/4 and 1/8 rate (see setMipLevels)
+#define B3_MAX_MIP_LEVELS   4
+
 struct b3DataSource
 {
 	virtual long  ftell() = 0;
@@ -153,19 +180,19 @@ struct b3WavTicker
 	double rate_;
 	double speed_;
 	int wavindex;
-	double env_volume()
-	{
-		double frac = 1. - (time_ - starttime_) / (endtime_ - starttime_);
-		return frac;
-	}
+	int window_;
+	int interp_;
+};
 
-	double env_volume2()
-	{
-		double frac = (time_ - starttime_) / (endtime_ - starttime_);
-		if (frac > 0.5)
-			return 1. - frac;
-		return frac;
-	}
+// Everything getWavInfo() reads from a header, so it can be cached and restored without the file
+struct b3WavInfo
+{
+	unsigned long numFrames;
+	unsigned long dataType;
+	unsigned long dataOffset;
+	double rate;
+	unsigned int channels;
+	bool byteswap;
 };
 
 class b3ReadWavFile
@@ -180,6 +207,18 @@ class b3ReadWavFile
 	unsigned int channels_;
 	bool m_machineIsLittleEndian;
 
+	// Interleaved frames decoded by decode(), read directly by tick()
+	const void* decodedFrames_;
+	int decodedFormat_;
+
+	// Length and rate of the decoded frames (differ from the file after sample-rate conversion)
+	unsigned long decodedNumFrames_;
+	double decodedRate_;
+
+	// Octave levels tick() can read from; level 0 is decodedFrames_
+	const void* mipFrames_[B3_MAX_MIP_LEVELS];
+	int mipLevels_;
+
 public:
 	b3ReadWavFile();
 	virtual ~b3ReadWavFile();
@@ -188,15 +227,91 @@ public:
 
 	bool getWavInfo(b3DataSource& dataSource);
 
+	// Header fields found by getWavInfo(), and the reverse (as if the header had just been read)
+	b3WavInfo getInfo() const;
+	void setInfo(const b3WavInfo& info);
+
 	void normalize(double peak);
 
-	void interpolate(b3WavTicker *ticker, b3DataSource& dataSource, double speed, double volume, int size, float* out0, float* out1, int oIndex) const;
-	void tick(b3WavTicker *ticker, b3DataSource& dataSource, double speed, double volume, int size, float* out0, float* out1);
+	// Bytes needed to hold every frame (plus guard frames) in the given decoded format
+	size_t getDecodedSize(int format) const;
+
+	// Convert the raw "data" chunk into interleaved frames at dest, reading the
+	// source in chunks. Call after getWavInfo(); dest must hold getDecodedSize(format) bytes.
+	bool decode(b3DataSource& dataSource, void* dest, int format);
+
+	// Decode numFrames frames starting at firstFrame into dest (no guard frames).
+	// Used to fill streaming buffers a chunk at a time. Frames already stored in
+	// the requested format are read straight into dest.
+	bool decodeFrames(b3DataSource& dataSource, unsigned long firstFrame, unsigned long numFrames, void* dest, int format);
+
+	// Size of one decoded frame in bytes
+	size_t getDecodedFrameSize(int format) const;
+
+	// Describe numFrames frames stored at dataOffset in a decoded format (e.g. in a
+	// sample bank) instead of parsing a WAV header; decodeFrames() then reads from there
+	void setStoredFrames(unsigned long numFrames, unsigned int channels, double rate, int format, unsigned long dataOffset);
+
+	// Play from a buffer filled by decode()
+	void setDecodedFrames(const void* frames, int format);
+
+	// Play from a buffer of numFrames frames at rate (e.g. the file converted to the output rate).
+	// Tickers created or reset afterwards use that length and rate.
+	void setDecodedFrames(const void* frames, int format, unsigned long numFrames, double rate);
+
+	const void* getDecodedFrames() const
+	{
+		return decodedFrames_;
+	}
+
+	// Band-limited copies of the decoded frames for fast playback. levels[0] is the
+	// decoded buffer itself, levels[i] holds every 2^i-th frame low-passed below its own
+	// Nyquist (frame j lines up with decoded frame j * 2^i), followed by guard frames.
+	// Cleared by setDecodedFrames().
+	void setMipLevels(const void* const* levels, int count);
+
+	int getMipLevels() const
+	{
+		return mipLevels_;
+	}
+
+	// Level to read at step frames per output frame: the highest one that keeps
+	// the step at or above 1, so nothing above its Nyquist gets folded back
+	static int mipLevelForStep(double step, int levels)
+	{
+		int level = 0;
+		while (level + 1 < levels && step >= (double)(2 << level))
+		{
+			level++;
+		}
+		return level;
+	}
+
+	// Render count frames starting at time (advanced by step per frame) into out0/out1,
+	// applying window (B3_WINDOW_*) between starttime and endtime and interpolating
+	// with interp (B3_INTERP_*). Does no bounds checks; the wide interpolators read
+	// up to B3_DECODED_GUARD_FRAMES past the frame at time.
+	void render(double& time, double step, double starttime, double endtime, int window, int interp, float volume, float* out0, float* out1, int count) const;
+
+	// Same as render(), but reading from frames (in this file's decoded format) instead of
+	// the decode() buffer. time, starttime and endtime are relative to frames[0].
+	void render(const void* frames, double& time, double step, double starttime, double endtime, int window, int interp, float volume, float* out0, float* out1, int count) const;
+
+	// Number of frames (at most size) a ticker can produce before passing its endtime_
+	static int framesUntilEnd(const b3WavTicker* ticker, double step, int size);
+
+	// Render the ticker's next size frames, with its interpolation capped at maxInterp.
+	// Reads from the mip level that suits the step, if any were set.
+	void tick(b3WavTicker *ticker, double speed, double volume, int size, float* out0, float* out1, int maxInterp = B3_INTERP_SINC);
 	
 	void resize();
 
 	b3WavTicker createWavTicker(double sampleRate);
 
+	// Rewind an existing ticker to the start of this file (unwindowed, linear), as createWavTicker() would,
+	// without touching lastFrame_ (so it never allocates; safe in the audio callback)
+	void resetWavTicker(b3WavTicker& ticker, double sampleRate) const;
+
 	int getNumFrames() const
 	{
 		return m_numFrames;
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+/**
+ * HostTest - Minimal checks and timing for the host-side tests
+ *
+ * CHECK() reports the failing expression and keeps going; a test's main()
+ * returns testResult() so make stops on the first failing program.
+ */
+
+static int hostTestFailures = 0;
+
+#define CHECK(expr)                                                              \
+    do {                                                                         \
+        if (!(expr)) {                                                           \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #expr); \
+            hostTestFailures++;                                                  \
+        }                                                                        \
+    } while (0)
+
+static inline int testResult(const char* name)
+{
+    if (hostTestFailures > 0) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, hostTestFailures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+// Seconds since an arbitrary start (for benchmarks)
+static inline double hostSeconds()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Keep the optimizer from dropping a benchmark's result
+static volatile float g_sink;
+
+static inline void keepValue(float value)
+{
+    g_sink = value;
+}
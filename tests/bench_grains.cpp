@@ -0,0 +1,84 @@
+/**
+ * bench_grains - GrainEngine mixing cost from 8 to 128 grains
+ *
+ * Keeps a fixed number of grains live (each one respawned as it ends) and
+ * renders block after block, for both decoded formats and channel counts.
+ * Reports nanoseconds per grain per output frame, which should stay flat as
+ * the grain count grows: the kernel is meant to scale linearly.
+ */
+
+#include "GrainEngine.h"
+#include "b3ReadWavFile.h"
+#include "HostTest.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int FRAMES = 1 << 16;
+const int BLOCK = 48;
+const int BLOCKS = 4000;
+const int GRAIN_FRAMES = 4800;   // 100 ms grains
+
+double benchGrains(int format, int channels, int grains)
+{
+    size_t samples = (size_t)(FRAMES + B3_DECODED_GUARD_FRAMES) * channels;
+    std::vector<float> floats(samples, 0.0f);
+    std::vector<short> shorts(samples, 0);
+    for (size_t i = 0; i < (size_t)FRAMES * channels; i++) {
+        float v = 0.5f * sinf(0.01f * (float)i);
+        floats[i] = v;
+        shorts[i] = (short)(v * 32767.0f);
+    }
+    const void* frames = (format == B3_DECODED_INT16) ? (const void*)shorts.data() : (const void*)floats.data();
+
+    GrainEngine engine;
+    engine.init(format);
+
+    float out0[BLOCK];
+    float out1[BLOCK];
+    uint32_t spawned = 0;
+    double elapsed = 0.0;
+    for (int b = 0; b < BLOCKS; b++) {
+        // Top up to the wanted count, staggered so grains end at different blocks
+        while (engine.getActiveCount() < grains) {
+            double start = (double)((spawned * 7919u) % (FRAMES - 2 * GRAIN_FRAMES));
+            double step = 0.75 + 0.5 * (double)(spawned % 16) / 16.0;
+            engine.spawn(0, frames, channels, 0, start, start + GRAIN_FRAMES * step, step,
+                         WINDOW_HANN, (int)(spawned % BLOCK));
+            spawned++;
+        }
+        for (int i = 0; i < BLOCK; i++) {
+            out0[i] = 0.0f;
+            out1[i] = 0.0f;
+        }
+        double begin = hostSeconds();
+        engine.render(1.0f / grains, out0, out1, BLOCK);
+        elapsed += hostSeconds() - begin;
+        keepValue(out0[0] + out1[BLOCK - 1]);
+    }
+    return elapsed * 1e9 / ((double)BLOCKS * BLOCK * grains);
+}
+
+}  // namespace
+
+int main()
+{
+    GrainWindow::init();
+
+    static const int COUNTS[] = { 8, 16, 32, 64, 128 };
+    printf("%-8s %-7s %8s %14s\n", "format", "layout", "grains", "ns/grain/fr");
+    for (int format = B3_DECODED_FLOAT32; format <= B3_DECODED_INT16; format++) {
+        for (int channels = 1; channels <= 2; channels++) {
+            for (int grains : COUNTS) {
+                printf("%-8s %-7s %8d %14.2f\n",
+                       (format == B3_DECODED_INT16) ? "int16" : "float32",
+                       (channels == 2) ? "stereo" : "mono",
+                       grains, benchGrains(format, channels, grains));
+            }
+        }
+    }
+    return 0;
+}
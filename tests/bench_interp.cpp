@@ -0,0 +1,131 @@
+/**
+ * bench_interp - Quality against cost for each interpolation tier
+ *
+ * Plays a sine recorded at 44.1 kHz back at 48 kHz (step 0.91875) through
+ * every B3_INTERP_* tier and reports THD+N: the power left after removing
+ * the best-fitting sine at the expected frequency, relative to that sine.
+ * The time per output frame is measured on the same run, so each tier's
+ * quality can be weighed against its cycles.
+ */
+
+#include "b3ReadWavFile.h"
+#include "HostTest.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int FRAMES = 1 << 16;
+const int BLOCK = 48;
+const double SOURCE_RATE = 44100.0;
+const double OUTPUT_RATE = 48000.0;
+const int SKIP = 64;   // Output frames left out of the fit (the kernel warming up)
+
+const char* interpName(int interp)
+{
+    static const char* names[B3_NUM_INTERP] = { "drop", "linear", "hermite", "sinc" };
+    return names[interp];
+}
+
+// THD+N in dB of y against a sine of w radians per sample (least squares fit
+// of a * sin + b * cos + c, then residual power over fitted sine power)
+double thdPlusNoise(const std::vector<float>& y, double w)
+{
+    double m[3][3] = {};
+    double v[3] = {};
+    for (size_t n = 0; n < y.size(); n++) {
+        double basis[3] = { sin(w * n), cos(w * n), 1.0 };
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                m[i][j] += basis[i] * basis[j];
+            }
+            v[i] += basis[i] * y[n];
+        }
+    }
+
+    // Solve the 3x3 normal equations (Gaussian elimination)
+    for (int i = 0; i < 3; i++) {
+        for (int k = i + 1; k < 3; k++) {
+            double f = m[k][i] / m[i][i];
+            for (int j = i; j < 3; j++) {
+                m[k][j] -= f * m[i][j];
+            }
+            v[k] -= f * v[i];
+        }
+    }
+    double c[3];
+    for (int i = 2; i >= 0; i--) {
+        double sum = v[i];
+        for (int j = i + 1; j < 3; j++) {
+            sum -= m[i][j] * c[j];
+        }
+        c[i] = sum / m[i][i];
+    }
+
+    double residual = 0.0;
+    for (size_t n = 0; n < y.size(); n++) {
+        double fit = c[0] * sin(w * n) + c[1] * cos(w * n) + c[2];
+        residual += (y[n] - fit) * (y[n] - fit);
+    }
+    double signal = 0.5 * (c[0] * c[0] + c[1] * c[1]) * y.size();
+    return 10.0 * log10(residual / signal);
+}
+
+struct Result {
+    double thdN;
+    double nsPerFrame;
+};
+
+Result measure(int interp, double frequency)
+{
+    b3ReadWavFile wav;
+    wav.setStoredFrames(FRAMES, 1, SOURCE_RATE, B3_DECODED_FLOAT32, 0);
+    std::vector<float> frames(FRAMES + B3_DECODED_GUARD_FRAMES, 0.0f);
+    double w = 2.0 * M_PI * frequency / SOURCE_RATE;
+    for (int i = 0; i < FRAMES; i++) {
+        frames[i] = (float)(0.5 * sin(w * i));
+    }
+    wav.setDecodedFrames(frames.data(), B3_DECODED_FLOAT32);
+
+    double step = SOURCE_RATE / OUTPUT_RATE;
+    double end = FRAMES - B3_DECODED_GUARD_FRAMES - 1;
+    int blocks = (int)((end - B3_SINC_TAPS) / step) / BLOCK - 1;
+    std::vector<float> out0((size_t)blocks * BLOCK, 0.0f);
+    std::vector<float> out1((size_t)blocks * BLOCK, 0.0f);
+
+    double time = B3_SINC_TAPS;
+    double begin = hostSeconds();
+    for (int b = 0; b < blocks; b++) {
+        wav.render(time, step, 0.0, end, B3_WINDOW_NONE, interp, 1.0f,
+                   &out0[b * BLOCK], &out1[b * BLOCK], BLOCK);
+    }
+    Result result;
+    result.nsPerFrame = (hostSeconds() - begin) * 1e9 / ((double)blocks * BLOCK);
+    keepValue(out0[0]);
+
+    std::vector<float> fitted(out0.begin() + SKIP, out0.end());
+    result.thdN = thdPlusNoise(fitted, w * step);
+    return result;
+}
+
+}  // namespace
+
+int main()
+{
+    static const double FREQUENCIES[] = { 1000.0, 5000.0, 15000.0 };
+    printf("44.1 -> 48 kHz, float32 mono; THD+N in dB\n");
+    printf("%-8s %10s %10s %10s %10s\n", "interp", "ns/frame", "1 kHz", "5 kHz", "15 kHz");
+    for (int interp = 0; interp < B3_NUM_INTERP; interp++) {
+        double ns = 0.0;
+        double thdN[3];
+        for (int f = 0; f < 3; f++) {
+            Result result = measure(interp, FREQUENCIES[f]);
+            thdN[f] = result.thdN;
+            ns += result.nsPerFrame / 3.0;
+        }
+        printf("%-8s %10.2f %10.1f %10.1f %10.1f\n", interpName(interp), ns, thdN[0], thdN[1], thdN[2]);
+    }
+    return 0;
+}
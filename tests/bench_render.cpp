@@ -0,0 +1,87 @@
+/**
+ * bench_render - Cost of b3ReadWavFile's render kernels on the host
+ *
+ * Renders one block size at a time from a decoded buffer, for every channel
+ * count and interpolation tier, at unity step (the integer path) and at a
+ * resampling step. Covers the 2 decoded store formats (float32 and int16),
+ * which are all the kernels ever read: the 6 WAV source formats are
+ * converted to one of them at load time (test_decode_formats checks that
+ * against the old per-sample path).
+ *
+ * Reports host nanoseconds per output frame, not Cortex-M7 cycles. The
+ * ratios between kernels are what carries over to the device.
+ */
+
+#include "b3ReadWavFile.h"
+#include "HostTest.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const int FRAMES = 1 << 16;
+const int BLOCK = 48;
+const int BLOCKS = 20000;
+
+const char* interpName(int interp)
+{
+    static const char* names[B3_NUM_INTERP] = { "drop", "linear", "hermite", "sinc" };
+    return names[interp];
+}
+
+double benchKernel(int format, int channels, int interp, double step)
+{
+    b3ReadWavFile wav;
+    wav.setStoredFrames(FRAMES, channels, 48000.0, format, 0);
+
+    size_t samples = (size_t)(FRAMES + B3_DECODED_GUARD_FRAMES) * channels;
+    std::vector<float> floats(samples, 0.0f);
+    std::vector<short> shorts(samples, 0);
+    for (size_t i = 0; i < (size_t)FRAMES * channels; i++) {
+        float v = 0.5f * sinf(0.01f * (float)i);
+        floats[i] = v;
+        shorts[i] = (short)(v * 32767.0f);
+    }
+    const void* frames = (format == B3_DECODED_INT16) ? (const void*)shorts.data() : (const void*)floats.data();
+    wav.setDecodedFrames(frames, format);
+
+    float out0[BLOCK];
+    float out1[BLOCK];
+    double end = FRAMES - B3_DECODED_GUARD_FRAMES - 1;
+    double time = B3_SINC_TAPS;
+    double start = hostSeconds();
+    for (int b = 0; b < BLOCKS; b++) {
+        if (time + step * BLOCK >= end) {
+            time = B3_SINC_TAPS;
+        }
+        for (int i = 0; i < BLOCK; i++) {
+            out0[i] = 0.0f;
+            out1[i] = 0.0f;
+        }
+        wav.render(time, step, 0.0, end, B3_WINDOW_NONE, interp, 0.8f, out0, out1, BLOCK);
+        keepValue(out0[0] + out1[BLOCK - 1]);
+    }
+    double elapsed = hostSeconds() - start;
+    return elapsed * 1e9 / ((double)BLOCKS * BLOCK);
+}
+
+}  // namespace
+
+int main()
+{
+    printf("%-8s %-7s %-8s %12s %12s\n", "format", "layout", "interp", "unity ns/fr", "x1.37 ns/fr");
+    for (int format = B3_DECODED_FLOAT32; format <= B3_DECODED_INT16; format++) {
+        for (int channels = 1; channels <= 2; channels++) {
+            for (int interp = 0; interp < B3_NUM_INTERP; interp++) {
+                double unity = benchKernel(format, channels, interp, 1.0);
+                double resample = benchKernel(format, channels, interp, 1.37);
+                printf("%-8s %-7s %-8s %12.2f %12.2f\n",
+                       (format == B3_DECODED_INT16) ? "int16" : "float32",
+                       (channels == 2) ? "stereo" : "mono",
+                       interpName(interp), unity, resample);
+            }
+        }
+    }
+    return 0;
+}
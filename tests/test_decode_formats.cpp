@@ -0,0 +1,215 @@
+/**
+ * test_decode_formats - Decoded block rendering against the old per-sample path
+ *
+ * Writes a WAV in memory for each of the six source formats (8-bit, PCM16,
+ * PCM24, PCM32, float32 and float64), mono and stereo. Decodes it with
+ * decodeFrames() and renders it with the linear block kernel. The result is
+ * compared with a per-sample reference written like the original
+ * b3ReadWavFile::interpolate(): it reads the raw bytes at every output frame,
+ * scales them per type and interpolates in double.
+ */
+
+#include "b3ReadWavFile.h"
+#include "HostTest.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const int FRAMES = 2000;
+const int BLOCK = 48;
+const float VOLUME = 0.8f;
+
+struct Format {
+    const char* name;
+    unsigned short tag;      // 1 = PCM, 3 = IEEE float
+    unsigned short bits;
+};
+
+const Format FORMATS[] = {
+    { "pcm8", 1, 8 },
+    { "pcm16", 1, 16 },
+    { "pcm24", 1, 24 },
+    { "pcm32", 1, 32 },
+    { "float32", 3, 32 },
+    { "float64", 3, 64 },
+};
+
+void put16(std::vector<char>& out, unsigned value)
+{
+    out.push_back((char)(value & 0xFF));
+    out.push_back((char)((value >> 8) & 0xFF));
+}
+
+void put32(std::vector<char>& out, unsigned value)
+{
+    put16(out, value & 0xFFFF);
+    put16(out, value >> 16);
+}
+
+// Sample i of channel c, in [-1, 1)
+double sourceValue(int i, int c)
+{
+    return 0.9 * sin(0.013 * i + 1.7 * c) * cos(0.0021 * i);
+}
+
+// Raw little-endian bytes of one sample in a format
+void putSample(std::vector<char>& out, const Format& format, double value)
+{
+    if (format.tag == 3 && format.bits == 32) {
+        float v = (float)value;
+        out.insert(out.end(), (char*)&v, (char*)&v + 4);
+    } else if (format.tag == 3) {
+        out.insert(out.end(), (char*)&value, (char*)&value + 8);
+    } else if (format.bits == 8) {
+        out.push_back((char)(unsigned char)(128 + (int)floor(value * 127.0)));
+    } else {
+        int shift = 32 - format.bits;
+        long long full = (long long)floor(value * 2147483647.0);
+        unsigned v = (unsigned)((int)full >> shift);
+        for (int b = 0; b < format.bits / 8; b++) {
+            out.push_back((char)((v >> (8 * b)) & 0xFF));
+        }
+    }
+}
+
+std::vector<char> makeWav(const Format& format, int channels)
+{
+    int bytesPerSample = format.bits / 8;
+    std::vector<char> wav;
+    unsigned dataBytes = (unsigned)(FRAMES * channels * bytesPerSample);
+    wav.insert(wav.end(), { 'R', 'I', 'F', 'F' });
+    put32(wav, 36 + dataBytes);
+    wav.insert(wav.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+    put32(wav, 16);
+    put16(wav, format.tag);
+    put16(wav, (unsigned)channels);
+    put32(wav, 48000);
+    put32(wav, 48000u * channels * bytesPerSample);
+    put16(wav, (unsigned)(channels * bytesPerSample));
+    put16(wav, format.bits);
+    wav.insert(wav.end(), { 'd', 'a', 't', 'a' });
+    put32(wav, dataBytes);
+    for (int i = 0; i < FRAMES; i++) {
+        for (int c = 0; c < channels; c++) {
+            putSample(wav, format, sourceValue(i, c));
+        }
+    }
+    return wav;
+}
+
+// One raw sample scaled as the original interpolate() did for its type
+double referenceSample(const char* data, const Format& format, int index)
+{
+    const unsigned char* src = (const unsigned char*)data + (size_t)index * (format.bits / 8);
+    if (format.tag == 3 && format.bits == 32) {
+        float v;
+        memcpy(&v, src, 4);
+        return v;
+    }
+    if (format.tag == 3) {
+        double v;
+        memcpy(&v, src, 8);
+        return v;
+    }
+    switch (format.bits) {
+        case 8:
+            return (src[0] - 128) * (1.0 / 128.0);
+        case 16: {
+            short v;
+            memcpy(&v, src, 2);
+            return v * (1.0 / 32768.0);
+        }
+        case 24: {
+            int v = (src[0] << 8) | (src[1] << 16) | (src[2] << 24);
+            return v * (1.0 / 2147483648.0);
+        }
+        default: {
+            int v;
+            memcpy(&v, src, 4);
+            return v * (1.0 / 2147483648.0);
+        }
+    }
+}
+
+// The per-sample path: linear interpolation in double, read straight from the file bytes
+void renderReference(const char* data, const Format& format, int channels, double time, double step,
+                     int count, float* out0, float* out1)
+{
+    for (int n = 0; n < count; n++, time += step) {
+        int frame = (int)time;
+        double alpha = time - frame;
+        double left = referenceSample(data, format, frame * channels);
+        double right = referenceSample(data, format, frame * channels + channels - 1);
+        if (alpha > 0.0) {
+            left += alpha * (referenceSample(data, format, (frame + 1) * channels) - left);
+            right += alpha * (referenceSample(data, format, (frame + 1) * channels + channels - 1) - right);
+        }
+        out0[n] += (float)(left * VOLUME);
+        out1[n] += (float)(right * VOLUME);
+    }
+}
+
+// Largest difference between the block kernel on a decoded store and the reference
+float compare(const Format& format, int channels, int store, double step)
+{
+    std::vector<char> wav = makeWav(format, channels);
+    MemoryDataSource source(wav.data(), (int)wav.size());
+    b3ReadWavFile reader;
+    CHECK(reader.getWavInfo(source));
+    CHECK(reader.getNumFrames() == FRAMES);
+
+    std::vector<char> decoded(reader.getDecodedSize(store));
+    CHECK(reader.decode(source, decoded.data(), store));
+    reader.setDecodedFrames(decoded.data(), store);
+
+    const char* data = wav.data() + 44;
+    double end = FRAMES - 2;
+    std::vector<float> out0(BLOCK), out1(BLOCK), ref0(BLOCK), ref1(BLOCK);
+    double time = 0.25;
+    float worst = 0.0f;
+    while (time + step * BLOCK < end) {
+        std::fill(out0.begin(), out0.end(), 0.0f);
+        std::fill(out1.begin(), out1.end(), 0.0f);
+        std::fill(ref0.begin(), ref0.end(), 0.0f);
+        std::fill(ref1.begin(), ref1.end(), 0.0f);
+        renderReference(data, format, channels, time, step, BLOCK, ref0.data(), ref1.data());
+        reader.render(time, step, 0.0, end, B3_WINDOW_NONE, B3_INTERP_LINEAR, VOLUME,
+                      out0.data(), out1.data(), BLOCK);
+        for (int i = 0; i < BLOCK; i++) {
+            worst = fmaxf(worst, fabsf(out0[i] - ref0[i]));
+            worst = fmaxf(worst, fabsf(out1[i] - ref1[i]));
+        }
+    }
+    return worst;
+}
+
+}  // namespace
+
+int main()
+{
+    for (const Format& format : FORMATS) {
+        for (int channels = 1; channels <= 2; channels++) {
+            for (double step : { 1.0, 1.37, 0.61 }) {
+                // float32 store: the same signal up to float rounding
+                float error = compare(format, channels, B3_DECODED_FLOAT32, step);
+                if (!(error < 2e-6f)) {
+                    printf("  %s %d ch step %.2f float32: max error %g\n", format.name, channels, step, error);
+                }
+                CHECK(error < 2e-6f);
+
+                // int16 store: exact for 8 and 16 bit sources, within one int16 step otherwise
+                error = compare(format, channels, B3_DECODED_INT16, step);
+                float allowed = (format.tag == 1 && format.bits <= 16) ? 2e-6f : 1.0f / 32768.0f;
+                if (!(error < allowed)) {
+                    printf("  %s %d ch step %.2f int16: max error %g\n", format.name, channels, step, error);
+                }
+                CHECK(error < allowed);
+            }
+        }
+    }
+    return testResult("test_decode_formats");
+}
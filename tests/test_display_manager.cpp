@@ -0,0 +1,152 @@
+/**
+ * test_display_manager - DisplayManager frames through the FramebufferBackend
+ *
+ * Draws text, the progress bar and a toast the way the menus and the loader
+ * do, and checks the presented frames pixel by pixel (where the overlay goes,
+ * what it covers and what comes back when the toast expires), then the PBM
+ * encoding of the last one. Needs libDaisy's graphics header and fonts.
+ */
+
+#include "DisplayManager.h"
+#include "FramebufferBackend.h"
+#include "HostTest.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const int WIDTH = Constants::Display::WIDTH;
+const int HEIGHT = Constants::Display::HEIGHT;
+const int BAR_Y = HEIGHT - Constants::Display::PROGRESS_BAR_HEIGHT;
+
+// Lit pixels in the rectangle [x0, x1) x [y0, y1) of the last presented frame
+int litPixels(const FramebufferBackend& backend, int x0, int y0, int x1, int y1)
+{
+    int count = 0;
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            count += backend.getPixel(x, y) ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+// A frame as a menu draws it: a line of text and a marker pixel mid-screen
+void drawMenuFrame(DisplayManager& display)
+{
+    display.clear();
+    display.setCursor(0, 0);
+    display.writeString("Hi", Font_7x10);
+    display.getDisplay().DrawPixel(100, 30, true);
+    display.update();
+}
+
+void testText()
+{
+    FramebufferBackend backend;
+    DisplayManager display(backend);
+    drawMenuFrame(display);
+    CHECK(backend.getFrameCount() == 1);
+
+    // Two 7x10 glyphs from the top-left, nothing else but the marker
+    int text = litPixels(backend, 0, 0, 14, 10);
+    CHECK(text > 0);
+    CHECK(litPixels(backend, 0, 0, WIDTH, HEIGHT) == text + 1);
+    CHECK(backend.getPixel(100, 30));
+}
+
+void testProgressBar()
+{
+    FramebufferBackend backend;
+    DisplayManager display(backend);
+    display.showProgress("Load", 50);
+    drawMenuFrame(display);
+
+    // Outline along the bottom edge, filled (inside a one-pixel gap) to half way
+    CHECK(backend.getPixel(0, BAR_Y));
+    CHECK(backend.getPixel(WIDTH - 1, BAR_Y));
+    CHECK(backend.getPixel(0, HEIGHT - 1));
+    CHECK(backend.getPixel(WIDTH - 1, HEIGHT - 1));
+    CHECK(!backend.getPixel(1, BAR_Y + 1));
+    CHECK(backend.getPixel(2, BAR_Y + 2));
+    CHECK(backend.getPixel(WIDTH / 4, BAR_Y + 3));
+    CHECK(!backend.getPixel(WIDTH * 3 / 4, BAR_Y + 3));
+
+    // Label just above the bar; the frame above that is untouched
+    CHECK(litPixels(backend, 0, BAR_Y - 9, 4 * 6, BAR_Y - 1) > 0);
+    CHECK(litPixels(backend, 4 * 6, BAR_Y - 10, WIDTH, BAR_Y) == 0);
+    CHECK(backend.getPixel(100, 30));
+    CHECK(litPixels(backend, 0, 0, 14, 10) > 0);
+
+    // Gone again with the next frame
+    display.hideProgress();
+    drawMenuFrame(display);
+    CHECK(litPixels(backend, 0, BAR_Y - 10, WIDTH, HEIGHT) == 0);
+}
+
+void testToast()
+{
+    FramebufferBackend backend;
+    DisplayManager display(backend);
+    drawMenuFrame(display);
+    int text = litPixels(backend, 0, 0, WIDTH, HEIGHT);
+
+    // Shown at the next service, over the whole screen and under the progress bar
+    display.showMessage("Saved*OK", 100);
+    display.showProgress(nullptr, 100);
+    CHECK(!display.isShowingMessage());
+    CHECK(display.serviceOverlay(1000));
+    CHECK(display.isShowingMessage());
+    drawMenuFrame(display);
+    CHECK(!backend.getPixel(100, 30));
+    CHECK(litPixels(backend, 0, 0, 5 * 7, 10) > 0);
+    CHECK(litPixels(backend, 0, Constants::Display::LINE_HEIGHT, 2 * 7, Constants::Display::LINE_HEIGHT + 10) > 0);
+    CHECK(backend.getPixel(WIDTH / 2, BAR_Y + 3));
+
+    // Expires after its duration and the menu's frame comes back
+    CHECK(!display.serviceOverlay(1099));
+    CHECK(display.isShowingMessage());
+    CHECK(display.serviceOverlay(1100));
+    CHECK(!display.isShowingMessage());
+    display.hideProgress();
+    drawMenuFrame(display);
+    CHECK(litPixels(backend, 0, 0, WIDTH, HEIGHT) == text);
+    CHECK(backend.getFrameCount() == 3);
+}
+
+void testPbm()
+{
+    FramebufferBackend backend;
+    DisplayManager display(backend);
+    display.showProgress("Load", 50);
+    drawMenuFrame(display);
+
+    uint8_t pbm[FramebufferBackend::PBM_SIZE + 1];
+    CHECK(backend.encodePbm(pbm, FramebufferBackend::PBM_SIZE - 1) == 0);
+    CHECK(backend.encodePbm(pbm, sizeof(pbm)) == 1034);
+    CHECK(memcmp(pbm, "P4\n128 64\n", 10) == 0);
+
+    // Rows of 16 bytes, most significant bit first; lit pixels are white (0)
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            bool black = (pbm[10 + y * (WIDTH / 8) + x / 8] >> (7 - (x & 7))) & 1;
+            if (black == backend.getPixel(x, y)) {
+                fprintf(stderr, "pixel %d,%d differs in the PBM\n", x, y);
+                CHECK(false);
+                return;
+            }
+        }
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    testText();
+    testProgressBar();
+    testToast();
+    testPbm();
+    return testResult("test_display_manager");
+}
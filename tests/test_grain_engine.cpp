@@ -0,0 +1,243 @@
+/**
+ * test_grain_engine - GrainEngine behaviour that does not need the Daisy
+ *
+ * Onsets: a grain spawned at a frame offset starts on exactly that output
+ * frame, including offsets past the end of the block it was spawned for.
+ *
+ * Grain budget: voices take their share of the CPU budget back from the
+ * grains (drums beat grains). Pending grains over budget are dropped, live
+ * ones fade out without a click, and spawning stops at the budget.
+ */
+
+#include "GrainEngine.h"
+#include "VoicePool.h"
+#include "b3ReadWavFile.h"
+#include "HostTest.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const int FRAMES = 48000;
+const int BLOCK = 48;
+
+struct Source {
+    std::vector<float> frames;
+    Source() : frames(FRAMES + B3_DECODED_GUARD_FRAMES, 0.25f) {}
+};
+
+const int RELEASE_BLOCKS = Constants::SampleLibrary::GRAIN_RELEASE_FRAMES / BLOCK + 1;
+
+bool spawnGrain(GrainEngine& engine, const Source& source, int length, int offset = 0, int window = WINDOW_HANN)
+{
+    return engine.spawn(0, source.frames.data(), 1, 0, 0.0, (double)length, 1.0, window, offset);
+}
+
+void renderBlock(GrainEngine& engine)
+{
+    float out0[BLOCK] = {};
+    float out1[BLOCK] = {};
+    engine.render(1.0f, out0, out1, BLOCK);
+}
+
+const int RENDER_BLOCKS = 12;
+const int GRAIN_LENGTH = 200;
+
+// Render RENDER_BLOCKS blocks of the grains spawned before the first one
+std::vector<float> renderGrains(const Source& source, const int* offsets, int count)
+{
+    GrainEngine engine;
+    engine.init(B3_DECODED_FLOAT32);
+    for (int i = 0; i < count; i++) {
+        CHECK(spawnGrain(engine, source, GRAIN_LENGTH, offsets[i]));
+    }
+    std::vector<float> out(BLOCK * RENDER_BLOCKS, 0.0f);
+    std::vector<float> right(BLOCK * RENDER_BLOCKS, 0.0f);
+    for (int b = 0; b < RENDER_BLOCKS; b++) {
+        engine.render(1.0f, &out[b * BLOCK], &right[b * BLOCK], BLOCK);
+    }
+    return out;
+}
+
+int firstNonZero(const std::vector<float>& out)
+{
+    for (size_t i = 0; i < out.size(); i++) {
+        if (out[i] != 0.0f) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void testOnsets()
+{
+    Source source;
+    const int zero = 0;
+    std::vector<float> reference = renderGrains(source, &zero, 1);
+    int referenceOnset = firstNonZero(reference);
+    CHECK(referenceOnset >= 0);
+
+    // One grain at a time: the same output, shifted by exactly the offset
+    static const int OFFSETS[] = { 1, 5, 17, BLOCK - 1, BLOCK, BLOCK + 3, 2 * BLOCK + 7, 5 * BLOCK };
+    for (int offset : OFFSETS) {
+        std::vector<float> out = renderGrains(source, &offset, 1);
+        CHECK(firstNonZero(out) == referenceOnset + offset);
+        bool same = true;
+        for (size_t i = 0; i < out.size(); i++) {
+            float expected = (i >= (size_t)offset) ? reference[i - offset] : 0.0f;
+            same = same && (out[i] == expected);
+        }
+        CHECK(same);
+    }
+
+    // Several in one block: the sum of the shifted single grains
+    static const int MIXED[] = { 0, 3, 11, 30, 47, 52, 130 };
+    const int mixedCount = sizeof(MIXED) / sizeof(MIXED[0]);
+    std::vector<float> out = renderGrains(source, MIXED, mixedCount);
+    float worst = 0.0f;
+    for (size_t i = 0; i < out.size(); i++) {
+        float expected = 0.0f;
+        for (int g = 0; g < mixedCount; g++) {
+            if (i >= (size_t)MIXED[g]) {
+                expected += reference[i - MIXED[g]];
+            }
+        }
+        worst = fmaxf(worst, fabsf(out[i] - expected));
+    }
+    CHECK(worst < 1e-6f);
+}
+
+void testBudgetFromVoices()
+{
+    VoicePool pool;
+    GrainEngine engine;
+    engine.init(B3_DECODED_FLOAT32);
+    Source source;
+
+    // An idle pool leaves room for every grain
+    CHECK(pool.getGrainBudget() >= GrainEngine::MAX_GRAINS);
+    engine.setBudget(pool.getGrainBudget());
+    int spawned = 0;
+    while (spawnGrain(engine, source, 4800 + spawned * 10)) {
+        spawned++;
+    }
+    CHECK(spawned == GrainEngine::MAX_GRAINS);
+    renderBlock(engine);
+
+    // Each voice takes GRAINS_PER_VOICE back; the grains nearest their end go
+    int voices = 10;
+    for (int i = 0; i < voices; i++) {
+        CHECK(pool.allocate(VOICE_PRIORITY_TRACK) >= 0);
+    }
+    int budget = (pool.getVoiceLimit() - voices) * Constants::Voices::GRAINS_PER_VOICE;
+    CHECK(pool.getGrainBudget() == budget);
+    engine.setBudget(pool.getGrainBudget());
+    CHECK(engine.getShedCount() == (uint32_t)(GrainEngine::MAX_GRAINS - budget));
+    CHECK(!spawnGrain(engine, source, 4800));
+    for (int b = 0; b < RELEASE_BLOCKS; b++) {
+        renderBlock(engine);
+    }
+    CHECK(engine.getActiveCount() == budget);
+
+    // Setting the same budget again releases nothing more
+    engine.setBudget(pool.getGrainBudget());
+    CHECK(engine.getShedCount() == (uint32_t)(GrainEngine::MAX_GRAINS - budget));
+
+    // A full pool leaves nothing; released voices give the budget back
+    while (pool.allocate(VOICE_PRIORITY_SAMPLE) >= 0) {
+    }
+    engine.setBudget(pool.getGrainBudget());
+    for (int b = 0; b < RELEASE_BLOCKS; b++) {
+        renderBlock(engine);
+    }
+    CHECK(engine.getActiveCount() == 0);
+    for (int i = pool.firstActive(); i >= 0; ) {
+        int next = pool.nextActive(i);
+        pool.release(i);
+        i = next;
+    }
+    engine.setBudget(pool.getGrainBudget());
+    CHECK(spawnGrain(engine, source, 4800));
+}
+
+void testPendingShedFirst()
+{
+    GrainEngine engine;
+    engine.init(B3_DECODED_FLOAT32);
+    Source source;
+
+    for (int i = 0; i < 8; i++) {
+        CHECK(spawnGrain(engine, source, 4800));
+    }
+    renderBlock(engine);
+
+    // Four more waiting for the next block: they go before any live grain
+    for (int i = 0; i < 4; i++) {
+        CHECK(spawnGrain(engine, source, 100, i));
+    }
+    engine.setBudget(8);
+    CHECK(engine.getActiveCount() == 8);
+    CHECK(engine.getShedCount() == 4);
+
+    // Live ones nearest their end go next
+    CHECK(spawnGrain(engine, source, 4800 * 3) == false);
+    engine.setBudget(9);
+    CHECK(spawnGrain(engine, source, 4800 * 3));
+    renderBlock(engine);
+    engine.setBudget(1);
+    for (int b = 0; b < RELEASE_BLOCKS; b++) {
+        renderBlock(engine);
+    }
+    CHECK(engine.getActiveCount() == 1);
+    for (int b = 0; b < 4800 / BLOCK + 1; b++) {
+        renderBlock(engine);
+    }
+    CHECK(engine.getActiveCount() == 1);   // The longest one is still playing
+}
+
+void testShedFadesOut()
+{
+    GrainEngine engine;
+    engine.init(B3_DECODED_FLOAT32);
+    Source source;
+
+    // A flat-topped grain at full level on a constant source
+    CHECK(spawnGrain(engine, source, 4800, 0, WINDOW_TUKEY));
+    std::vector<float> out0(BLOCK * 60, 0.0f);
+    std::vector<float> out1(BLOCK * 60, 0.0f);
+    int cutBlock = 40;
+    for (int b = 0; b < 60; b++) {
+        if (b == cutBlock) {
+            engine.setBudget(0);
+        }
+        engine.render(1.0f, &out0[b * BLOCK], &out1[b * BLOCK], BLOCK);
+    }
+    CHECK(out0[cutBlock * BLOCK - 1] > 0.2f);
+
+    // Falls to zero over GRAIN_RELEASE_FRAMES in small steps, then stays there
+    float largestStep = 0.0f;
+    for (int i = cutBlock * BLOCK; i < (int)out0.size(); i++) {
+        largestStep = fmaxf(largestStep, fabsf(out0[i] - out0[i - 1]));
+    }
+    CHECK(largestStep < 0.25f * 2.0f / Constants::SampleLibrary::GRAIN_RELEASE_FRAMES);
+    int silentFrom = cutBlock * BLOCK + Constants::SampleLibrary::GRAIN_RELEASE_FRAMES;
+    CHECK(out0[silentFrom - Constants::SampleLibrary::GRAIN_RELEASE_FRAMES / 2] > 0.05f);
+    CHECK(fabsf(out0[silentFrom - 1]) < 0.01f);
+    for (int i = silentFrom; i < (int)out0.size(); i++) {
+        CHECK(out0[i] == 0.0f);
+    }
+    CHECK(engine.getActiveCount() == 0);
+}
+
+}  // namespace
+
+int main()
+{
+    GrainWindow::init();
+    testOnsets();
+    testBudgetFromVoices();
+    testPendingShedFirst();
+    testShedFadesOut();
+    return testResult("test_grain_engine");
+}
@@ -0,0 +1,172 @@
+/**
+ * test_mip_levels - Octave levels for fast playback
+ *
+ * Builds the 1/2, 1/4 and 1/8 rate levels of a sine the way the loader does
+ * (each filtered from the one above by the 2:1 halfband, in loader-sized
+ * chunks) and plays it at steps of 2 and 4 through the level mipLevelForStep()
+ * picks. A tone above that step's Nyquist frequency must be gone rather than
+ * folded back into the band, while one below it passes at unity gain.
+ */
+
+#include "b3ReadWavFile.h"
+#include "SampleRateConverter.h"
+#include "Constants.h"
+#include "HostTest.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// The converter's table comes from the SDRAM pool on the Daisy
+void* custom_pool_allocate(size_t size)
+{
+    return malloc(size);
+}
+
+void custom_pool_free(void* ptr)
+{
+    free(ptr);
+}
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+const double AMPLITUDE = 0.5;
+const int RATE = 48000;
+const int FRAMES = 65536;
+const int BLOCK = 48;
+
+double toDb(double ratio)
+{
+    return 20.0 * log10(ratio);
+}
+
+// Decoded frames (float32, mono) with the guard frames the render kernels read past the end
+std::vector<float> withGuard(const std::vector<float>& frames)
+{
+    std::vector<float> level(frames);
+    level.resize(frames.size() + B3_DECODED_GUARD_FRAMES, 0.0f);
+    return level;
+}
+
+// Halve a level as SampleLibrary::buildMipChunk() does
+std::vector<float> halve(const std::vector<float>& input, int inFrames)
+{
+    SampleRateConverter converter;
+    CHECK(converter.init(2, 1));
+    uint32_t outFrames = SampleRateConverter::outputFrames(inFrames, 2, 1);
+    std::vector<float> output(outFrames);
+    std::vector<float> window;
+    const int chunk = Constants::SampleLibrary::SRC_CHUNK_FRAMES;
+    for (uint32_t first = 0; first < outFrames; first += chunk) {
+        int count = (outFrames - first < (uint32_t)chunk) ? (int)(outFrames - first) : chunk;
+        int64_t from;
+        int64_t to;
+        converter.inputRange(first, count, from, to);
+        window.assign((size_t)(to - from + 1), 0.0f);
+        for (int64_t i = from; i <= to; i++) {
+            if (i >= 0 && i < inFrames) {
+                window[(size_t)(i - from)] = input[(size_t)i];
+            }
+        }
+        converter.process(window.data(), from, 1, first, count, &output[first]);
+    }
+    return output;
+}
+
+// Play a sine of frequency Hz at step through the level picked for it (or level 0
+// when mipmapped is false) and return the amplitude of the output at heard Hz
+double playedAmplitude(double frequency, double step, bool mipmapped, double heard)
+{
+    std::vector<float> source(FRAMES);
+    for (int i = 0; i < FRAMES; i++) {
+        source[i] = (float)(AMPLITUDE * sin(2.0 * PI * frequency * i / RATE));
+    }
+    std::vector<std::vector<float>> levels;
+    levels.push_back(withGuard(source));
+    std::vector<float> previous = source;
+    for (int level = 1; level < B3_MAX_MIP_LEVELS; level++) {
+        previous = halve(previous, (int)previous.size());
+        levels.push_back(withGuard(previous));
+    }
+    const void* data[B3_MAX_MIP_LEVELS];
+    for (int level = 0; level < B3_MAX_MIP_LEVELS; level++) {
+        data[level] = levels[level].data();
+    }
+
+    b3ReadWavFile wav;
+    wav.setStoredFrames(FRAMES, 1, RATE, B3_DECODED_FLOAT32, 0);
+    wav.setDecodedFrames(data[0], B3_DECODED_FLOAT32);
+    wav.setMipLevels(data, B3_MAX_MIP_LEVELS);
+
+    // Same arithmetic as the grain spawn: positions scale by the level's power of two
+    int level = mipmapped ? b3ReadWavFile::mipLevelForStep(step, wav.getMipLevels()) : 0;
+    double scale = (double)(1 << level);
+    double end = (FRAMES - 1) / scale;
+    double time = 0.0;
+    int outFrames = (int)((FRAMES - 1) / step) / BLOCK * BLOCK;
+    std::vector<float> out0(outFrames, 0.0f);
+    std::vector<float> out1(outFrames, 0.0f);
+    for (int first = 0; first < outFrames; first += BLOCK) {
+        wav.render(data[level], time, step / scale, 0.0, end, B3_WINDOW_NONE, B3_INTERP_LINEAR, 1.0f,
+                   &out0[first], &out1[first], BLOCK);
+    }
+
+    // Away from the ends, where the halfband reads the zeros outside the sample
+    const int skip = 4 * SampleRateConverter::TAPS;
+    double w = 2.0 * PI * heard / RATE;
+    double sinSum = 0.0;
+    double cosSum = 0.0;
+    int count = 0;
+    for (int n = skip; n + skip < outFrames; n++) {
+        sinSum += out0[n] * sin(w * n);
+        cosSum += out0[n] * cos(w * n);
+        count++;
+    }
+    return 2.0 * sqrt(sinSum * sinSum + cosSum * cosSum) / count;
+}
+
+// Where a tone played at step lands at the output rate (folded about its Nyquist)
+double foldedFrequency(double frequency, double step)
+{
+    double played = fmod(frequency * step, (double)RATE);
+    return (played > RATE / 2) ? RATE - played : played;
+}
+
+void testLevelForStep()
+{
+    CHECK(b3ReadWavFile::mipLevelForStep(1.0, B3_MAX_MIP_LEVELS) == 0);
+    CHECK(b3ReadWavFile::mipLevelForStep(1.99, B3_MAX_MIP_LEVELS) == 0);
+    CHECK(b3ReadWavFile::mipLevelForStep(2.0, B3_MAX_MIP_LEVELS) == 1);
+    CHECK(b3ReadWavFile::mipLevelForStep(4.0, B3_MAX_MIP_LEVELS) == 2);
+    CHECK(b3ReadWavFile::mipLevelForStep(16.0, B3_MAX_MIP_LEVELS) == 3);
+    CHECK(b3ReadWavFile::mipLevelForStep(4.0, 1) == 0);
+}
+
+void testStep(double step, double above, double below)
+{
+    // Above the new Nyquist (RATE / 2 / step): without the level it folds back loudly
+    double heard = foldedFrequency(above, step);
+    double plain = toDb(playedAmplitude(above, step, false, heard) / AMPLITUDE);
+    double filtered = toDb(playedAmplitude(above, step, true, heard) / AMPLITUDE);
+    printf("  step %.0f, %5.0f Hz -> %5.0f Hz: alias %.1f dB unfiltered, %.1f dB from the level\n",
+           step, above, heard, plain, filtered);
+    CHECK(plain > -10.0);
+    CHECK(filtered < -60.0);
+
+    // Below it: the level keeps the tone
+    double gain = toDb(playedAmplitude(below, step, true, below * step) / AMPLITUDE);
+    printf("  step %.0f, %5.0f Hz -> %5.0f Hz: gain %+.4f dB\n", step, below, below * step, gain);
+    CHECK(fabs(gain) < 0.05);
+}
+
+}  // namespace
+
+int main()
+{
+    testLevelForStep();
+    testStep(2.0, 15000.0, 3000.0);
+    testStep(4.0, 9000.0, 1500.0);
+    return testResult("test_mip_levels");
+}
@@ -0,0 +1,222 @@
+/**
+ * test_oled_page_writer - OledPageWriter against a fake SPI transport
+ *
+ * The fake keeps its own copy of the panel RAM. It applies each data
+ * transfer to the column/page window set by the commands before it. It
+ * stays busy one microsecond per byte (8 MHz SPI). The tests check which
+ * page runs go out, what happens to a frame requested while another is in
+ * flight, and the full resend after a transfer fails to start. The panel
+ * must always end up showing what was drawn.
+ */
+
+#include "OledPageWriter.h"
+#include "HostTest.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const int WIDTH = OledPageWriter::WIDTH;
+const int PAGES = OledPageWriter::PAGES;
+
+uint32_t nowUs = 0;
+
+struct Run {
+    int firstPage;
+    int lastPage;
+};
+
+class FakeSpi : public OledTransport {
+public:
+    uint8_t panel[OledPageWriter::BUFFER_SIZE];
+    std::vector<Run> runs;
+    bool failNext;
+    bool commandWhileBusy;
+
+    FakeSpi()
+        : failNext(false)
+        , commandWhileBusy(false)
+        , busyUntil_(0)
+        , firstColumn_(0)
+        , lastColumn_(WIDTH - 1)
+        , firstPage_(0)
+        , lastPage_(PAGES - 1)
+    {
+        memset(panel, 0, sizeof(panel));
+    }
+
+    void sendCommands(const uint8_t* commands, size_t size) override
+    {
+        commandWhileBusy = commandWhileBusy || isBusy();
+        // Column (0x21) and page (0x22) address windows
+        for (size_t i = 0; i + 2 < size; i++) {
+            if (commands[i] == 0x21) {
+                firstColumn_ = commands[i + 1];
+                lastColumn_ = commands[i + 2];
+                i += 2;
+            } else if (commands[i] == 0x22) {
+                firstPage_ = commands[i + 1];
+                lastPage_ = commands[i + 2];
+                i += 2;
+            }
+        }
+        busyUntil_ = nowUs + (uint32_t)size;
+    }
+
+    bool startData(const uint8_t* data, size_t size) override
+    {
+        if (failNext) {
+            failNext = false;
+            return false;
+        }
+        int columns = lastColumn_ - firstColumn_ + 1;
+        CHECK(size == (size_t)columns * (lastPage_ - firstPage_ + 1));
+        for (size_t i = 0; i < size; i++) {
+            int page = firstPage_ + (int)(i / columns);
+            int column = firstColumn_ + (int)(i % columns);
+            panel[page * WIDTH + column] = data[i];
+        }
+        runs.push_back({ firstPage_, lastPage_ });
+        busyUntil_ = nowUs + (uint32_t)size;
+        return true;
+    }
+
+    bool isBusy() const override { return nowUs < busyUntil_; }
+
+private:
+    uint32_t busyUntil_;
+    int firstColumn_;
+    int lastColumn_;
+    int firstPage_;
+    int lastPage_;
+};
+
+// Call service() from a "main loop" every 50 us until the writer is idle
+void drain(OledPageWriter& writer)
+{
+    while (writer.service(nowUs)) {
+        nowUs += 50;
+    }
+}
+
+bool panelShows(const FakeSpi& spi, const uint8_t* expected)
+{
+    return memcmp(spi.panel, expected, OledPageWriter::BUFFER_SIZE) == 0;
+}
+
+// What the writer's buffer should hold, drawn the same way on a plain array
+struct Picture {
+    uint8_t bytes[OledPageWriter::BUFFER_SIZE];
+    Picture() { memset(bytes, 0, sizeof(bytes)); }
+    void set(OledPageWriter& writer, int x, int y)
+    {
+        writer.drawPixel(x, y, true);
+        bytes[x + (y / 8) * WIDTH] |= (uint8_t)(1 << (y & 7));
+    }
+};
+
+void testRuns()
+{
+    static uint8_t shadow[OledPageWriter::BUFFER_SIZE];
+    FakeSpi spi;
+    OledPageWriter writer;
+    writer.init(&spi, shadow);
+    Picture picture;
+
+    // First frame: the panel is unknown, so all pages go in one run
+    picture.set(writer, 5, 3);
+    writer.update(nowUs);
+    drain(writer);
+    CHECK(spi.runs.size() == 1);
+    CHECK(spi.runs[0].firstPage == 0 && spi.runs[0].lastPage == PAGES - 1);
+    CHECK(writer.getStats().lastPages == (uint32_t)PAGES);
+    CHECK(panelShows(spi, picture.bytes));
+
+    // Redrawing the same picture sends nothing
+    writer.fill(false);
+    writer.drawPixel(5, 3, true);
+    writer.update(nowUs);
+    drain(writer);
+    CHECK(spi.runs.size() == 1);
+    CHECK(writer.getStats().unchanged == 1);
+
+    // Pages 2, 3 and 6 changed: adjacent pages share a run
+    spi.runs.clear();
+    picture.set(writer, 10, 20);
+    picture.set(writer, 90, 30);
+    picture.set(writer, 10, 50);
+    writer.update(nowUs);
+    drain(writer);
+    CHECK(spi.runs.size() == 2);
+    CHECK(spi.runs.size() == 2 && spi.runs[0].firstPage == 2 && spi.runs[0].lastPage == 3);
+    CHECK(spi.runs.size() == 2 && spi.runs[1].firstPage == 6 && spi.runs[1].lastPage == 6);
+    CHECK(writer.getStats().lastPages == 3);
+    CHECK(panelShows(spi, picture.bytes));
+    CHECK(!spi.commandWhileBusy);
+}
+
+void testUpdateWhileInFlight()
+{
+    static uint8_t shadow[OledPageWriter::BUFFER_SIZE];
+    FakeSpi spi;
+    OledPageWriter writer;
+    writer.init(&spi, shadow);
+    Picture picture;
+    writer.update(nowUs);
+    drain(writer);
+    spi.runs.clear();
+
+    // Frame A (pages 1 and 4) starts; frame B (page 7) is requested before A is out
+    picture.set(writer, 0, 8);
+    picture.set(writer, 0, 32);
+    writer.update(nowUs);
+    CHECK(writer.isBusy());
+    picture.set(writer, 0, 60);
+    writer.update(nowUs);
+    CHECK(spi.runs.size() == 1);   // Nothing more starts while the bus is busy
+
+    drain(writer);
+    CHECK(spi.runs.size() == 3);
+    CHECK(spi.runs.size() == 3 && spi.runs[0].firstPage == 1 && spi.runs[1].firstPage == 4);
+    CHECK(spi.runs.size() == 3 && spi.runs[2].firstPage == 7 && spi.runs[2].lastPage == 7);
+    CHECK(writer.getStats().lastPages == 1);
+    CHECK(panelShows(spi, picture.bytes));
+    CHECK(memcmp(spi.panel, shadow, sizeof(shadow)) == 0);
+    CHECK(!spi.commandWhileBusy);
+}
+
+void testFailedTransferResends()
+{
+    static uint8_t shadow[OledPageWriter::BUFFER_SIZE];
+    FakeSpi spi;
+    OledPageWriter writer;
+    writer.init(&spi, shadow);
+    Picture picture;
+    writer.update(nowUs);
+    drain(writer);
+    spi.runs.clear();
+
+    // The only changed page fails to start: the panel no longer matches the
+    // shadow, so the frame is dropped and every page is sent again
+    spi.failNext = true;
+    picture.set(writer, 0, 0);
+    writer.update(nowUs);
+    CHECK(spi.runs.empty());
+    CHECK(writer.isBusy());
+    drain(writer);
+    CHECK(spi.runs.size() == 1);
+    CHECK(writer.getStats().lastPages == (uint32_t)PAGES);
+    CHECK(!spi.runs.empty() && spi.runs.back().firstPage == 0 && spi.runs.back().lastPage == PAGES - 1);
+    CHECK(panelShows(spi, picture.bytes));
+}
+
+}  // namespace
+
+int main()
+{
+    testRuns();
+    testUpdateWhileInFlight();
+    testFailedTransferResends();
+    return testResult("test_oled_page_writer");
+}
@@ -0,0 +1,142 @@
+/**
+ * test_sample_rate_converter - Load-time resampler accuracy
+ *
+ * Converts sines from 44.1 kHz to 48 kHz in loader-sized chunks and checks
+ * them against the exact sine at each output position: passband gain and the
+ * error left over (images, aliasing and filter noise). Also converts tones
+ * above the lower Nyquist frequency from 48 kHz down to 44.1 kHz, which the
+ * filter must remove rather than fold back into the band.
+ */
+
+#include "SampleRateConverter.h"
+#include "Constants.h"
+#include "HostTest.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// The converter's table comes from the SDRAM pool on the Daisy
+void* custom_pool_allocate(size_t size)
+{
+    return malloc(size);
+}
+
+void custom_pool_free(void* ptr)
+{
+    free(ptr);
+}
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+const double AMPLITUDE = 0.5;
+
+double toDb(double ratio)
+{
+    return 20.0 * log10(ratio);
+}
+
+// Convert a mono sine of frequency Hz, chunk by chunk as the loader does
+std::vector<float> convertSine(int inRate, int outRate, double frequency, int inFrames)
+{
+    std::vector<float> input(inFrames);
+    for (int i = 0; i < inFrames; i++) {
+        input[i] = (float)(AMPLITUDE * sin(2.0 * PI * frequency * i / inRate));
+    }
+
+    SampleRateConverter converter;
+    CHECK(converter.init(inRate, outRate));
+    uint32_t outFrames = SampleRateConverter::outputFrames(inFrames, inRate, outRate);
+    std::vector<float> output(outFrames);
+    std::vector<float> window;
+    const int chunk = Constants::SampleLibrary::SRC_CHUNK_FRAMES;
+    for (uint32_t first = 0; first < outFrames; first += chunk) {
+        int count = (outFrames - first < (uint32_t)chunk) ? (int)(outFrames - first) : chunk;
+        int64_t from;
+        int64_t to;
+        converter.inputRange(first, count, from, to);
+        window.assign((size_t)(to - from + 1), 0.0f);
+        for (int64_t i = from; i <= to; i++) {
+            if (i >= 0 && i < inFrames) {
+                window[(size_t)(i - from)] = input[(size_t)i];
+            }
+        }
+        converter.process(window.data(), from, 1, first, count, &output[first]);
+    }
+    return output;
+}
+
+struct Accuracy {
+    double gainDb;    // Fitted amplitude against the input's
+    double errorDb;   // Whatever is not the sine, against the sine
+};
+
+// Compare away from the ends, where the filter reads the zeros outside the sample
+Accuracy measure(const std::vector<float>& output, int outRate, double frequency)
+{
+    const size_t skip = 4 * SampleRateConverter::TAPS;
+    double w = 2.0 * PI * frequency / outRate;
+    double sinSum = 0.0;
+    double cosSum = 0.0;
+    size_t count = 0;
+    for (size_t n = skip; n + skip < output.size(); n++) {
+        sinSum += output[n] * sin(w * n);
+        cosSum += output[n] * cos(w * n);
+        count++;
+    }
+    Accuracy accuracy;
+    accuracy.gainDb = toDb(2.0 * sqrt(sinSum * sinSum + cosSum * cosSum) / count / AMPLITUDE);
+
+    // Against the exact sine at each output frame's input position
+    double error = 0.0;
+    for (size_t n = skip; n + skip < output.size(); n++) {
+        double exact = AMPLITUDE * sin(w * n);
+        error += (output[n] - exact) * (output[n] - exact);
+    }
+    accuracy.errorDb = toDb(sqrt(error / count) / (AMPLITUDE / sqrt(2.0)));
+    return accuracy;
+}
+
+void testPassband()
+{
+    // Up to the passband edge (CUTOFF of the 22.05 kHz Nyquist)
+    static const double FREQUENCIES[] = { 100.0, 1000.0, 5000.0, 10000.0, 15000.0, 18000.0 };
+    for (double frequency : FREQUENCIES) {
+        std::vector<float> output = convertSine(44100, 48000, frequency, 44100);
+        Accuracy accuracy = measure(output, 48000, frequency);
+        printf("  44.1 -> 48 kHz, %5.0f Hz: gain %+.4f dB, error %.1f dB\n",
+               frequency, accuracy.gainDb, accuracy.errorDb);
+        CHECK(fabs(accuracy.gainDb) < 0.01);
+        CHECK(accuracy.errorDb < -70.0);
+    }
+}
+
+void testAliasRejection()
+{
+    // Between the two Nyquist frequencies: would fold back to 44100 - f
+    static const double FREQUENCIES[] = { 22500.0, 23000.0, 23500.0 };
+    for (double frequency : FREQUENCIES) {
+        std::vector<float> output = convertSine(48000, 44100, frequency, 48000);
+        const size_t skip = 4 * SampleRateConverter::TAPS;
+        double power = 0.0;
+        size_t count = 0;
+        for (size_t n = skip; n + skip < output.size(); n++) {
+            power += output[n] * output[n];
+            count++;
+        }
+        double levelDb = toDb(sqrt(power / count) / (AMPLITUDE / sqrt(2.0)));
+        printf("  48 -> 44.1 kHz, %5.0f Hz: alias %.1f dB\n", frequency, levelDb);
+        CHECK(levelDb < -70.0);
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    testPassband();
+    testAliasRejection();
+    return testResult("test_sample_rate_converter");
+}
@@ -0,0 +1,202 @@
+/**
+ * test_sdram_heap - SdramHeap on a plain host buffer
+ *
+ * Covers splitting and merging of free-list blocks, the slab size classes,
+ * 32-byte alignment and the stats, then a random allocate/free run checked
+ * against a shadow list (no overlap, contents intact, everything merges back).
+ */
+
+#include "SdramHeap.h"
+#include "HostTest.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const size_t REGION_SIZE = 1 << 20;
+
+bool aligned(const void* ptr)
+{
+    return ((uintptr_t)ptr % SdramHeap::ALIGNMENT) == 0;
+}
+
+void testAlignment(SdramHeap& heap)
+{
+    std::vector<void*> blocks;
+    for (size_t size = 1; size <= 3000; size += 37) {
+        void* ptr = heap.allocate(size);
+        CHECK(ptr != nullptr);
+        CHECK(aligned(ptr));
+        blocks.push_back(ptr);
+    }
+    for (void* ptr : blocks) {
+        heap.free(ptr);
+    }
+    CHECK(heap.getStats().allocationCount == 0);
+    CHECK(heap.getStats().usedBytes == 0);
+}
+
+void testSlabClasses(SdramHeap& heap)
+{
+    // Each class hands out slots of its own size from one shared page
+    size_t slot = SdramHeap::ALIGNMENT;
+    for (int sizeClass = 0; sizeClass < SdramHeap::NUM_SIZE_CLASSES; sizeClass++, slot <<= 1) {
+        char* a = (char*)heap.allocate(slot);
+        char* b = (char*)heap.allocate(slot - 1);
+        CHECK(a != nullptr && b != nullptr);
+        size_t distance = (a > b) ? (size_t)(a - b) : (size_t)(b - a);
+        CHECK(distance == slot);
+
+        // One page for both; freeing the last slot gives the page back
+        CHECK(heap.getStats().usedBytes > 0);
+        heap.free(a);
+        heap.free(b);
+        CHECK(heap.getStats().usedBytes == 0);
+    }
+
+    // A freed slot is reused before the page grows
+    void* first = heap.allocate(48);
+    void* second = heap.allocate(48);
+    heap.free(first);
+    void* again = heap.allocate(60);
+    CHECK(again == first);
+    heap.free(second);
+    heap.free(again);
+
+    // Above MAX_SLAB_SIZE goes to the free list (no page of slots)
+    SdramHeap::Stats before = heap.getStats();
+    void* big = heap.allocate(SdramHeap::MAX_SLAB_SIZE + 1);
+    SdramHeap::Stats after = heap.getStats();
+    CHECK(after.usedBytes - before.usedBytes < SdramHeap::SLAB_PAGE_SIZE);
+    heap.free(big);
+}
+
+void testSplitAndMerge(SdramHeap& heap)
+{
+    SdramHeap::Stats empty = heap.getStats();
+    CHECK(empty.freeBlockCount == 1);
+    CHECK(empty.freeBytes == empty.totalBytes);
+
+    void* a = heap.allocate(10000);
+    void* b = heap.allocate(20000);
+    void* c = heap.allocate(30000);
+    CHECK(heap.getStats().freeBlockCount == 1);   // Each allocation split the tail
+
+    // A hole in the middle
+    heap.free(b);
+    SdramHeap::Stats holed = heap.getStats();
+    CHECK(holed.freeBlockCount == 2);
+    CHECK(holed.fragmentationPercent() > 0);
+
+    // Best fit: a request that fits the hole goes there, not to the tail
+    void* d = heap.allocate(15000);
+    CHECK((char*)d > (char*)a && (char*)d < (char*)c);
+    heap.free(d);
+
+    // Freeing the neighbours merges everything back into one block
+    heap.free(a);
+    CHECK(heap.getStats().freeBlockCount == 2);
+    heap.free(c);
+    SdramHeap::Stats merged = heap.getStats();
+    CHECK(merged.freeBlockCount == 1);
+    CHECK(merged.freeBytes == merged.totalBytes);
+    CHECK(merged.fragmentationPercent() <= 1);   // Only the block header is not payload
+}
+
+void testStats(SdramHeap& heap, size_t regionSize)
+{
+    SdramHeap::Stats stats = heap.getStats();
+    CHECK(stats.totalBytes <= regionSize);
+    CHECK(stats.totalBytes + SdramHeap::ALIGNMENT * 2 > regionSize);
+
+    void* a = heap.allocate(100000);
+    size_t peak = heap.getStats().usedBytes;
+    CHECK(peak >= 100000);
+    heap.free(a);
+    stats = heap.getStats();
+    CHECK(stats.usedBytes == 0);
+    CHECK(stats.highWaterBytes >= peak);
+
+    // Too big: fails, counted, nothing changes
+    uint32_t failed = stats.failedAllocations;
+    CHECK(heap.allocate(regionSize) == nullptr);
+    CHECK(heap.getStats().failedAllocations == failed + 1);
+    CHECK(heap.getStats().freeBlockCount == 1);
+
+    // The largest free block can actually be allocated
+    size_t largest = heap.getStats().largestFreeBlock;
+    void* all = heap.allocate(largest);
+    CHECK(all != nullptr);
+    heap.free(all);
+    CHECK(heap.allocate(0) == nullptr);
+    heap.free(nullptr);
+}
+
+void testRandom(SdramHeap& heap)
+{
+    struct Live {
+        unsigned char* ptr;
+        size_t size;
+        unsigned char fill;
+    };
+    std::vector<Live> live;
+    srand(1234);
+    for (int step = 0; step < 20000; step++) {
+        bool doAllocate = live.empty() || (rand() % 100) < 55;
+        if (doAllocate) {
+            size_t size = (rand() % 4 == 0) ? 1 + rand() % 40000 : 1 + rand() % 600;
+            unsigned char* ptr = (unsigned char*)heap.allocate(size);
+            if (ptr == nullptr) {
+                continue;
+            }
+            CHECK(aligned(ptr));
+            for (const Live& other : live) {
+                CHECK(ptr + size <= other.ptr || other.ptr + other.size <= ptr);
+            }
+            unsigned char fill = (unsigned char)(step & 0xFF);
+            memset(ptr, fill, size);
+            live.push_back({ ptr, size, fill });
+        } else {
+            size_t index = rand() % live.size();
+            Live victim = live[index];
+            for (size_t i = 0; i < victim.size; i++) {
+                if (victim.ptr[i] != victim.fill) {
+                    CHECK(victim.ptr[i] == victim.fill);
+                    break;
+                }
+            }
+            heap.free(victim.ptr);
+            live[index] = live.back();
+            live.pop_back();
+        }
+        CHECK(heap.getStats().allocationCount == live.size());
+    }
+    for (const Live& block : live) {
+        heap.free(block.ptr);
+    }
+    SdramHeap::Stats stats = heap.getStats();
+    CHECK(stats.allocationCount == 0);
+    CHECK(stats.usedBytes == 0);
+    CHECK(stats.freeBlockCount == 1);
+    CHECK(stats.freeBytes == stats.totalBytes);
+}
+
+}  // namespace
+
+int main()
+{
+    // Start off the alignment boundary, as a linker-placed pool might
+    std::vector<char> region(REGION_SIZE + SdramHeap::ALIGNMENT);
+    SdramHeap heap;
+    heap.init(region.data() + 3, REGION_SIZE);
+
+    testAlignment(heap);
+    testSlabClasses(heap);
+    testSplitAndMerge(heap);
+    testStats(heap, REGION_SIZE);
+    testRandom(heap);
+    return testResult("test_sdram_heap");
+}
@@ -0,0 +1,59 @@
+/**
+ * test_sinc_interp - b3ReadWavFile's sinc tier at the edge of a frame
+ *
+ * A read position a hair below a whole frame (t = 10 - 1e-9) makes the
+ * fractional phase round up to the last table row. The kernel must then
+ * stay inside the polyphase table and land on the next frame. Built with
+ * AddressSanitizer (see Makefile), so a read past the table fails the run.
+ */
+
+#include "b3ReadWavFile.h"
+#include "HostTest.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const int FRAMES = 256;
+const int BLOCK = 32;
+
+float sourceValue(int frame)
+{
+    return 0.5f * sinf(0.05f * (float)frame);
+}
+
+void testPhaseRoundsUp(double time, double step)
+{
+    b3ReadWavFile wav;
+    wav.setStoredFrames(FRAMES, 1, 48000.0, B3_DECODED_FLOAT32, 0);
+    std::vector<float> frames(FRAMES + B3_DECODED_GUARD_FRAMES, 0.0f);
+    for (int i = 0; i < FRAMES; i++) {
+        frames[i] = sourceValue(i);
+    }
+    wav.setDecodedFrames(frames.data(), B3_DECODED_FLOAT32);
+
+    float out0[BLOCK] = {};
+    float out1[BLOCK] = {};
+    double start = time;
+    wav.render(time, step, 0.0, FRAMES - B3_DECODED_GUARD_FRAMES - 1, B3_WINDOW_NONE, B3_INTERP_SINC,
+               1.0f, out0, out1, BLOCK);
+
+    // Close to the band-limited signal; the first frame is all but on frame 10
+    CHECK(fabsf(out0[0] - sourceValue((int)ceil(start))) < 1e-3f);
+    for (int i = 0; i < BLOCK; i++) {
+        float expected = 0.5f * sinf(0.05f * (float)(start + i * step));
+        CHECK(std::isfinite(out0[i]));
+        CHECK(fabsf(out0[i] - expected) < 1e-2f);
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    testPhaseRoundsUp(10.0 - 1e-9, 1.0001);
+    testPhaseRoundsUp(10.0 - 1e-7, 1.0);
+    testPhaseRoundsUp(20.0 - 1e-12, 0.9999);
+    return testResult("test_sinc_interp");
+}
@@ -0,0 +1,146 @@
+/**
+ * test_step_clock - Sequencer step timing over an hour of audio
+ *
+ * Drives StepClock the way Sequencer::processAudio does (blocks split at step
+ * boundaries) and checks every step starts on the exact sample
+ * ceil(k * stepLength / increment): no drift after an hour, at integer and
+ * fractional tempos. Also covers tempo changes at a boundary and a restart
+ * requested between blocks.
+ */
+
+#include "StepClock.h"
+#include "HostTest.h"
+
+#include <cstdio>
+
+namespace {
+
+const int SAMPLE_RATE = 48000;
+const size_t BLOCK = 48;
+const uint64_t STEP_LENGTH = (uint64_t)SAMPLE_RATE * 60 * Constants::Sequencer::BPM_RESOLUTION;
+
+// Sample on which step k (counted from a restart) starts at a fixed tempo
+uint64_t expectedStepSample(uint64_t k, uint32_t increment)
+{
+    return (k * STEP_LENGTH + increment - 1) / increment;
+}
+
+// One block as processAudio renders it; calls onStep(sample) for each step start
+template <typename OnStep>
+void runBlock(StepClock& clock, uint64_t blockStart, size_t size, OnStep onStep)
+{
+    size_t offset = 0;
+    while (offset < size) {
+        if (clock.stepDue()) {
+            onStep(blockStart + offset);
+        }
+        size_t segment = clock.samplesUntilStep(size - offset);
+        clock.advance(segment);
+        offset += segment;
+    }
+}
+
+void testOneHour(float bpm)
+{
+    StepClock clock(SAMPLE_RATE);
+    clock.setTempo(bpm);
+    clock.requestRestart();
+    CHECK(clock.serviceRestart());
+
+    uint32_t increment = StepClock::incrementFor(bpm);
+    const uint64_t hour = (uint64_t)SAMPLE_RATE * 3600;
+    uint64_t steps = 0;
+    uint64_t mismatches = 0;
+    for (uint64_t sample = 0; sample < hour; sample += BLOCK) {
+        runBlock(clock, sample, BLOCK, [&](uint64_t at) {
+            steps++;
+            if (at != expectedStepSample(steps, increment)) {
+                mismatches++;
+            }
+        });
+    }
+
+    // Steps that started within the hour, counted exactly
+    uint64_t expectedSteps = ((hour - 1) * increment) / STEP_LENGTH;
+    CHECK(steps == expectedSteps);
+    CHECK(mismatches == 0);
+    printf("  %.2f BPM: %llu steps in one hour, %llu off their sample\n",
+           bpm, (unsigned long long)steps, (unsigned long long)mismatches);
+}
+
+void testTempoChangeAtBoundary()
+{
+    StepClock clock(SAMPLE_RATE);
+    clock.setTempo(120.0f);
+    clock.requestRestart();
+    clock.serviceRestart();
+
+    uint32_t slow = StepClock::incrementFor(120.0f);
+    uint32_t fast = StepClock::incrementFor(127.5f);
+    uint64_t firstStep = expectedStepSample(1, slow);
+
+    uint64_t seen[3] = { 0, 0, 0 };
+    int steps = 0;
+    uint64_t sample = 0;
+    // The new tempo is requested mid-step and must not shorten that step
+    for (; steps < 3; sample += BLOCK) {
+        if (sample == BLOCK * 10) {
+            clock.setTempo(127.5f);
+        }
+        runBlock(clock, sample, BLOCK, [&](uint64_t at) {
+            if (steps < 3) {
+                seen[steps] = at;
+            }
+            steps++;
+        });
+    }
+    CHECK(seen[0] == firstStep);
+
+    // 6000 samples per step at 120 BPM is exact, so the faster tempo counts
+    // from that boundary with no carried phase
+    CHECK(seen[1] == firstStep + expectedStepSample(1, fast));
+    CHECK(seen[2] == firstStep + expectedStepSample(2, fast));
+}
+
+void testRestartBetweenBlocks()
+{
+    StepClock clock(SAMPLE_RATE);
+    clock.setTempo(133.0f);
+    clock.requestRestart();
+    clock.serviceRestart();
+
+    uint32_t increment = StepClock::incrementFor(133.0f);
+    uint64_t sample = 0;
+    for (int block = 0; block < 77; block++, sample += BLOCK) {
+        runBlock(clock, sample, BLOCK, [](uint64_t) {});
+    }
+
+    // Requested by the main loop; nothing moves until the callback takes it
+    clock.requestRestart();
+    CHECK(clock.serviceRestart());
+    CHECK(!clock.serviceRestart());
+
+    uint64_t restartedAt = sample;
+    uint64_t firstStep = 0;
+    for (; firstStep == 0; sample += BLOCK) {
+        runBlock(clock, sample, BLOCK, [&](uint64_t at) {
+            if (firstStep == 0) {
+                firstStep = at;
+            }
+        });
+    }
+    CHECK(firstStep - restartedAt == expectedStepSample(1, increment));
+}
+
+}  // namespace
+
+int main()
+{
+    testOneHour(120.0f);
+    testOneHour(127.5f);
+    testOneHour(133.33f);
+    testOneHour(Constants::UI::MAX_BPM);
+    testTempoChangeAtBoundary();
+    testRestartBetweenBlocks();
+    return testResult("test_step_clock");
+}
@@ -0,0 +1,185 @@
+/**
+ * bankpack - Pack a folder of WAV files into a sample bank (see SampleBank.h)
+ *
+ * Runs on the host. Every WAV is decoded with the firmware's own reader, so
+ * the bank holds exactly the frames the sampler would have decoded at load.
+ * Copy the output to the root of the SD card as SAMPLES.BNK.
+ *
+ * Build (from the repository root, on a little-endian host):
+ *   g++ -O2 -std=c++14 -I. -o bankpack tools/bankpack.cpp b3ReadWavFile.cpp
+ *
+ * Usage:
+ *   bankpack [--int16] <wav folder> <output bank>
+ *
+ * --int16 stores 16-bit frames (half the size) and should match
+ * Constants::SampleLibrary::DECODE_TO_INT16; a bank in the other format still
+ * loads, but every sample is converted on the way in.
+ */
+
+#include "b3ReadWavFile.h"
+#include "SampleBank.h"
+#include "Constants.h"
+
+#include <dirent.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool isWavName(const std::string& name)
+{
+    if (name.size() < 4) {
+        return false;
+    }
+    std::string ext = name.substr(name.size() - 4);
+    return ext == ".wav" || ext == ".WAV";
+}
+
+bool readFile(const std::string& path, std::vector<char>& data)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data.resize(size > 0 ? (size_t)size : 0);
+    bool ok = size > 0 && fread(data.data(), 1, data.size(), file) == data.size();
+    fclose(file);
+    return ok;
+}
+
+// Pad the output with zeros up to the next SAMPLE_BANK_ALIGN boundary
+bool padToAlignment(FILE* out)
+{
+    static const char zeros[SAMPLE_BANK_ALIGN] = {};
+    long position = ftell(out);
+    size_t padding = (SAMPLE_BANK_ALIGN - (uint32_t)position % SAMPLE_BANK_ALIGN) % SAMPLE_BANK_ALIGN;
+    return fwrite(zeros, 1, padding, out) == padding;
+}
+
+int usage()
+{
+    fprintf(stderr, "usage: bankpack [--int16] <wav folder> <output bank>\n");
+    return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    int format = B3_DECODED_FLOAT32;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "--int16") == 0) {
+        format = B3_DECODED_INT16;
+        arg++;
+    }
+    if (argc - arg != 2) {
+        return usage();
+    }
+    std::string folder = argv[arg];
+    const char* outputPath = argv[arg + 1];
+
+    // Collect the WAVs in name order, so banks built from the same folder are identical
+    DIR* dir = opendir(folder.c_str());
+    if (dir == nullptr) {
+        fprintf(stderr, "bankpack: cannot open folder %s\n", folder.c_str());
+        return 1;
+    }
+    std::vector<std::string> names;
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (!isWavName(name)) {
+            continue;
+        }
+        if (name.size() >= (size_t)SAMPLE_BANK_NAME_SIZE) {
+            fprintf(stderr, "bankpack: skipping %s (name longer than %d characters)\n",
+                    name.c_str(), SAMPLE_BANK_NAME_SIZE - 1);
+            continue;
+        }
+        names.push_back(name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    if (names.size() > (size_t)Constants::SampleLibrary::MAX_SAMPLES) {
+        fprintf(stderr, "bankpack: only the first %d of %zu files fit\n",
+                Constants::SampleLibrary::MAX_SAMPLES, names.size());
+        names.resize(Constants::SampleLibrary::MAX_SAMPLES);
+    }
+
+    FILE* out = fopen(outputPath, "wb");
+    if (out == nullptr) {
+        fprintf(stderr, "bankpack: cannot create %s\n", outputPath);
+        return 1;
+    }
+
+    // Header and a placeholder index; the index is rewritten once the offsets are known
+    std::vector<SampleBankEntry> entries;
+    entries.reserve(names.size());
+    SampleBankHeader header = {};
+    header.magic = SAMPLE_BANK_MAGIC;
+    header.version = SAMPLE_BANK_VERSION;
+    header.format = (uint16_t)format;
+    header.indexOffset = sizeof(SampleBankHeader);
+    fwrite(&header, sizeof(header), 1, out);
+    std::vector<SampleBankEntry> placeholder(names.size());
+    fwrite(placeholder.data(), sizeof(SampleBankEntry), placeholder.size(), out);
+
+    std::vector<char> file;
+    std::vector<char> frames;
+    for (const std::string& name : names) {
+        std::string path = folder + "/" + name;
+        b3ReadWavFile reader;
+        if (!readFile(path, file)) {
+            fprintf(stderr, "bankpack: skipping %s (read failed)\n", name.c_str());
+            continue;
+        }
+        MemoryDataSource source(file.data(), (int)file.size());
+        if (!reader.getWavInfo(source)) {
+            fprintf(stderr, "bankpack: skipping %s (not a supported WAV)\n", name.c_str());
+            continue;
+        }
+        frames.resize(reader.getDecodedSize(format));
+        if (reader.getNumFrames() == 0 || !reader.decode(source, frames.data(), format)) {
+            fprintf(stderr, "bankpack: skipping %s (decode failed)\n", name.c_str());
+            continue;
+        }
+
+        // The firmware adds its own guard frames when it loads a sample
+        if (!padToAlignment(out)) {
+            break;
+        }
+        SampleBankEntry entry = {};
+        strncpy(entry.name, name.c_str(), SAMPLE_BANK_NAME_SIZE - 1);
+        entry.dataOffset = (uint32_t)ftell(out);
+        entry.numFrames = (uint32_t)reader.getNumFrames();
+        entry.channels = (uint16_t)reader.getChannels();
+        entry.bitsPerSample = (uint16_t)reader.getBitsPerSample();
+        entry.sampleRate = (uint32_t)reader.getFileDataRate();
+        size_t bytes = (size_t)entry.numFrames * reader.getDecodedFrameSize(format);
+        if (fwrite(frames.data(), 1, bytes, out) != bytes) {
+            break;
+        }
+        entries.push_back(entry);
+    }
+
+    // Final header and index (skipped files leave unused index slots at the end)
+    header.sampleCount = (uint32_t)entries.size();
+    bool ok = !ferror(out) && fseek(out, 0, SEEK_SET) == 0 &&
+              fwrite(&header, sizeof(header), 1, out) == 1 &&
+              fwrite(entries.data(), sizeof(SampleBankEntry), entries.size(), out) == entries.size();
+    long size = (fseek(out, 0, SEEK_END) == 0) ? ftell(out) : 0;
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "bankpack: write to %s failed\n", outputPath);
+        return 1;
+    }
+
+    printf("%s: %zu samples, %s, %.1f MB\n", outputPath, entries.size(),
+           (format == B3_DECODED_INT16) ? "int16" : "float32", size / (1024.0 * 1024.0));
+    return 0;
+}